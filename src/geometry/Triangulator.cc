@@ -36,6 +36,7 @@
  * =====================================================================================
  */
 #include <Triangulator.hh>
+#include <Checkpoint.hh>
 #include <iostream>
 #include <limits>
 #include <math.h>
@@ -71,24 +72,7 @@ m_nInputSites(ns)
     AllocateStorage();
 
     /* Assign geometry */
-    for( int i=0; i<m_nSites; i++ )
-    {
-        if( i < m_nInputSites ) 
-        {
-            m_sites[i].m_coord = &(s[i]);
-        }
-        else
-        {
-            /* Setting super-triangle coordinates to the first site
-             * before it is computed */
-            m_superTriangle[i%3][0] = s[0][0];
-            m_superTriangle[i%3][1] = s[0][1];
-            
-            m_sites[i].m_coord = &(m_superTriangle[i%3]);
-        }
-        
-        m_sites[i].m_id = i;
-    }
+    AssignSites(s);
     
     /* Initialize super-triangle if required */
     if(m_attributes & Triangulator_SuperTriangle) InitSuperTriangle();  
@@ -126,6 +110,48 @@ m_nInputSites(ns)
     GenerateNodeNeighbours();
 }
 
+/*
+ *--------------------------------------------------------------------------------------
+ *       Class:  Triangulator
+ *      Method:  Triangulator
+ * Description:  Restores a triangulation of the given sites from a checkpoint, instead
+ *               of recomputing it. Only the attributes computed by the constructor above
+ *               are available; the edge-structure used during triangulation is not.
+ *--------------------------------------------------------------------------------------
+ */
+Triangulator::Triangulator(int ns, float **s, Checkpoint *cp)
+:m_nSites(ns),
+m_nInputSites(ns)
+{
+    cp->Section("TRIA");
+    cp->Value(m_attributes);
+
+    AllocateStorage();
+    AssignSites(s);
+    
+    /* The edge-pool is only used while triangulating */
+    delete m_dEdgePool;
+    m_dEdgePool = NULL;
+    m_le = m_re = NULL;
+
+    Serialize(cp);
+}
+
+/*
+ *--------------------------------------------------------------------------------------
+ *       Class:  Triangulator
+ *      Method:  Triangulator :: Save
+ * Description:  Saves the triangulation to a checkpoint
+ *--------------------------------------------------------------------------------------
+ */
+void Triangulator::Save(Checkpoint *cp)
+{
+    cp->Section("TRIA");
+    cp->Value(m_attributes);
+
+    Serialize(cp);
+}
+
 /*
  *--------------------------------------------------------------------------------------
  *       Class:  Triangulator
@@ -190,6 +216,21 @@ unsigned int **Triangulator::GetTriangleIndices()
 	return m_tIndices;
 }
 
+/*
+ *--------------------------------------------------------------------------------------
+ *       Class:  Triangulator
+ *      Method:  Triangulator :: GetTriangleNeighbours
+ * Description:  Returns the indices of the (up to three) triangles sharing an edge with
+ *               each triangle, in no particular order; missing neighbours along the 
+ *               hull are set to m_nFaces-1. Note, the Triagulator class maintains 
+ *               ownership of the array returned.
+ *--------------------------------------------------------------------------------------
+ */
+unsigned int **Triangulator::GetTriangleNeighbours()
+{
+	return m_tNeighbours;
+}
+
 /*
  *--------------------------------------------------------------------------------------
  *       Class:  Triangulator
@@ -463,6 +504,134 @@ void Triangulator::AllocateStorage()
     m_voronoiArea           = NULL;
 }
 
+/*
+ *--------------------------------------------------------------------------------------
+ *       Class:  Triangulator
+ *      Method:  Triangulator :: AssignSites
+ * Description:  Assigns input coordinates and ids to sites.
+ *--------------------------------------------------------------------------------------
+ */
+void Triangulator::AssignSites(float **s)
+{
+    for( int i=0; i<m_nSites; i++ )
+    {
+        if( i < m_nInputSites ) 
+        {
+            m_sites[i].m_coord = &(s[i]);
+        }
+        else
+        {
+            /* Setting super-triangle coordinates to the first site
+             * before it is computed */
+            m_superTriangle[i%3][0] = s[0][0];
+            m_superTriangle[i%3][1] = s[0][1];
+            
+            m_sites[i].m_coord = &(m_superTriangle[i%3]);
+        }
+        
+        m_sites[i].m_id = i;
+    }
+}
+
+/*
+ *--------------------------------------------------------------------------------------
+ *       Class:  Triangulator
+ *      Method:  Triangulator :: Serialize
+ * Description:  Saves or restores computed attributes. When restoring, arrays are 
+ *               allocated with the same layout as in the triangulation routines.
+ *--------------------------------------------------------------------------------------
+ */
+void Triangulator::Serialize(Checkpoint *cp)
+{
+    bool restore = cp->IsReading();
+
+    cp->Match(m_nSites, "number of sites");
+    cp->Value(m_nEdges);
+    cp->Value(m_nFaces);
+    cp->Value(m_nTriangles);
+    cp->Value(m_nVoronoiVertices);
+
+    if( m_superTriangle ) cp->Data( m_superTriangle[0], sizeof( float ) * 6 );
+    cp->Data( m_hull, sizeof( int ) * m_nSites );
+    cp->Data( m_outputHull, sizeof( int ) * m_nSites );
+
+    /* Triangles */
+    if( m_attributes & Triangulator_TriangleIndices )
+    {
+        if( restore )
+        {
+            m_tIndices = new unsigned int*[m_nFaces];
+            m_tIndices[0] = new unsigned int[m_nFaces * 3];
+            for( int i=0; i<m_nFaces; i++ ) m_tIndices[i] = m_tIndices[0]+i*3;
+            
+            if( m_attributes & Triangulator_TriangleNeighbours )
+            {
+                m_tNeighbours = new unsigned int*[m_nFaces];
+                m_tNeighbours[0] = new unsigned int[m_nFaces * 3];
+                for( int i=0; i<m_nFaces; i++ ) m_tNeighbours[i] = m_tNeighbours[0]+i*3;
+            }
+        }
+
+        cp->Data( m_tIndices[0], sizeof( unsigned int ) * m_nFaces * 3 );
+        if( m_tNeighbours ) cp->Data( m_tNeighbours[0], sizeof( unsigned int ) * m_nFaces * 3 );
+    }
+
+    /* Node-neighbours and voronoi attributes */
+    if( restore ) m_nNeighbours = new unsigned int [m_nSites];
+    cp->Data( m_nNeighbours, sizeof( unsigned int ) * m_nSites );
+    
+    int nNeighboursSum = 0;
+    for( int i=0; i<m_nSites; i++ ) nNeighboursSum += m_nNeighbours[i];
+
+    if( restore )
+    {
+        if( m_attributes & (Triangulator_VoronoiCellAreas | Triangulator_VoronoiVertices) )
+            m_voronoiArea = new float[m_nSites];
+        
+        if( m_attributes & Triangulator_NodeNeighbours )
+        {
+            m_neighbours = new unsigned int* [m_nSites];
+            m_neighbours[0] = new unsigned int [nNeighboursSum];
+        }
+
+        if( m_attributes & (Triangulator_VoronoiSides | Triangulator_VoronoiVertices) )
+        {
+            m_voronoiSides = new float* [m_nSites];
+            m_voronoiSides[0] = new float [nNeighboursSum];
+        }
+
+        for( int i=0, offset=0; i<m_nSites; i++ )
+        {
+            if( m_neighbours ) m_neighbours[i] = m_neighbours[0] + offset;
+            if( m_voronoiSides ) m_voronoiSides[i] = m_voronoiSides[0] + offset;
+            
+            offset += m_nNeighbours[i];
+        }
+    }
+
+    if( m_voronoiArea ) cp->Data( m_voronoiArea, sizeof( float ) * m_nSites );
+    if( m_neighbours ) cp->Data( m_neighbours[0], sizeof( unsigned int ) * nNeighboursSum );
+    if( m_voronoiSides ) cp->Data( m_voronoiSides[0], sizeof( float ) * nNeighboursSum );
+
+    /* Voronoi vertices live in a memory-pool; a restored pool is exactly full */
+    if( m_attributes & Triangulator_VoronoiVertices )
+    {
+        if( restore )
+        {
+            delete m_vEdgePool;
+            m_vEdgePool = NULL;
+
+            if( m_nVoronoiVertices )
+            {
+                m_vEdgePool = new MemoryPool( sizeof(VSite), m_nVoronoiVertices, MemoryPool::Fixed );
+                for( int i=0; i<m_nVoronoiVertices; i++ ) m_vEdgePool->NewObject();
+            }
+        }
+
+        if( m_nVoronoiVertices ) cp->Data( GetVoronoiVertices(), sizeof(VSite) * m_nVoronoiVertices );
+    }
+}
+
 /*
  *--------------------------------------------------------------------------------------
  *       Class:  Triangulator
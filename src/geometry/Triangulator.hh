@@ -41,8 +41,13 @@
 #include <Topology.hh>
 #include <MemoryPool.hh>
 
+namespace src { namespace util {
+    class Checkpoint;
+}}
+
 namespace src { namespace geometry {
 using namespace src::mem;
+using src::util::Checkpoint;
 using namespace src::geometry;
 /*
  * =====================================================================================
@@ -60,12 +65,15 @@ class Triangulator
      * Constructor and Descructor 
      *-----------------------------------------------------------------------------*/
     Triangulator(int ns, float **s, unsigned int attr);
+    /* Restores a triangulation saved to a checkpoint */
+    Triangulator(int ns, float **s, Checkpoint *cp);
     ~Triangulator();
 
     /*-----------------------------------------------------------------------------
      * Public interface
      *-----------------------------------------------------------------------------*/
     unsigned int            **GetTriangleIndices();
+    unsigned int            **GetTriangleNeighbours();
     float                   **GetVoronoiSides();
     float                   *GetVoronoiCellAreas();
     unsigned int            *GetNumNeighbours();
@@ -76,6 +84,7 @@ class Triangulator
     long int                GetNumVoronoiVertices();
     VSite                   *GetVoronoiVertices();   
     friend std::ostream&    operator<<(std::ostream& os, const Triangulator& t);
+    void                    Save(Checkpoint *cp);
 
     /*-----------------------------------------------------------------------------
      * Attributes used to initialize a Triangulator-object.
@@ -145,6 +154,8 @@ class Triangulator
      * Member functions
      *-----------------------------------------------------------------------------*/
     void AllocateStorage();
+    void AssignSites(float **s);
+    void Serialize(Checkpoint *cp);
     void SortSites();
     void InitSuperTriangle();
     void Delaunay( int sl, int sh, Edge **le, Edge **re );   
@@ -0,0 +1,443 @@
+/*
+ * =====================================================================================
+ * Scalable PaleoGeomorphology Model (SPGM)
+ *
+ * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * This program is free software; you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
+ * Place, Suite 330, Boston, MA 02111-1307 USA
+ * ===================================================================================== 
+ */
+/*
+ * =====================================================================================
+ *
+ *       Filename:  AlgebraicMultigrid.cc
+ *
+ *    Description:  Smoothed-aggregation algebraic multigrid preconditioner
+ *
+ *        Version:  1.0
+ *        Created:  18/10/26 15:34:52
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * =====================================================================================
+ */
+
+#include <AlgebraicMultigrid.hh>
+#include <ParallelKernels.hh>
+#include <iostream>
+#include <math.h>
+#include <algorithm>
+
+namespace src { namespace math {
+    using namespace std;
+    using namespace Eigen;
+
+    const float AlgebraicMultigrid::STRENGTH_THRESHOLD  = 0.08;
+    const int   AlgebraicMultigrid::MAX_LEVELS          = 10;
+    const int   AlgebraicMultigrid::COARSEST_SIZE       = 500;
+    const int   AlgebraicMultigrid::SMOOTHING_STEPS     = 2;
+    const int   AlgebraicMultigrid::MAX_POWER_ITERATIONS= 50;
+    const float AlgebraicMultigrid::POWER_TOLERANCE     = 0.01;
+    const float AlgebraicMultigrid::RHO_SAFETY_FACTOR   = 1.1;
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  AlgebraicMultigrid
+     *      Method:  AlgebraicMultigrid :: AlgebraicMultigrid
+     * Description:  Constructor
+     *--------------------------------------------------------------------------------------
+     */
+    AlgebraicMultigrid::AlgebraicMultigrid():
+    m_fine(NULL),
+    m_coarseDirect(false)
+    {
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  AlgebraicMultigrid
+     *      Method:  AlgebraicMultigrid :: ~AlgebraicMultigrid
+     * Description:  Destructor
+     *--------------------------------------------------------------------------------------
+     */
+    AlgebraicMultigrid::~AlgebraicMultigrid()
+    {
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  AlgebraicMultigrid
+     *      Method:  AlgebraicMultigrid :: Setup
+     * Description:  Builds the hierarchy for A: levels are added until the coarsest 
+     *               operator is small enough to be factorized, or coarsening stalls
+     *--------------------------------------------------------------------------------------
+     */
+    void AlgebraicMultigrid::Setup(const SpMatrix &A)
+    {
+        m_fine = &A;
+        m_levels.clear();
+        m_levels.push_back(Level());
+
+        for(int l=0; ; l++)
+        {
+            UpdateSmoother(l);
+            
+            const SpMatrix &Al = Operator(l);
+            if((Al.rows() <= COARSEST_SIZE) || (l == MAX_LEVELS-1)) break;
+            
+            vector<int> aggregates;
+            int nAggregates = Aggregate(Al, aggregates);
+            if((nAggregates == 0) || (nAggregates == Al.rows())) break;
+
+            BuildProlongator(l, aggregates, nAggregates);
+            
+            SpMatrix AP = Al * m_levels[l].P;
+            SpMatrix Ac = m_levels[l].R * AP;
+            m_levels.push_back(Level());
+            m_levels[l+1].A.swap(Ac);
+        }
+
+        /*-----------------------------------------------------------------------------
+         * Allocate work-vectors and factorize the coarsest operator, if small enough
+         *-----------------------------------------------------------------------------*/
+        int last = m_levels.size() - 1;
+        double nnz = 0;
+        cout << "\tAMG hierarchy: levels (" << m_levels.size() << "), rows: (";
+        for(int l=0; l<=last; l++)
+        {
+            int n = Operator(l).rows();
+            
+            m_levels[l].r.resize(n);
+            if(l)
+            {
+                m_levels[l].b.resize(n);
+                m_levels[l].x.resize(n);
+            }
+            nnz += Operator(l).nonZeros();
+            cout << n << ((l < last) ? ", " : "");
+        }
+        cout << "), operator complexity: (" << nnz / A.nonZeros() << ")" << endl;
+        
+        m_coarseDirect = (Operator(last).rows() <= COARSEST_SIZE);
+        if(m_coarseDirect) m_coarseSolver.compute(SparseMatrix<float>(Operator(last)));
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  AlgebraicMultigrid
+     *      Method:  AlgebraicMultigrid :: Update
+     * Description:  Recomputes coarse operators, smoothers and the coarsest 
+     *               factorization after the values of the fine matrix have changed
+     *--------------------------------------------------------------------------------------
+     */
+    void AlgebraicMultigrid::Update()
+    {
+        int last = m_levels.size() - 1;
+        
+        for(int l=0; l<=last; l++)
+        {
+            UpdateSmoother(l);
+            
+            if(l < last)
+            {
+                SpMatrix AP = Operator(l) * m_levels[l].P;
+                m_levels[l+1].A = m_levels[l].R * AP;
+            }
+        }
+        if(m_coarseDirect) m_coarseSolver.compute(SparseMatrix<float>(Operator(last)));
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  AlgebraicMultigrid
+     *      Method:  AlgebraicMultigrid :: Aggregate
+     * Description:  Partitions nodes into aggregates of strongly connected neighbours, 
+     *               following Vanek et al. (1996): (1) nodes whose strong neighbours are
+     *               all unaggregated seed an aggregate with them, (2) remaining nodes 
+     *               join the aggregate they are most strongly connected to and (3) any 
+     *               left form aggregates with their unaggregated strong neighbours. Nodes
+     *               without strong connections are left unaggregated (-1), as the 
+     *               smoother suffices for them. Returns the number of aggregates.
+     *--------------------------------------------------------------------------------------
+     */
+    int AlgebraicMultigrid::Aggregate(const SpMatrix &A, vector<int> &aggregates)
+    {
+        int n                               = A.rows();
+        const int *outer                    = A.outerIndexPtr();
+        const int *inner                    = A.innerIndexPtr();
+        const float *values                 = A.valuePtr();
+        
+        /*-----------------------------------------------------------------------------
+         * Connection i-j is strong if |a_ij| >= theta * sqrt(|a_ii * a_jj|)
+         *-----------------------------------------------------------------------------*/
+        vector<float> diagonal(n, 0);
+        for(int i=0; i<n; i++)
+            for(int k=outer[i]; k<outer[i+1]; k++) if(inner[k] == i) diagonal[i] = fabs(values[k]);
+
+        vector<char> strong(A.nonZeros(), 0);
+        vector<char> connected(n, 0);
+        for(int i=0; i<n; i++)
+        {
+            for(int k=outer[i]; k<outer[i+1]; k++)
+            {
+                int j = inner[k];
+                if(j == i) continue;
+                
+                float threshold = STRENGTH_THRESHOLD * sqrt(diagonal[i] * diagonal[j]);
+                if(fabs(values[k]) >= threshold) strong[k] = connected[i] = 1;
+            }
+        }
+        
+        /* Pass 1 */
+        int nAggregates = 0;
+        aggregates.assign(n, -1);
+        for(int i=0; i<n; i++)
+        {
+            if((aggregates[i] != -1) || !connected[i]) continue;
+            
+            bool isolated = true;
+            for(int k=outer[i]; (k<outer[i+1]) && isolated; k++) 
+                if(strong[k] && (aggregates[inner[k]] != -1)) isolated = false;
+            if(!isolated) continue;
+
+            aggregates[i] = nAggregates;
+            for(int k=outer[i]; k<outer[i+1]; k++) if(strong[k]) aggregates[inner[k]] = nAggregates;
+            nAggregates++;
+        }
+
+        /* Pass 2 */
+        vector<int> seeded(aggregates);
+        for(int i=0; i<n; i++)
+        {
+            if(aggregates[i] != -1) continue;
+            
+            float strongest = 0;
+            for(int k=outer[i]; k<outer[i+1]; k++)
+            {
+                if(strong[k] && (seeded[inner[k]] != -1) && (fabs(values[k]) > strongest))
+                {
+                    strongest = fabs(values[k]);
+                    aggregates[i] = seeded[inner[k]];
+                }
+            }
+        }
+
+        /* Pass 3 */
+        for(int i=0; i<n; i++)
+        {
+            if((aggregates[i] != -1) || !connected[i]) continue;
+
+            aggregates[i] = nAggregates;
+            for(int k=outer[i]; k<outer[i+1]; k++) 
+                if(strong[k] && (aggregates[inner[k]] == -1)) aggregates[inner[k]] = nAggregates;
+            nAggregates++;
+        }
+
+        return nAggregates;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  AlgebraicMultigrid
+     *      Method:  AlgebraicMultigrid :: BuildProlongator
+     * Description:  Builds the tentative prolongator T, which injects constants into 
+     *               aggregates and has orthonormal columns, and smooths it by a damped 
+     *               Jacobi step: P = (I - omega * D^-1 * A) * T
+     *--------------------------------------------------------------------------------------
+     */
+    void AlgebraicMultigrid::BuildProlongator(int level, const vector<int> &aggregates, 
+                                              int nAggregates)
+    {
+        Level &lv                           = m_levels[level];
+        const SpMatrix &A                   = Operator(level);
+        int n                               = A.rows();
+        
+        vector<int> sizes(nAggregates, 0);
+        for(int i=0; i<n; i++) if(aggregates[i] != -1) sizes[aggregates[i]]++;
+
+        vector< Triplet<float> > triplets;
+        for(int i=0; i<n; i++)
+        {
+            if(aggregates[i] == -1) continue;
+            triplets.push_back(Triplet<float>(i, aggregates[i], 1.0f/sqrt((float)sizes[aggregates[i]])));
+        }
+        SpMatrix T(n, nAggregates);
+        T.setFromTriplets(triplets.begin(), triplets.end());
+
+        SpMatrix S(A);
+        float *values                       = S.valuePtr();
+        const int *outer                    = S.outerIndexPtr();
+        for(int i=0; i<n; i++)
+            for(int k=outer[i]; k<outer[i+1]; k++) values[k] *= lv.omega * lv.invDiagonal[i];
+        
+        SpMatrix ST = S * T;
+        lv.P = T - ST;
+        lv.R = lv.P.transpose();
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  AlgebraicMultigrid
+     *      Method:  AlgebraicMultigrid :: UpdateSmoother
+     * Description:  Computes the inverse diagonal of a level's operator and the Jacobi 
+     *               damping factor 4/(3 rho), rho being the spectral radius of D^-1 A. 
+     *               Power iteration is run until the Rayleigh quotient (v'Av)/(v'Dv) 
+     *               settles. That quotient never exceeds rho, so it is inflated by 
+     *               RHO_SAFETY_FACTOR, and capped by the Gershgorin bound 
+     *               max_i sum_j |a_ij|/a_ii, which never falls below rho. This keeps
+     *               omega * rho < 2, so that the smoother, and hence the V-cycle, 
+     *               remain convergent and symmetric positive-definite.
+     *--------------------------------------------------------------------------------------
+     */
+    void AlgebraicMultigrid::UpdateSmoother(int level)
+    {
+        Level &lv                           = m_levels[level];
+        const SpMatrix &A                   = Operator(level);
+        int n                               = A.rows();
+        const int *outer                    = A.outerIndexPtr();
+        const int *inner                    = A.innerIndexPtr();
+        const float *values                 = A.valuePtr();
+        
+        VectorXf diagonal(n), rowBounds(n);
+        lv.invDiagonal.resize(n);
+        
+        #pragma omp parallel for
+        for(int i=0; i<n; i++)
+        {
+            float d = 0, rowSum = 0;
+            for(int k=outer[i]; k<outer[i+1]; k++)
+            {
+                if(inner[k] == i) d = values[k];
+                rowSum += fabs(values[k]);
+            }
+            if(d == 0) d = 1;
+
+            diagonal[i] = d;
+            lv.invDiagonal[i] = 1.0f/d;
+            rowBounds[i] = rowSum / fabs(d);
+        }
+        double gershgorin = rowBounds.maxCoeff();
+
+        VectorXf v(n), w(n), dv(n);
+        for(int i=0; i<n; i++) v[i] = 1 + (i % 7);
+        v /= sqrt(Dot(n, v.data(), v.data()));
+
+        double rho = 0;
+        for(int k=0; k<MAX_POWER_ITERATIONS; k++)
+        {
+            Multiply(A, v.data(), w.data(), false);
+            dv = v.cwiseProduct(diagonal);
+            
+            double rayleigh = Dot(n, v.data(), w.data()) / Dot(n, v.data(), dv.data());
+            bool converged = (k > 0) && (fabs(rayleigh - rho) <= POWER_TOLERANCE * rayleigh);
+            rho = rayleigh;
+            if(converged) break;
+            
+            w = w.cwiseProduct(lv.invDiagonal);
+            double norm = sqrt(Dot(n, w.data(), w.data()));
+            if(norm == 0) break;
+            v = w / norm;
+        }
+        
+        rho = min(RHO_SAFETY_FACTOR * rho, gershgorin);
+        if(rho <= 0) rho = gershgorin;
+        lv.omega = 4.0 / (3.0 * rho);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  AlgebraicMultigrid
+     *      Method:  AlgebraicMultigrid :: Smooth
+     * Description:  Applies damped-Jacobi sweeps to A x = b on a level, starting from 
+     *               x = 0 if zeroGuess is set
+     *--------------------------------------------------------------------------------------
+     */
+    void AlgebraicMultigrid::Smooth(int level, const float *b, float *x, bool zeroGuess)
+    {
+        Level &lv                           = m_levels[level];
+        const SpMatrix &A                   = Operator(level);
+        int n                               = A.rows();
+        const float *invDiagonal            = lv.invDiagonal.data();
+        float *r                            = lv.r.data();
+        float omega                         = lv.omega;
+        int s                               = 0;
+
+        if(zeroGuess)
+        {
+            #pragma omp parallel for
+            for(int i=0; i<n; i++) x[i] = omega * invDiagonal[i] * b[i];
+            s++;
+        }
+
+        for(; s<SMOOTHING_STEPS; s++)
+        {
+            Multiply(A, x, r, false);
+            
+            #pragma omp parallel for
+            for(int i=0; i<n; i++) x[i] += omega * invDiagonal[i] * (b[i] - r[i]);
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  AlgebraicMultigrid
+     *      Method:  AlgebraicMultigrid :: Cycle
+     * Description:  V-cycle from the given level, with equal pre- and post-smoothing, so 
+     *               that the preconditioner is symmetric
+     *--------------------------------------------------------------------------------------
+     */
+    void AlgebraicMultigrid::Cycle(int level, const float *b, float *x)
+    {
+        int n                               = Operator(level).rows();
+        
+        if(level == (int)m_levels.size() - 1)
+        {
+            if(m_coarseDirect) Map<VectorXf>(x, n) = m_coarseSolver.solve(Map<const VectorXf>(b, n));
+            else Smooth(level, b, x, true);
+            return;
+        }
+
+        Level &lv                           = m_levels[level];
+        Level &coarse                       = m_levels[level+1];
+        float *r                            = lv.r.data();
+
+        Smooth(level, b, x, true);
+        
+        Multiply(Operator(level), x, r, false);
+        
+        #pragma omp parallel for
+        for(int i=0; i<n; i++) r[i] = b[i] - r[i];
+
+        Multiply(lv.R, r, coarse.b.data(), false);
+        Cycle(level+1, coarse.b.data(), coarse.x.data());
+        Multiply(lv.P, coarse.x.data(), x, true);
+
+        Smooth(level, b, x, false);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  AlgebraicMultigrid
+     *      Method:  AlgebraicMultigrid :: Apply
+     * Description:  x = M^-1 b, for a single V-cycle M^-1
+     *--------------------------------------------------------------------------------------
+     */
+    void AlgebraicMultigrid::Apply(const float *b, float *x)
+    {
+        Cycle(0, b, x);
+    }
+}}
@@ -0,0 +1,118 @@
+/*
+ * =====================================================================================
+ * Scalable PaleoGeomorphology Model (SPGM)
+ *
+ * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * This program is free software; you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
+ * Place, Suite 330, Boston, MA 02111-1307 USA
+ * ===================================================================================== 
+ */
+/*
+ * =====================================================================================
+ *
+ *       Filename:  AlgebraicMultigrid.hh
+ *
+ *    Description:  Smoothed-aggregation algebraic multigrid preconditioner
+ *
+ *        Version:  1.0
+ *        Created:  18/10/26 15:34:52
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * =====================================================================================
+ */
+#ifndef SRC_MATH_ALGEBRAIC_MULTIGRID_HH
+#define SRC_MATH_ALGEBRAIC_MULTIGRID_HH
+
+#include <vector>
+
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+namespace src{ namespace math {
+    using namespace Eigen;
+    using namespace std;
+    
+    /*
+     * =====================================================================================
+     *        Class:  AlgebraicMultigrid
+     *  Description:  Smoothed-aggregation AMG for symmetric positive-definite systems, 
+     *                applied as a symmetric V-cycle with damped-Jacobi smoothing and a 
+     *                direct solve on the coarsest level. If coarsening stalls, e.g. for
+     *                strongly diagonally dominant systems, the coarsest level is only 
+     *                smoothed instead. Setup aggregates strongly 
+     *                connected nodes and builds the smoothed prolongators, once for a 
+     *                given sparsity; Update recomputes the Galerkin coarse operators and
+     *                smoother parameters for new values of the fine matrix, reusing the 
+     *                prolongators. The fine matrix is referenced, not copied, and must 
+     *                outlive the hierarchy.
+     * =====================================================================================
+     */
+    class AlgebraicMultigrid
+    {
+        public:
+        typedef SparseMatrix<float, RowMajor> SpMatrix;
+        
+        AlgebraicMultigrid();
+        ~AlgebraicMultigrid();
+
+        void Setup(const SpMatrix &A);
+        void Update();
+        void Apply(const float *b, float *x);
+
+        int GetNumLevels() const { return m_levels.size(); }
+
+        private:
+        static const float STRENGTH_THRESHOLD;
+        static const int   MAX_LEVELS;
+        static const int   COARSEST_SIZE;
+        static const int   SMOOTHING_STEPS;
+        static const int   MAX_POWER_ITERATIONS;
+        static const float POWER_TOLERANCE;
+        static const float RHO_SAFETY_FACTOR;
+
+        /*-----------------------------------------------------------------------------
+         * Each level holds its operator (except the finest, which is referenced), the
+         * prolongator to it from the next coarser level and its transpose, the 
+         * inverse diagonal and damping factor of the smoother, and work-vectors
+         *-----------------------------------------------------------------------------*/
+        struct Level
+        {
+            SpMatrix A;
+            SpMatrix P;
+            SpMatrix R;
+            VectorXf invDiagonal;
+            float    omega;
+            VectorXf b;
+            VectorXf x;
+            VectorXf r;
+        };
+        const SpMatrix                      *m_fine;
+        vector<Level>                       m_levels;
+        SimplicialLDLT<SparseMatrix<float> > m_coarseSolver;
+        bool                                m_coarseDirect;
+
+        const SpMatrix &Operator(int level) const { return level ? m_levels[level].A : *m_fine; }
+        
+        int Aggregate(const SpMatrix &A, vector<int> &aggregates);
+        void BuildProlongator(int level, const vector<int> &aggregates, int nAggregates);
+        void UpdateSmoother(int level);
+        void Smooth(int level, const float *b, float *x, bool zeroGuess);
+        void Cycle(int level, const float *b, float *x);
+    };
+}}
+#endif
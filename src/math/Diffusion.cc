@@ -38,7 +38,9 @@
  */
 
 #include <Diffusion.hh>
+#include <ParallelKernels.hh>
 #include <assert.h>
+#include <algorithm>
 
 namespace src { namespace math {
     using namespace std;
@@ -57,7 +59,7 @@ namespace src { namespace math {
      */
     Diffusion::Diffusion( SurfaceTopology *st, ForcingFunc f, 
                           NeumannFunc n, int nt, float dt, 
-                          double tolerance, int maxIterations ):
+                          double tolerance, int maxIterations, bool matrixFree ):
     m_surfaceTopology(st),
     m_forcingFunc(f),
     m_neumannFunc(n),
@@ -65,7 +67,17 @@ namespace src { namespace math {
     m_dt(dt),
     m_tolerance(tolerance),
     m_maxIterations(maxIterations),
-    m_ts(1)
+    m_ts(1),
+    m_preconditioner(Preconditioner_Diagonal),
+    m_patternAnalyzed(false),
+    m_iterations(0),
+    m_error(0),
+    m_reuseFactorization(true),
+    m_coefficientVersion(0),
+    m_assembledVersion(-1),
+    m_factorizedVersion(-1),
+    m_patternFactorized(false),
+    m_operator(NULL)
     {
         int numTriangles                    = m_surfaceTopology->GetNumTriangles();
 
@@ -81,16 +93,15 @@ namespace src { namespace math {
         /*-----------------------------------------------------------------------------
          * Initialize vectors
          *-----------------------------------------------------------------------------*/
-        m_dirichlet.reserve(m_nMeshPoints);
-        m_coefficient.reserve(numTriangles);
+        m_dirichlet.setZero(m_nMeshPoints);
+        m_dirichletRHS.setZero(m_nMeshPoints);
+        m_coefficient.setZero(numTriangles);
 
         /*-----------------------------------------------------------------------------
          * Initialize sparse matrices
          *-----------------------------------------------------------------------------*/
-        m_A_full = SparseMatrix<float>(m_nMeshPoints, m_nMeshPoints);
-        m_A_free = SparseMatrix<float>(m_nMeshPoints, m_nMeshPoints);
-        m_B_full = SparseMatrix<float>(m_nMeshPoints, m_nMeshPoints);
-        m_B_free = SparseMatrix<float>(m_nMeshPoints, m_nMeshPoints);    
+        m_A_full = SpMatrix(m_nMeshPoints, m_nMeshPoints);
+        m_B_full = SpMatrix(m_nMeshPoints, m_nMeshPoints);
         
         /*-----------------------------------------------------------------------------
          * Precompute element centres and determinants
@@ -113,12 +124,12 @@ namespace src { namespace math {
             float cy = ( m_surfaceTopology->Y(v0) + 
                          m_surfaceTopology->Y(v1) + 
                          m_surfaceTopology->Y(v2) ) / 3.0f;
-            m_elementCentres[ie] = Coord(cx, cy);
+            m_elementCentres.push_back(Coord(cx, cy));
 
             B << ( st->X(v0)-st->X(v2) ), ( st->X(v1)-st->X(v2) ),
                  ( st->Y(v0)-st->Y(v2) ), ( st->Y(v1)-st->Y(v2) );
 
-            m_determinants[ie] = B.determinant();
+            m_determinants.push_back(B.determinant());
             assert(m_determinants[ie] >= 0.);
         }
 
@@ -132,11 +143,21 @@ namespace src { namespace math {
                 m_dirichletNodeIndices.push_back(in);
             }
         }
+        m_nFreeNodes = m_nMeshPoints - m_dirichletNodeIndices.size();
         
         /*-----------------------------------------------------------------------------
-         * Assemble matrix B, which does not change
+         * Assemble matrix B, which does not change, and precompute the sparsity of A
+         * and lhs, unless the system is solved matrix-free
          *-----------------------------------------------------------------------------*/
-        AssembleB();
+        if(matrixFree)
+        {
+            m_operator = new DiffusionOperator(m_surfaceTopology, m_nFreeNodes);
+        }
+        else
+        {
+            AssembleB();
+            InitializeSparsity();
+        }
     }
 
     /*
@@ -148,6 +169,7 @@ namespace src { namespace math {
      */
     Diffusion::~Diffusion()
     {
+        delete m_operator;
     }
     
     /*
@@ -206,34 +228,117 @@ namespace src { namespace math {
     /*
      *--------------------------------------------------------------------------------------
      *       Class:  Diffusion
-     *      Method:  Diffusion :: assembleA 
-     * Description:  Assemble global stiffness matrix
+     *      Method:  Diffusion :: InitializeSparsity
+     * Description:  Computes element stiffness matrices for a unit coefficient and maps 
+     *               their entries to the nonzeros of A, which shares the sparsity of B. 
+     *               The sparsity of lhs is that of the top-left (free-node) block of B.
      *--------------------------------------------------------------------------------------
      */
-    void Diffusion::AssembleA()
+    void Diffusion::InitializeSparsity()
     {
         const unsigned int **triIndices     = m_surfaceTopology->GetTriangleIndices();
         int numTriangles                    = m_surfaceTopology->GetNumTriangles();
         
         Matrix3f lsm;
-        vector< Triplet<float> > triplets;
+        m_unitStiffness.resize(9*numTriangles);
+        for(int ie=0; ie<numTriangles; ie++)
+        {
+            LocalStiffnessMatrix(triIndices[ie], &lsm);
+
+            for(int i=0; i<3; i++)
+                for(int j=0; j<3; j++) m_unitStiffness[9*ie + 3*i + j] = lsm(i,j);
+        }
+
+        /*-----------------------------------------------------------------------------
+         * Locate element-matrix entries among the nonzeros of A and bucket them by 
+         * nonzero, retaining element order. Element matrices and the sparsity of A are
+         * symmetric, so entry (i,j) is located in row j.
+         *-----------------------------------------------------------------------------*/
+        m_A_full = m_B_full;
+        
+        int nnz = m_A_full.nonZeros();
+        const int *outer = m_A_full.outerIndexPtr();
+        const int *inner = m_A_full.innerIndexPtr();
+        vector<int> entryNonZeros(9*numTriangles);
+        
+        m_contributionOffsets.assign(nnz+1, 0);
         for(int ie=0; ie<numTriangles; ie++)
         {
             const unsigned int *elemTriIndices = triIndices[ie];
 
-            LocalStiffnessMatrix(elemTriIndices, &lsm);
-            
-            lsm *= m_coefficient[ie];
             for(int i=0; i<3; i++)
             {
                 for(int j=0; j<3; j++)
                 {
-                    Triplet<float> t(elemTriIndices[i], elemTriIndices[j], lsm(i,j));
-                    triplets.push_back(t);
+                    int row = elemTriIndices[i];
+                    int col = elemTriIndices[j];
+                    int k = lower_bound(inner + outer[col], inner + outer[col+1], row) - inner;
+                    
+                    entryNonZeros[9*ie + 3*i + j] = k;
+                    m_contributionOffsets[k+1]++;
+                }
+            }
+        }
+        for(int k=0; k<nnz; k++) m_contributionOffsets[k+1] += m_contributionOffsets[k];
+
+        vector<int> fill(m_contributionOffsets.begin(), m_contributionOffsets.end()-1);
+        m_contributions.resize(9*numTriangles);
+        for(int e=0; e<9*numTriangles; e++) m_contributions[fill[entryNonZeros[e]]++] = e;
+
+        /*-----------------------------------------------------------------------------
+         * Free nodes precede Dirichlet nodes, so that the nonzeros of each row of lhs
+         * are the leading nonzeros of the corresponding row of A
+         *-----------------------------------------------------------------------------*/
+        m_lhs = m_B_full.topLeftCorner(m_nFreeNodes, m_nFreeNodes);
+        m_lhsToFull.resize(m_lhs.nonZeros());
+        for(int col=0; col<m_nFreeNodes; col++)
+        {
+            int k = m_lhs.outerIndexPtr()[col];
+            for(int f=outer[col]; (f<outer[col+1]) && (inner[f]<m_nFreeNodes); f++) m_lhsToFull[k++] = f;
+            
+            assert(k == m_lhs.outerIndexPtr()[col+1]);
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Diffusion
+     *      Method:  Diffusion :: assembleA 
+     * Description:  Updates the values of the global stiffness matrix and of lhs in 
+     *               place, for the current element coefficients
+     *--------------------------------------------------------------------------------------
+     */
+    void Diffusion::AssembleA()
+    {
+        int nnz                             = m_A_full.nonZeros();
+        int nnzFree                         = m_lhs.nonZeros();
+        const float *unitStiffness          = &m_unitStiffness[0];
+        const float *coefficient            = m_coefficient.data();
+        const float *b                      = m_B_full.valuePtr();
+        float *a                            = m_A_full.valuePtr();
+        float *lhs                          = m_lhs.valuePtr();
+        
+        #pragma omp parallel
+        {
+            #pragma omp for
+            for(int k=0; k<nnz; k++)
+            {
+                float sum = 0;
+                for(int c=m_contributionOffsets[k]; c<m_contributionOffsets[k+1]; c++)
+                {
+                    int e = m_contributions[c];
+                    sum += unitStiffness[e] * coefficient[e/9];
                 }
+                a[k] = sum;
+            }
+
+            #pragma omp for
+            for(int k=0; k<nnzFree; k++)
+            {
+                int f = m_lhsToFull[k];
+                lhs[k] = m_dt * a[f] + b[f];
             }
         }
-        m_A_full.setFromTriplets(triplets.begin(), triplets.end());
     }
     
     /*
@@ -319,27 +424,41 @@ namespace src { namespace math {
          * So far we've computed what is 'b*dt' for a Poisson equation; we now need to
          * compute b*dt + B*u_n-1
          *-----------------------------------------------------------------------------*/
-        VectorXf U_n_1(m_nMeshPoints);
+        if(m_operator)
+        {
+            m_operator->AddMass(m_solutions.col(PREV).data(), m_rhs.data());
 
-        U_n_1.fill(0);
-        for(int i=0; i<m_nMeshPoints; i++) U_n_1(i) = m_solutions(i, PREV);
-        m_rhs += m_B_full * U_n_1;
+            for( vector<int>::iterator it=m_dirichletNodeIndices.begin(); 
+                 it != m_dirichletNodeIndices.end(); it++) m_solutions(*it, CURR) = m_dirichlet[*it];
+            
+            m_operator->SubtractDirichlet(m_dirichlet.data(), m_rhs.data());
+            return;
+        }
+
+        Multiply(m_B_full, m_solutions.col(PREV).data(), m_rhs.data(), true);
 
         /*-----------------------------------------------------------------------------
-         * Apply Dirichlet conditions
+         * Apply Dirichlet conditions: subtract (dt*A + B)*U_d, where U_d is nonzero 
+         * only at Dirichlet nodes, by traversing their rows (A and B are symmetric)
          *-----------------------------------------------------------------------------*/
-        VectorXf U_d(m_nMeshPoints);
+        const int *outer = m_A_full.outerIndexPtr();
+        const int *inner = m_A_full.innerIndexPtr();
+        const float *a = m_A_full.valuePtr();
+        const float *b = m_B_full.valuePtr();
 
-        U_d.fill(0);
+        m_dirichletRHS.setZero();
         for( vector<int>::iterator it=m_dirichletNodeIndices.begin(); 
              it != m_dirichletNodeIndices.end(); it++)
         {
             float dVal              = m_dirichlet[*it];
             
-            U_d(*it)                = dVal;
             m_solutions(*it, CURR)  = dVal;      
+            for(int k=outer[*it]; k<outer[*it+1]; k++) 
+            {
+                m_dirichletRHS(inner[k]) += (m_dt * a[k] + b[k]) * dVal;
+            }
         }
-        m_rhs -= (m_dt * m_A_full + m_B_full) * U_d;
+        m_rhs -= m_dirichletRHS;
     }
 
     /*
@@ -352,7 +471,7 @@ namespace src { namespace math {
      */
     void Diffusion::SetIC(vector<float> *vals)
     {
-        for(int i=0; i<m_nMeshPoints; i++) m_solutions(i, PREV) = (*vals)[i];
+        m_solutions.col(PREV) = Map<const VectorXf>(&(*vals)[0], m_nMeshPoints);
     }
 
     /*
@@ -364,20 +483,25 @@ namespace src { namespace math {
      */
     void Diffusion::SetDirichlet(vector<float> *dirichlet)
     {
-        for(int i=0; i<m_nMeshPoints; i++) m_dirichlet[i] = (*dirichlet)[i];
+        m_dirichlet = Map<const VectorXf>(&(*dirichlet)[0], m_nMeshPoints);
     }
 
     /*
      *--------------------------------------------------------------------------------------
      *       Class:  Diffusion
      *      Method:  Diffusion :: SetCoefficient
-     * Description:  Sets the coefficients for A
+     * Description:  Sets the coefficients for A, noting whether they have changed
      *--------------------------------------------------------------------------------------
      */
     void Diffusion::SetCoefficient(vector<float> *coefficient)
     {
-        int numTriangles = m_surfaceTopology->GetNumTriangles();
-        for(int i=0; i<numTriangles; i++) m_coefficient[i] = (*coefficient)[i];
+        Map<const VectorXf> values(&(*coefficient)[0], m_coefficient.size());
+        
+        if(values != m_coefficient)
+        {
+            m_coefficient = values;
+            m_coefficientVersion++;
+        }
     }
 
     /*
@@ -389,7 +513,234 @@ namespace src { namespace math {
      */
     void Diffusion::GetSolution(vector<float> *result)
     {
-        for(int i=0; i<m_nMeshPoints; i++) (*result)[i] = m_solutions(i, CURR);
+        Map<VectorXf>(&(*result)[0], m_nMeshPoints) = m_solutions.col(CURR);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Diffusion
+     *      Method:  Diffusion :: ApplyLhs
+     * Description:  y = lhs x, for x and y spanning free nodes
+     *--------------------------------------------------------------------------------------
+     */
+    void Diffusion::ApplyLhs(const float *x, float *y)
+    {
+        if(m_operator) m_operator->Apply(x, y);
+        else Multiply(m_lhs, x, y, false);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Diffusion
+     *      Method:  Diffusion :: Precondition
+     * Description:  z = M^-1 r, for the current preconditioner M
+     *--------------------------------------------------------------------------------------
+     */
+    void Diffusion::Precondition(const VectorXf &r, VectorXf &z)
+    {
+        switch(m_preconditioner)
+        {
+            case Preconditioner_Diagonal:
+                {
+                    int n = r.size();
+                    const float *invDiagonal = m_invDiagonal.data();
+                    
+                    #pragma omp parallel for
+                    for(int i=0; i<n; i++) z[i] = invDiagonal[i] * r[i];
+                }
+                break;
+            case Preconditioner_IncompleteCholesky:
+                z = m_incompleteCholesky.solve(r);
+                break;
+            case Preconditioner_IncompleteLUT:
+                z = m_incompleteLUT.solve(r);
+                break;
+            case Preconditioner_AlgebraicMultigrid:
+                m_multigrid.Apply(r.data(), z.data());
+                break;
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Diffusion
+     *      Method:  Diffusion :: Solve
+     * Description:  Factorizes the preconditioner, if lhs has changed, and solves for the
+     *               free nodes with a preconditioned CG, starting from the solution of the
+     *               previous time-step. The stopping criterion and error estimate are 
+     *               those of Eigen's ConjugateGradient. Iterations and the time spent on
+     *               either part are reported.
+     *--------------------------------------------------------------------------------------
+     */
+    void Diffusion::Solve(bool refactorize)
+    {
+        int n = m_nFreeNodes;
+        
+        Timer tSetupBegin;
+        if(refactorize || !m_patternAnalyzed)
+        {
+            switch(m_preconditioner)
+            {
+                case Preconditioner_Diagonal:
+                    m_invDiagonal.resize(n);
+                    
+                    #pragma omp parallel for
+                    for(int i=0; i<n; i++)
+                    {
+                        float d = m_operator ? m_operator->Diagonal()[i] : m_lhs.coeff(i, i);
+                        m_invDiagonal[i] = (d != 0) ? 1.0f/d : 1.0f;
+                    }
+                    break;
+                case Preconditioner_IncompleteCholesky:
+                    if(!m_patternAnalyzed) m_incompleteCholesky.compute(m_lhs);
+                    else m_incompleteCholesky.factorize(m_lhs);
+                    break;
+                case Preconditioner_IncompleteLUT:
+                    /* Note: IncompleteLUT is only flagged as initialized by compute() */
+                    if(!m_patternAnalyzed) m_incompleteLUT.compute(m_lhs);
+                    else m_incompleteLUT.factorize(m_lhs);
+                    break;
+                case Preconditioner_AlgebraicMultigrid:
+                    if(!m_patternAnalyzed) m_multigrid.Setup(m_lhs);
+                    else m_multigrid.Update();
+                    break;
+            }
+            m_patternAnalyzed = true;
+        }
+        
+        Timer tSolveBegin;
+        m_cgResidual.resize(n);
+        m_cgDirection.resize(n);
+        m_cgProduct.resize(n);
+        m_cgPreconditioned.resize(n);
+        
+        float *x                            = m_solutions.col(CURR).data();
+        const float *x0                     = m_solutions.col(PREV).data();
+        const float *b                      = m_rhs.data();
+        float *r                            = m_cgResidual.data();
+        float *p                            = m_cgDirection.data();
+        float *q                            = m_cgProduct.data();
+        float *z                            = m_cgPreconditioned.data();
+
+        #pragma omp parallel for
+        for(int i=0; i<n; i++) x[i] = x0[i];
+        
+        ApplyLhs(x, q);
+        
+        #pragma omp parallel for
+        for(int i=0; i<n; i++) r[i] = b[i] - q[i];
+
+        double rhsNorm2 = Dot(n, b, b);
+        double threshold = m_tolerance * m_tolerance * rhsNorm2;
+        double residualNorm2 = Dot(n, r, r);
+        int iterations = 0;
+        
+        if(rhsNorm2 == 0)
+        {
+            #pragma omp parallel for
+            for(int i=0; i<n; i++) x[i] = 0;
+            
+            residualNorm2 = 0;
+            rhsNorm2 = 1;
+        }
+        else if(residualNorm2 >= threshold)
+        {
+            Precondition(m_cgResidual, m_cgDirection);
+            double absNew = Dot(n, r, p);
+            
+            while(iterations < m_maxIterations)
+            {
+                ApplyLhs(p, q);
+                
+                float alpha = absNew / Dot(n, p, q);
+                residualNorm2 = 0;
+                
+                #pragma omp parallel for reduction(+:residualNorm2)
+                for(int i=0; i<n; i++)
+                {
+                    x[i] += alpha * p[i];
+                    r[i] -= alpha * q[i];
+                    residualNorm2 += r[i] * r[i];
+                }
+                if(residualNorm2 < threshold) break;
+
+                Precondition(m_cgResidual, m_cgPreconditioned);
+                double absOld = absNew;
+                absNew = Dot(n, r, z);
+                float beta = absNew / absOld;
+                
+                #pragma omp parallel for
+                for(int i=0; i<n; i++) p[i] = z[i] + beta * p[i];
+                
+                iterations++;
+            }
+        }
+        Timer tSolveEnd;
+
+        m_iterations = iterations;
+        m_error = sqrt(residualNorm2 / rhsNorm2);
+
+        /*-----------------------------------------------------------------------------
+         * Print solver output 
+         *-----------------------------------------------------------------------------*/
+        cout << "\tDiffusion Solver Iterations: (" << m_iterations << ") ";
+        cout << ", estimated error: (" << m_error << ")";
+        cout << ", setup: (" << Timer::Elapsed(tSetupBegin, tSolveBegin) << " s)";
+        cout << ", solve: (" << Timer::Elapsed(tSolveBegin, tSolveEnd) << " s)" << endl;
+        if(m_iterations >= m_maxIterations) cout << "\t Warning: solver not converging.." << endl;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Diffusion
+     *      Method:  Diffusion :: SolveFactorized
+     * Description:  Solves for the free nodes using the Cholesky factorization of lhs, 
+     *               which is only recomputed for a new version of the coefficients. 
+     *               Returns false, and disables factorization reuse, if lhs could not 
+     *               be factorized.
+     *--------------------------------------------------------------------------------------
+     */
+    bool Diffusion::SolveFactorized()
+    {
+        Timer tSetupBegin;
+        if(m_factorizedVersion != m_coefficientVersion)
+        {
+            /* SimplicialLDLT requires column-major storage; lhs is symmetric */
+            SparseMatrix<float> lhs(m_lhs);
+            
+            if(!m_patternFactorized)
+            {
+                m_ldlt.analyzePattern(lhs);
+                m_patternFactorized = true;
+            }
+            m_ldlt.factorize(lhs);
+            
+            if(m_ldlt.info() != Success)
+            {
+                cerr << "Warning: factorization of diffusion system failed; "
+                     << "reverting to iterative solves.." << endl;
+                m_reuseFactorization = false;
+                return false;
+            }
+            m_factorizedVersion = m_coefficientVersion;
+        }
+        
+        Timer tSolveBegin;
+        m_solutions.col(CURR).head(m_nFreeNodes) = m_ldlt.solve(m_rhs.head(m_nFreeNodes));
+        Timer tSolveEnd;
+
+        m_iterations = 0;
+        m_cgProduct.resize(m_nFreeNodes);
+        ApplyLhs(m_solutions.col(CURR).data(), m_cgProduct.data());
+        
+        float rhsNorm = m_rhs.head(m_nFreeNodes).norm();
+        m_error = (m_cgProduct - m_rhs.head(m_nFreeNodes)).norm();
+        if(rhsNorm > 0) m_error /= rhsNorm;
+
+        cout << "\tDiffusion Solver (Cholesky) residual: (" << m_error << ")";
+        cout << ", setup: (" << Timer::Elapsed(tSetupBegin, tSolveBegin) << " s)";
+        cout << ", solve: (" << Timer::Elapsed(tSolveBegin, tSolveEnd) << " s)" << endl;
+        return true;
     }
 
     /*
@@ -403,58 +754,29 @@ namespace src { namespace math {
     {
         if(m_ts < m_nt)
         {
+            bool changed = (m_assembledVersion != m_coefficientVersion);
             
-            ConjugateGradient<SparseMatrix<float> > cg;
-            int nFreeNodes = m_nMeshPoints - m_dirichletNodeIndices.size();
-
-            AssembleA();
+            if(changed)
+            {
+                if(m_operator) m_operator->Update(m_coefficient, m_dt);
+                else AssembleA();
+            }
+            m_assembledVersion = m_coefficientVersion;
             AssembleRHS();
-            SparseMatrix<float> lhs ( m_dt * m_A_full.topLeftCorner(nFreeNodes, nFreeNodes) + 
-                                      m_B_full.topLeftCorner(nFreeNodes, nFreeNodes) );
             
             /*-----------------------------------------------------------------------------
-             * Solve linear system 
+             * Solve linear system, directly if coefficients are unchanged, otherwise
+             * iteratively
              *-----------------------------------------------------------------------------*/
-            cg.setMaxIterations(m_maxIterations);
-            cg.setTolerance(m_tolerance);
-            cg.compute(lhs);
-            VectorXf sol = cg.solve(m_rhs.head(nFreeNodes));
-            
-            /*VectorXf sol(m_nMeshPoints);
-            for(int i=0; i<m_nMeshPoints; i++) sol(i) = m_solutions(i, PREV);
+            if(m_operator || changed || !m_reuseFactorization || !SolveFactorized())
             {
-                int i = 0;
-                do 
-                {
-                    sol = cg.solveWithGuess(m_rhs.head(nFreeNodes), sol);
-                    std::cout << i << " : " << cg.error() << std::endl;
-                    ++i;
-                } while (cg.info()!=Success && i<5000);
-            }*/
-
-            /*SparseMatrix<float, ColMajor> A(lhs);
-            VectorXf sol;
-            SparseLU<SparseMatrix<float, ColMajor>, COLAMDOrdering<int> > solver;
-            solver.analyzePattern(A);
-            solver.factorize(A);
-            sol = solver.solve(m_rhs.head(nFreeNodes));*/
+                Solve(changed);
+            }
 
-            /*-----------------------------------------------------------------------------
-             * Store solution
-             *-----------------------------------------------------------------------------*/
-            for(int i=0; i<nFreeNodes; i++) m_solutions(i, CURR) = sol(i);
-            
             /*-----------------------------------------------------------------------------
              * Increment time-step 
              *-----------------------------------------------------------------------------*/
             m_ts++;
-
-            /*-----------------------------------------------------------------------------
-             * Print solver output 
-             *-----------------------------------------------------------------------------*/
-            cout << "\tDiffusion Solver Iterations: (" << cg.iterations() << ") ";
-            cout << ", estimated error: (" << cg.error() << ")" << endl;
-            if(cg.iterations() >= m_maxIterations) cout << "\t Warning: solver not converging.." << endl;
         }
         else
         {
@@ -40,9 +40,12 @@
 #include <SurfaceTopology.hh>
 #include <ScalarField.hh>
 #include <Timer.hh>
+#include <DiffusionOperator.hh>
+#include <AlgebraicMultigrid.hh>
 
 #include <Eigen/Dense>
 #include <Eigen/Sparse>
+#include <unsupported/Eigen/IterativeSolvers>
 
 namespace src{ namespace math {
     using namespace Eigen;
@@ -53,8 +56,12 @@ namespace src{ namespace math {
      *        Class:  Diffusion
      *  Description:  2D Diffusion on a Triangular Mesh. The nonlinear diffusion equation
      *                is cast in FE form using P1 triangular elements and the resulting 
-     *                algebraic equations are solved using a Conjugate Gradient solver in 
-     *                the Eigen library.
+     *                algebraic equations are solved using a multithreaded, 
+     *                preconditioned Conjugate Gradient solver, warm-started from the 
+     *                solution of the previous time-step. While the coefficients remain 
+     *                unchanged, a sparse Cholesky factorization of the system is reused 
+     *                instead. Alternatively, the system can be solved matrix-free, using
+     *                a DiffusionOperator.
      * =====================================================================================
      */
     class Diffusion
@@ -66,9 +73,18 @@ namespace src{ namespace math {
         
         typedef float (*ForcingFunc)     (float, float, float);
         typedef float (*NeumannFunc)     (float, float, float);
+        typedef SparseMatrix<float, RowMajor> SpMatrix;
+
+        typedef enum Preconditioner_t
+        {
+            Preconditioner_Diagonal,
+            Preconditioner_IncompleteCholesky,
+            Preconditioner_IncompleteLUT,
+            Preconditioner_AlgebraicMultigrid
+        }Preconditioner;
 
         Diffusion( SurfaceTopology *st, ForcingFunc f, NeumannFunc n, int nt, float dt, 
-                   double tolerance, int maxIterations );
+                   double tolerance, int maxIterations, bool matrixFree=false );
         ~Diffusion();
         
         void SetIC(vector<float> *vals);
@@ -79,6 +95,18 @@ namespace src{ namespace math {
 
         void Step();
         
+        void SetPreconditioner(Preconditioner p) 
+        { 
+            /* Only diagonal preconditioning is available for matrix-free solves */
+            m_preconditioner = m_operator ? Preconditioner_Diagonal : p; 
+            m_patternAnalyzed = false; 
+        }
+        void SetFactorizationReuse(bool reuse) { m_reuseFactorization = reuse; }
+        int GetIterations() const { return m_iterations; }
+        float GetError() const { return m_error; }
+        int GetTimeStep() const { return m_ts; }
+        void SetTimeStep(int ts) { m_ts = ts; }
+        
         MatrixXf                     m_solutions;
 
         private:
@@ -98,21 +126,84 @@ namespace src{ namespace math {
         
         /*-----------------------------------------------------------------------------
          * Member variables for various matrices and vectors needed for computing
-         * FEM solution
+         * FEM solution. Vectors set by the caller are copied in and out through 
+         * Eigen::Maps over the caller's arrays. Sparse matrices are stored row-major, 
+         * with both triangles, so that products with them parallelize over rows.
          *-----------------------------------------------------------------------------*/
         Vector2f                     m_shapeDerivatives[3];
-        SparseMatrix<float>          m_A_full;
-        SparseMatrix<float>          m_A_free;
-        SparseMatrix<float>          m_B_full;
-        SparseMatrix<float>          m_B_free;
+        SpMatrix                     m_A_full;
+        SpMatrix                     m_B_full;
+        SpMatrix                     m_lhs;     /* dt*A + B, restricted to free nodes */
         VectorXf                     m_rhs;
+        VectorXf                     m_dirichletRHS;
 
         vector<Coord>                m_elementCentres;
         vector<float>                m_determinants;
-        vector<float>                m_dirichlet;
-        vector<float>                m_coefficient;
+        VectorXf                     m_dirichlet;
+        VectorXf                     m_coefficient;
         vector<int>                  m_dirichletNodeIndices;
+        int                          m_nFreeNodes;
+
+        /*-----------------------------------------------------------------------------
+         * The triangulation is static, so element stiffness matrices for a unit 
+         * coefficient and the sparsity of A and lhs are computed once. For each 
+         * nonzero of A, m_contributions[m_contributionOffsets[k]..[k+1]] lists the 
+         * contributing entries of m_unitStiffness (9 per element, row-major). 
+         * m_lhsToFull maps nonzeros of lhs to those of A and B, which share their 
+         * sparsity. Each step then only updates nonzero values in place.
+         *-----------------------------------------------------------------------------*/
+        vector<float>                m_unitStiffness;
+        vector<int>                  m_contributionOffsets;
+        vector<int>                  m_contributions;
+        vector<int>                  m_lhsToFull;
+
+        /*-----------------------------------------------------------------------------
+         * Preconditioned CG. Products with lhs, vector updates and reductions are
+         * parallelized with OpenMP; of the preconditioners, only the diagonal one is 
+         * applied in parallel. The sparsity of lhs is fixed, so the symbolic analysis
+         * of the incomplete factorizations, and the aggregation and prolongators of 
+         * the multigrid hierarchy, are only computed once. CG work-vectors are 
+         * retained between steps.
+         *-----------------------------------------------------------------------------*/
+        Preconditioner               m_preconditioner;
+        bool                         m_patternAnalyzed;
+        int                          m_iterations;
+        float                        m_error;
+        VectorXf                     m_invDiagonal;
+        IncompleteCholesky<float>    m_incompleteCholesky;
+        IncompleteLUT<float>         m_incompleteLUT;
+        AlgebraicMultigrid           m_multigrid;
+        VectorXf                     m_cgResidual;
+        VectorXf                     m_cgDirection;
+        VectorXf                     m_cgProduct;
+        VectorXf                     m_cgPreconditioned;
+
+        void Solve(bool refactorize);
+        void Precondition(const VectorXf &r, VectorXf &z);
+        void ApplyLhs(const float *x, float *y);
+
+        /*-----------------------------------------------------------------------------
+         * Factorization reuse: m_coefficientVersion is incremented whenever the 
+         * coefficients change. A and lhs are only reassembled for a new version. Once
+         * a version has been used for two consecutive steps, lhs is factorized and 
+         * subsequent steps are solved directly until the coefficients change.
+         *-----------------------------------------------------------------------------*/
+        bool                         m_reuseFactorization;
+        int                          m_coefficientVersion;
+        int                          m_assembledVersion;
+        int                          m_factorizedVersion;
+        bool                         m_patternFactorized;
+        SimplicialLDLT<SparseMatrix<float> > m_ldlt;
+
+        bool SolveFactorized();
+
+        /*-----------------------------------------------------------------------------
+         * Matrix-free solution: A, B and lhs are not assembled; instead, lhs and B are
+         * applied by m_operator, and only diagonal preconditioning is available.
+         *-----------------------------------------------------------------------------*/
+        DiffusionOperator            *m_operator;
 
+        void InitializeSparsity();
         void AssembleA();
         void AssembleB();
         void AssembleRHS();
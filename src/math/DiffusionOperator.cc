@@ -0,0 +1,412 @@
+/*
+ * =====================================================================================
+ * Scalable PaleoGeomorphology Model (SPGM)
+ *
+ * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * This program is free software; you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
+ * Place, Suite 330, Boston, MA 02111-1307 USA
+ * ===================================================================================== 
+ */
+/*
+ * =====================================================================================
+ *
+ *       Filename:  DiffusionOperator.cc
+ *
+ *    Description:  Matrix-free, edge-based operator for the P1 diffusion system
+ *
+ *        Version:  1.0
+ *        Created:  18/10/26 11:02:37
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * =====================================================================================
+ */
+
+#include <DiffusionOperator.hh>
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+
+namespace src { namespace math {
+    using namespace std;
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  DiffusionOperator
+     *      Method:  DiffusionOperator :: DiffusionOperator
+     * Description:  Constructor
+     *--------------------------------------------------------------------------------------
+     */
+    DiffusionOperator::DiffusionOperator(const SurfaceTopology *st, int nFreeNodes):
+    m_nMeshPoints(st->GetNMeshPoints()),
+    m_nFreeNodes(nFreeNodes),
+    m_nInteriorEdges(0)
+    {
+        BuildEdges(st);
+        ColourEdges();
+        
+        m_edgeValues.assign(m_edgeI.size(), 0);
+        m_diagonal = m_diagonalMass;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  DiffusionOperator
+     *      Method:  DiffusionOperator :: ~DiffusionOperator
+     * Description:  Destructor
+     *--------------------------------------------------------------------------------------
+     */
+    DiffusionOperator::~DiffusionOperator()
+    {
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  DiffusionOperator
+     *      Method:  DiffusionOperator :: BuildEdges
+     * Description:  Extracts unique edges incident to free nodes, along with the unit-
+     *               coefficient stiffness (cotangent weight) contributed by each adjacent
+     *               element, and the edge- and diagonal-entries of the mass matrix
+     *--------------------------------------------------------------------------------------
+     */
+    void DiffusionOperator::BuildEdges(const SurfaceTopology *st)
+    {
+        const unsigned int **triIndices     = st->GetTriangleIndices();
+        int numTriangles                    = st->GetNumTriangles();
+        
+        /*-----------------------------------------------------------------------------
+         * Bucket element-edges by their lower node-id, keyed by the higher one
+         *-----------------------------------------------------------------------------*/
+        vector<int> offsets(m_nMeshPoints+1, 0);
+        for(int ie=0; ie<numTriangles; ie++)
+        {
+            for(int k=0; k<3; k++)
+            {
+                int a = triIndices[ie][k], b = triIndices[ie][(k+1)%3];
+                offsets[min(a, b)+1]++;
+            }
+        }
+        for(int i=0; i<m_nMeshPoints; i++) offsets[i+1] += offsets[i];
+
+        vector<int> fill(offsets.begin(), offsets.end()-1);
+        vector< pair<int, int> > buckets(3*numTriangles); /* (higher node-id, element-edge) */
+        m_diagonalMass.setZero(m_nFreeNodes);
+        for(int ie=0; ie<numTriangles; ie++)
+        {
+            const unsigned int *v = triIndices[ie];
+            for(int k=0; k<3; k++)
+            {
+                int a = v[k], b = v[(k+1)%3];
+                buckets[fill[min(a, b)]++] = make_pair(max(a, b), 3*ie + k);
+            }
+        }
+        
+        /*-----------------------------------------------------------------------------
+         * Element geometry: the stiffness entry for the edge opposite vertex k of a 
+         * triangle of area T is (b_i*b_j + c_i*c_j)/(4T), where (b,c) are the scaled 
+         * shape-function gradients of its end-points i and j
+         *-----------------------------------------------------------------------------*/
+        vector<float> stiffness(3*numTriangles);
+        vector<float> determinants(numTriangles);
+        for(int ie=0; ie<numTriangles; ie++)
+        {
+            const unsigned int *v = triIndices[ie];
+            float b[3], c[3];
+            for(int k=0; k<3; k++)
+            {
+                int j = v[(k+1)%3], l = v[(k+2)%3];
+                b[k] = st->Y(j) - st->Y(l);
+                c[k] = st->X(l) - st->X(j);
+            }
+            
+            float det = fabs(c[2]*b[1] - c[1]*b[2]);
+            assert(det > 0);
+            determinants[ie] = det;
+            
+            for(int k=0; k<3; k++)
+            {
+                int i = k, j = (k+1)%3;
+                stiffness[3*ie + k] = (b[i]*b[j] + c[i]*c[j]) / (2.0f * det);
+            }
+
+            for(int k=0; k<3; k++) 
+                if((int)v[k] < m_nFreeNodes) m_diagonalMass[v[k]] += det / 12.0f;
+        }
+
+        /*-----------------------------------------------------------------------------
+         * Merge element-edges into unique edges. Edges between Dirichlet nodes are 
+         * dropped.
+         *-----------------------------------------------------------------------------*/
+        vector<int> edgeI, edgeJ, edgeElements;
+        vector<float> edgeStiffness, edgeMass;
+        for(int i=0; i<min(m_nFreeNodes, m_nMeshPoints); i++)
+        {
+            sort(buckets.begin() + offsets[i], buckets.begin() + offsets[i+1]);
+            
+            for(int k=offsets[i]; k<offsets[i+1]; k++)
+            {
+                int j = buckets[k].first;
+                int ee = buckets[k].second;
+                
+                if((k == offsets[i]) || (buckets[k-1].first != j))
+                {
+                    edgeI.push_back(i);
+                    edgeJ.push_back(j);
+                    edgeElements.push_back(ee/3);
+                    edgeElements.push_back(-1);
+                    edgeStiffness.push_back(stiffness[ee]);
+                    edgeStiffness.push_back(0);
+                    edgeMass.push_back(determinants[ee/3] / 24.0f);
+                }
+                else
+                {
+                    int e = edgeI.size() - 1;
+                    if(edgeElements[2*e+1] != -1)
+                    {
+                        cerr << "Error: edge (" << i << ", " << j << ") is shared by more "
+                             << "than two triangles. Aborting.." << endl;
+                        exit(EXIT_FAILURE);
+                    }
+                    edgeElements[2*e+1] = ee/3;
+                    edgeStiffness[2*e+1] = stiffness[ee];
+                    edgeMass[e] += determinants[ee/3] / 24.0f;
+                }
+            }
+        }
+
+        /*-----------------------------------------------------------------------------
+         * Free nodes precede Dirichlet nodes and i < j, so edges between free nodes 
+         * are those with j < m_nFreeNodes
+         *-----------------------------------------------------------------------------*/
+        int nEdges = edgeI.size();
+        vector<int> order;
+        order.reserve(nEdges);
+        for(int e=0; e<nEdges; e++) if(edgeJ[e] <  m_nFreeNodes) order.push_back(e);
+        m_nInteriorEdges = order.size();
+        for(int e=0; e<nEdges; e++) if(edgeJ[e] >= m_nFreeNodes) order.push_back(e);
+
+        m_edgeI.resize(nEdges);
+        m_edgeJ.resize(nEdges);
+        m_edgeElements.resize(2*nEdges);
+        m_edgeStiffness.resize(2*nEdges);
+        m_edgeMass.resize(nEdges);
+        for(int e=0; e<nEdges; e++)
+        {
+            int o = order[e];
+            m_edgeI[e] = edgeI[o];
+            m_edgeJ[e] = edgeJ[o];
+            m_edgeMass[e] = edgeMass[o];
+            for(int k=0; k<2; k++)
+            {
+                m_edgeElements[2*e+k] = edgeElements[2*o+k];
+                m_edgeStiffness[2*e+k] = edgeStiffness[2*o+k];
+            }
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  DiffusionOperator
+     *      Method:  DiffusionOperator :: ColourEdges
+     * Description:  Greedily colours edges between free nodes, such that no two edges of
+     *               a colour share a node, and reorders them by colour. Within a colour,
+     *               edges retain their (node-sorted) order.
+     *--------------------------------------------------------------------------------------
+     */
+    void DiffusionOperator::ColourEdges()
+    {
+        vector< vector<int> > nodeColours(m_nFreeNodes);
+        vector<int> edgeColours(m_nInteriorEdges);
+        int nColours = 0;
+
+        for(int e=0; e<m_nInteriorEdges; e++)
+        {
+            const vector<int> &ci = nodeColours[m_edgeI[e]];
+            const vector<int> &cj = nodeColours[m_edgeJ[e]];
+            
+            int c = 0;
+            while( (find(ci.begin(), ci.end(), c) != ci.end()) || 
+                   (find(cj.begin(), cj.end(), c) != cj.end()) ) c++;
+            
+            edgeColours[e] = c;
+            nodeColours[m_edgeI[e]].push_back(c);
+            nodeColours[m_edgeJ[e]].push_back(c);
+            nColours = max(nColours, c+1);
+        }
+
+        /*-----------------------------------------------------------------------------
+         * Counting-sort interior edges by colour
+         *-----------------------------------------------------------------------------*/
+        m_colourOffsets.assign(nColours+1, 0);
+        for(int e=0; e<m_nInteriorEdges; e++) m_colourOffsets[edgeColours[e]+1]++;
+        for(int c=0; c<nColours; c++) m_colourOffsets[c+1] += m_colourOffsets[c];
+
+        vector<int> fill(m_colourOffsets.begin(), m_colourOffsets.end()-1);
+        vector<int> order(m_nInteriorEdges);
+        for(int e=0; e<m_nInteriorEdges; e++) order[fill[edgeColours[e]]++] = e;
+
+        vector<int> edgeI(m_edgeI), edgeJ(m_edgeJ), edgeElements(m_edgeElements);
+        vector<float> edgeStiffness(m_edgeStiffness), edgeMass(m_edgeMass);
+        for(int e=0; e<m_nInteriorEdges; e++)
+        {
+            int o = order[e];
+            m_edgeI[e] = edgeI[o];
+            m_edgeJ[e] = edgeJ[o];
+            m_edgeMass[e] = edgeMass[o];
+            for(int k=0; k<2; k++)
+            {
+                m_edgeElements[2*e+k] = edgeElements[2*o+k];
+                m_edgeStiffness[2*e+k] = edgeStiffness[2*o+k];
+            }
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  DiffusionOperator
+     *      Method:  DiffusionOperator :: Update
+     * Description:  Computes edge-values and the diagonal of dt*A + B for the given 
+     *               element coefficients. Rows of A sum to zero, so its diagonal is the 
+     *               negated sum of the off-diagonal entries, including those coupling 
+     *               to Dirichlet nodes.
+     *--------------------------------------------------------------------------------------
+     */
+    void DiffusionOperator::Update(const VectorXf &coefficient, float dt)
+    {
+        int nEdges                          = m_edgeI.size();
+        const float *c                      = coefficient.data();
+        const int *elements                 = &m_edgeElements[0];
+        const float *stiffness              = &m_edgeStiffness[0];
+        const float *mass                   = &m_edgeMass[0];
+        float *values                       = &m_edgeValues[0];
+        
+        #pragma omp parallel for
+        for(int e=0; e<nEdges; e++)
+        {
+            int e0 = elements[2*e], e1 = elements[2*e+1];
+            float a = stiffness[2*e] * c[e0];
+            if(e1 >= 0) a += stiffness[2*e+1] * c[e1];
+            
+            values[e] = dt * a + mass[e];
+        }
+
+        /* Interior edges contribute to the diagonal at both end-points, the others 
+         * only at I */
+        m_diagonal = m_diagonalMass;
+        float *d                            = m_diagonal.data();
+        for(int k=0; k<(int)m_colourOffsets.size()-1; k++)
+        {
+            #pragma omp parallel for
+            for(int e=m_colourOffsets[k]; e<m_colourOffsets[k+1]; e++)
+            {
+                d[m_edgeI[e]] -= values[e] - mass[e];
+                d[m_edgeJ[e]] -= values[e] - mass[e];
+            }
+        }
+        for(int e=m_nInteriorEdges; e<nEdges; e++) d[m_edgeI[e]] -= values[e] - mass[e];
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  DiffusionOperator
+     *      Method:  DiffusionOperator :: ScatterEdges
+     * Description:  Adds the products of the given symmetric edge-values with x to y, 
+     *               colour by colour. Edges coupling to Dirichlet nodes are only included
+     *               on request, in which case x must span all nodes.
+     *--------------------------------------------------------------------------------------
+     */
+    void DiffusionOperator::ScatterEdges(const vector<float> &values, const float *x, 
+                                         float *y, bool includeDirichlet) const
+    {
+        const int *ei                       = &m_edgeI[0];
+        const int *ej                       = &m_edgeJ[0];
+        const float *v                      = &values[0];
+        int nColours                        = m_colourOffsets.size() - 1;
+        int nEdges                          = m_edgeI.size();
+
+        #pragma omp parallel
+        {
+            for(int c=0; c<nColours; c++)
+            {
+                #pragma omp for
+                for(int e=m_colourOffsets[c]; e<m_colourOffsets[c+1]; e++)
+                {
+                    int i = ei[e], j = ej[e];
+                    float w = v[e];
+                    
+                    y[i] += w * x[j];
+                    y[j] += w * x[i];
+                }
+            }
+        }
+
+        if(includeDirichlet)
+        {
+            for(int e=m_nInteriorEdges; e<nEdges; e++) y[ei[e]] += v[e] * x[ej[e]];
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  DiffusionOperator
+     *      Method:  DiffusionOperator :: Apply
+     * Description:  y = (dt*A + B) x, for x and y spanning free nodes
+     *--------------------------------------------------------------------------------------
+     */
+    void DiffusionOperator::Apply(const float *x, float *y) const
+    {
+        const float *d                      = m_diagonal.data();
+        
+        #pragma omp parallel for
+        for(int i=0; i<m_nFreeNodes; i++) y[i] = d[i] * x[i];
+
+        ScatterEdges(m_edgeValues, x, y, false);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  DiffusionOperator
+     *      Method:  DiffusionOperator :: AddMass
+     * Description:  y += B x on free nodes, for x spanning all nodes
+     *--------------------------------------------------------------------------------------
+     */
+    void DiffusionOperator::AddMass(const float *x, float *y) const
+    {
+        const float *d                      = m_diagonalMass.data();
+        
+        #pragma omp parallel for
+        for(int i=0; i<m_nFreeNodes; i++) y[i] += d[i] * x[i];
+
+        ScatterEdges(m_edgeMass, x, y, true);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  DiffusionOperator
+     *      Method:  DiffusionOperator :: SubtractDirichlet
+     * Description:  y -= (dt*A + B) u_d on free nodes, where u_d holds values at 
+     *               Dirichlet nodes
+     *--------------------------------------------------------------------------------------
+     */
+    void DiffusionOperator::SubtractDirichlet(const float *dirichlet, float *y) const
+    {
+        int nEdges                          = m_edgeI.size();
+        
+        for(int e=m_nInteriorEdges; e<nEdges; e++) 
+            y[m_edgeI[e]] -= m_edgeValues[e] * dirichlet[m_edgeJ[e]];
+    }
+}}
@@ -0,0 +1,110 @@
+/*
+ * =====================================================================================
+ * Scalable PaleoGeomorphology Model (SPGM)
+ *
+ * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * This program is free software; you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
+ * Place, Suite 330, Boston, MA 02111-1307 USA
+ * ===================================================================================== 
+ */
+/*
+ * =====================================================================================
+ *
+ *       Filename:  DiffusionOperator.hh
+ *
+ *    Description:  Matrix-free, edge-based operator for the P1 diffusion system
+ *
+ *        Version:  1.0
+ *        Created:  18/10/26 11:02:37
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * =====================================================================================
+ */
+#ifndef SRC_MATH_DIFFUSION_OPERATOR_HH
+#define SRC_MATH_DIFFUSION_OPERATOR_HH
+
+#include <vector>
+#include <SurfaceTopology.hh>
+
+#include <Eigen/Dense>
+
+namespace src{ namespace math {
+    using namespace Eigen;
+    using namespace std;
+    using src::mesh::SurfaceTopology;
+    
+    /*
+     * =====================================================================================
+     *        Class:  DiffusionOperator
+     *  Description:  Applies dt*A + B, restricted to free nodes, without assembling 
+     *                either matrix. For P1 elements, the off-diagonal entries of the 
+     *                stiffness matrix A are sums of cotangent weights of the (up to two) 
+     *                elements sharing an edge, scaled by element coefficients, and its
+     *                rows sum to zero; entries of the mass matrix B only depend on 
+     *                element areas. Values are thus stored once per edge, in flat 
+     *                (structure-of-arrays) edge lists. Edges between free nodes are 
+     *                grouped by colour, such that no two edges of a colour share a node,
+     *                so that each colour can be scattered in parallel without conflicts.
+     *                Free nodes must precede Dirichlet nodes.
+     * =====================================================================================
+     */
+    class DiffusionOperator
+    {
+        public:
+        DiffusionOperator(const SurfaceTopology *st, int nFreeNodes);
+        ~DiffusionOperator();
+
+        void Update(const VectorXf &coefficient, float dt);
+        
+        void Apply(const float *x, float *y) const;
+        void AddMass(const float *x, float *y) const;
+        void SubtractDirichlet(const float *dirichlet, float *y) const;
+        
+        const VectorXf &Diagonal() const { return m_diagonal; }
+        int rows() const { return m_nFreeNodes; }
+        int cols() const { return m_nFreeNodes; }
+        long int GetNumEdges() const { return m_edgeI.size(); }
+
+        private:
+        int                          m_nMeshPoints;
+        int                          m_nFreeNodes;
+
+        /*-----------------------------------------------------------------------------
+         * Edge lists: edges between free nodes, ordered by colour, followed by edges
+         * between a free node (I) and a Dirichlet node (J). Edges between Dirichlet 
+         * nodes do not contribute to free rows and are omitted.
+         *-----------------------------------------------------------------------------*/
+        vector<int>                  m_edgeI;
+        vector<int>                  m_edgeJ;
+        vector<int>                  m_edgeElements;        /* 2 per edge, -1 if absent */
+        vector<float>                m_edgeStiffness;       /* Unit-coefficient, 2 per edge */
+        vector<float>                m_edgeMass;
+        vector<float>                m_edgeValues;          /* Off-diagonal of dt*A + B */
+        vector<int>                  m_colourOffsets;
+        int                          m_nInteriorEdges;
+
+        VectorXf                     m_diagonalMass;
+        VectorXf                     m_diagonal;            /* Diagonal of dt*A + B */
+
+        void BuildEdges(const SurfaceTopology *st);
+        void ColourEdges();
+        void ScatterEdges(const vector<float> &values, const float *x, float *y, 
+                          bool includeDirichlet) const;
+    };
+}}
+#endif
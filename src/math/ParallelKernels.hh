@@ -0,0 +1,86 @@
+/*
+ * =====================================================================================
+ * Scalable PaleoGeomorphology Model (SPGM)
+ *
+ * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * This program is free software; you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
+ * Place, Suite 330, Boston, MA 02111-1307 USA
+ * ===================================================================================== 
+ */
+/*
+ * =====================================================================================
+ *
+ *       Filename:  ParallelKernels.hh
+ *
+ *    Description:  OpenMP-parallel vector and sparse matrix kernels
+ *
+ *        Version:  1.0
+ *        Created:  18/10/26 15:20:11
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * =====================================================================================
+ */
+#ifndef SRC_MATH_PARALLEL_KERNELS_HH
+#define SRC_MATH_PARALLEL_KERNELS_HH
+
+#include <Eigen/Sparse>
+
+namespace src{ namespace math {
+    using namespace Eigen;
+    
+    /* 
+     * ===  FUNCTION  ======================================================================
+     *         Name:  Dot
+     *  Description:  Parallel dot-product of two vectors of length n, accumulated in 
+     *                double precision
+     * =====================================================================================
+     */
+    inline double Dot(int n, const float *a, const float *b)
+    {
+        double sum = 0;
+        
+        #pragma omp parallel for reduction(+:sum)
+        for(int i=0; i<n; i++) sum += a[i] * b[i];
+
+        return sum;
+    }
+
+    /* 
+     * ===  FUNCTION  ======================================================================
+     *         Name:  Multiply
+     *  Description:  Parallel product of a compressed row-major sparse matrix with x,
+     *                stored in, or added to, y
+     * =====================================================================================
+     */
+    inline void Multiply(const SparseMatrix<float, RowMajor> &m, const float *x, float *y, bool add)
+    {
+        const int *outer                    = m.outerIndexPtr();
+        const int *inner                    = m.innerIndexPtr();
+        const float *values                 = m.valuePtr();
+        int rows                            = m.rows();
+        
+        #pragma omp parallel for
+        for(int i=0; i<rows; i++)
+        {
+            float sum = add ? y[i] : 0;
+            for(int k=outer[i]; k<outer[i+1]; k++) sum += values[k] * x[inner[k]];
+            y[i] = sum;
+        }
+    }
+}}
+#endif
@@ -0,0 +1,162 @@
+/*
+ * =====================================================================================
+ * Scalable PaleoGeomorphology Model (SPGM)
+ *
+ * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * This program is free software; you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
+ * Place, Suite 330, Boston, MA 02111-1307 USA
+ * ===================================================================================== 
+ */
+/*
+ * =====================================================================================
+ *
+ *       Filename:  DrainageNetwork.cc
+ *
+ *    Description:  Linear-time extraction of channel segments from a drainage network
+ *
+ *        Version:  1.0
+ *        Created:  18/10/26 10:00:00
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * =====================================================================================
+ */
+#include <DrainageNetwork.hh>
+
+namespace src { namespace mesh {
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  DrainageNetwork
+     *      Method:  DrainageNetwork :: DrainageNetwork
+     * Description:  Constructor
+     *--------------------------------------------------------------------------------------
+     */
+    DrainageNetwork::DrainageNetwork()
+    {
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  DrainageNetwork
+     *      Method:  DrainageNetwork :: ~DrainageNetwork
+     * Description:  Destructor
+     *--------------------------------------------------------------------------------------
+     */
+    DrainageNetwork::~DrainageNetwork()
+    {
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  DrainageNetwork
+     *      Method:  DrainageNetwork :: Extract
+     * Description:  Extracts channel segments. Each node and donor-link is visited a 
+     *               constant number of times; buffers are reused between calls.
+     *--------------------------------------------------------------------------------------
+     */
+    void DrainageNetwork::Extract(int nNodes, const int *receivers, const int *donorOffsets, const int *donors, 
+                                  const float *cellAreas, float minDrainageArea)
+    {
+        /*-----------------------------------------------------------------------------
+         * Order nodes breadth-first from outlets upstream
+         *-----------------------------------------------------------------------------*/
+        m_ordering.clear();
+        for(int i=0; i<nNodes; i++) if(receivers[i]==i) m_ordering.push_back(i);
+        
+        for(unsigned int k=0; k<m_ordering.size(); k++)
+        {
+            int node = m_ordering[k];
+            for(int j=donorOffsets[node]; j<donorOffsets[node+1]; j++) 
+            {
+                if(donors[j]!=node) m_ordering.push_back(donors[j]);
+            }
+        }
+        
+        int nOrdered = m_ordering.size();
+
+        /*-----------------------------------------------------------------------------
+         * Accumulate drainage area downstream
+         *-----------------------------------------------------------------------------*/
+        m_drainageAreas.assign(cellAreas, cellAreas+nNodes);
+        for(int k=nOrdered-1; k>=0; k--)
+        {
+            int node = m_ordering[k];
+            int receiver = receivers[node];
+
+            if(receiver!=node) m_drainageAreas[receiver] += m_drainageAreas[node];
+        }
+
+        /*-----------------------------------------------------------------------------
+         * Strahler orders of channel nodes, computed downstream
+         *-----------------------------------------------------------------------------*/
+        m_strahlerOrders.assign(nNodes, 0);
+        m_channelDonorCounts.assign(nNodes, 0);
+        for(int k=nOrdered-1; k>=0; k--)
+        {
+            int node = m_ordering[k];
+            if(m_drainageAreas[node] < minDrainageArea) continue;
+
+            int maxOrder = 0;
+            int maxOrderCount = 0;
+            for(int j=donorOffsets[node]; j<donorOffsets[node+1]; j++)
+            {
+                int donorOrder = m_strahlerOrders[donors[j]];
+                if(donors[j]==node || donorOrder==0) continue;
+
+                m_channelDonorCounts[node]++;
+                if(donorOrder > maxOrder) 
+                {
+                    maxOrder = donorOrder;
+                    maxOrderCount = 1;
+                }
+                else if(donorOrder == maxOrder) maxOrderCount++;
+            }
+
+            if(maxOrder == 0)           m_strahlerOrders[node] = 1;
+            else if(maxOrderCount > 1)  m_strahlerOrders[node] = maxOrder + 1;
+            else                        m_strahlerOrders[node] = maxOrder;
+        }
+
+        /*-----------------------------------------------------------------------------
+         * Trace segments from channel heads and confluences
+         *-----------------------------------------------------------------------------*/
+        m_segmentNodes.clear();
+        m_segmentOffsets.clear();
+        m_segmentOrders.clear();
+        m_segmentAreas.clear();
+        for(int i=0; i<nNodes; i++)
+        {
+            if(m_strahlerOrders[i]==0 || receivers[i]==i || m_channelDonorCounts[i]==1) continue;
+
+            int node = i;
+            m_segmentNodes.push_back(node);
+            while(true)
+            {
+                int receiver = receivers[node];
+                m_segmentNodes.push_back(receiver);
+                
+                if(receivers[receiver]==receiver || m_channelDonorCounts[receiver]!=1) break;
+                node = receiver;
+            }
+
+            m_segmentOffsets.push_back(m_segmentNodes.size());
+            m_segmentOrders.push_back(m_strahlerOrders[i]);
+            m_segmentAreas.push_back(m_drainageAreas[node]);
+        }
+    }
+}}
@@ -0,0 +1,92 @@
+/*
+ * =====================================================================================
+ * Scalable PaleoGeomorphology Model (SPGM)
+ *
+ * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * This program is free software; you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
+ * Place, Suite 330, Boston, MA 02111-1307 USA
+ * ===================================================================================== 
+ */
+/*
+ * =====================================================================================
+ *
+ *       Filename:  DrainageNetwork.hh
+ *
+ *    Description:  Linear-time extraction of channel segments from a drainage network
+ *
+ *        Version:  1.0
+ *        Created:  18/10/26 10:00:00
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * =====================================================================================
+ */
+#ifndef SRC_MESH_DRAINAGE_NETWORK_HH
+#define SRC_MESH_DRAINAGE_NETWORK_HH
+
+#include <vector>
+
+namespace src { namespace mesh {
+    using namespace std;
+
+    /*
+     * =====================================================================================
+     *        Class:  DrainageNetwork
+     *  Description:  Extracts channel segments from a receiver/donor graph in linear time.
+     *                Nodes whose accumulated drainage area is below a threshold are not
+     *                considered channels. A segment runs downstream from a channel head or
+     *                a confluence up to, and including, the next confluence or outlet, so
+     *                that every channel edge is emitted exactly once. Segments carry their
+     *                Strahler order and the drainage area they deliver downstream.
+     * =====================================================================================
+     */
+    class DrainageNetwork
+    {
+        public:
+        DrainageNetwork();
+        ~DrainageNetwork();
+
+        /* Donors of node i are donors[donorOffsets[i]..donorOffsets[i+1]-1] */
+        void Extract(int nNodes, const int *receivers, const int *donorOffsets, const int *donors, 
+                     const float *cellAreas, float minDrainageArea);
+
+        int GetNumSegments() const { return m_segmentOffsets.size(); }
+        
+        /* Node-ids of all segments, concatenated */
+        const vector<int> &GetSegmentNodes() const { return m_segmentNodes; }
+        /* Segment i ends (exclusively) at GetSegmentOffsets()[i] in GetSegmentNodes() */
+        const vector<int> &GetSegmentOffsets() const { return m_segmentOffsets; }
+        const vector<int> &GetSegmentOrders() const { return m_segmentOrders; }
+        const vector<float> &GetSegmentAreas() const { return m_segmentAreas; }
+        
+        /* Per-node attributes */
+        const vector<float> &GetDrainageAreas() const { return m_drainageAreas; }
+        const vector<int> &GetStrahlerOrders() const { return m_strahlerOrders; }
+        
+        private:
+        vector<int> m_ordering;         /* Nodes ordered from outlets upstream */
+        vector<float> m_drainageAreas;
+        vector<int> m_strahlerOrders;   /* 0 for non-channel nodes */
+        vector<int> m_channelDonorCounts;
+
+        vector<int> m_segmentNodes;
+        vector<int> m_segmentOffsets;
+        vector<int> m_segmentOrders;
+        vector<float> m_segmentAreas;
+    };
+}}
+#endif
@@ -1,66 +0,0 @@
-/*
- * =====================================================================================
- * Scalable PaleoGeomorphology Model (SPGM)
- *
- * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
- *
- * This program is free software; you can redistribute it and/or modify it under 
- * the terms of the GNU General Public License as published by the Free Software 
- * Foundation; either version 2 of the License, or (at your option) any later 
- * version.
- *
- * This program is distributed in the hope that it will be useful, but WITHOUT 
- * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
- * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
- * more details.
- *
- * You should have received a copy of the GNU General Public License along with
- * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
- * Place, Suite 330, Boston, MA 02111-1307 USA
- * ===================================================================================== 
- */
-/*
- * =====================================================================================
- *
- *       Filename:  KdItem.hh
- *
- *    Description:  KdTree Item
- *
- *        Version:  1.0
- *        Created:  11/06/14 14:02:26
- *       Revision:  none
- *       Compiler:  gcc
- *
- *         Author:  Rakib Hassan (rakib.hassan@sydney.edu.au)         
- *
- * =====================================================================================
- */
-#ifndef SRC_MESH_KDITEM_HH
-#define SRC_MESH_KDITEM_HH
-
-namespace src { namespace mesh {
-using namespace std;
-
-    class KdTree;
-
-    /*
-     * =====================================================================================
-     *        Class:  KdItem
-     *  Description:  KdItem
-     * =====================================================================================
-     */
-    class KdItem
-    {
-        public:
-        friend class KdTree;
-
-        KdItem();
-        void Print();
-        ~KdItem();
-
-        double m_coord[2];
-        int m_id;
-    };
-}}
-#endif
-
@@ -38,122 +38,279 @@
 
 #include <KdTree.hh>
 #include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <limits>
 namespace src { namespace mesh {
 using namespace std;
-    
-    const int DEFAULT_CHUNK_SIZE = 2048;
+
+    /*-----------------------------------------------------------------------------
+     * Orders point-indices along a dimension, for nth_element
+     *-----------------------------------------------------------------------------*/
+    struct KdCompare
+    {
+        float **coords;
+        int dim;
+        inline bool operator()(int a, int b) const { return coords[a][dim] < coords[b][dim]; }
+    };
+
+    /*-----------------------------------------------------------------------------
+     * Traversal-stack entry: node, its range of points and a lower bound on the 
+     * squared distance between the query-point and the node's region
+     *-----------------------------------------------------------------------------*/
+    struct KdStackEntry
+    {
+        int node;
+        int lo;
+        int hi;
+        float bound;
+    };
 
     /*
      *--------------------------------------------------------------------------------------
      *       Class:  KdTree
      *      Method:  KdTree :: KdTree
-     * Description:  Constructor
+     * Description:  Constructor bulk-loads n points
      *--------------------------------------------------------------------------------------
      */
-    KdTree::KdTree( int maxElems=0 )
+    KdTree::KdTree( int n, float **coords )
     {
-        m_bucketSize = 16;
-        m_itemCount = 0;
-        m_maxElems = maxElems;
+        m_n = n;
 
-        m_root = new KdNode( this );
+        /*-----------------------------------------------------------------------------
+         * Number of nodes in a tree whose leaves hold at most BUCKET_SIZE points
+         *-----------------------------------------------------------------------------*/
+        int nNodes = 1;
+        for(int size=n; size>BUCKET_SIZE; size=(size+1)/2) nNodes = 2*nNodes + 1;
 
-        /* Initialize pool */
-        if(m_maxElems==0)
-        {
-            m_pool = new MemoryPool(sizeof(KdItem), DEFAULT_CHUNK_SIZE);
-        }
-        else
+        m_splitValues.resize(nNodes);
+        m_splitDims.assign(nNodes, -1);
+
+        vector<int> index(n);
+        for(int i=0; i<n; i++) index[i] = i;
+
+        if(n) Build(0, 0, n, coords, &index[0]);
+
+        m_x.resize(n);
+        m_y.resize(n);
+        m_ids.resize(n);
+        for(int i=0; i<n; i++)
         {
-            m_pool = new MemoryPool(sizeof(KdItem), m_maxElems, MemoryPool::Fixed);
+            m_x[i]   = coords[index[i]][0];
+            m_y[i]   = coords[index[i]][1];
+            m_ids[i] = index[i];
         }
     }
 
     /*
      *--------------------------------------------------------------------------------------
      *       Class:  KdTree
-     *      Method:  KdTree :: Add
-     * Description:  Adds points to the kd-tree
+     *      Method:  KdTree :: Build
+     * Description:  Partitions points in [lo, hi) about the median along the dimension of 
+     *               largest extent
      *--------------------------------------------------------------------------------------
      */
-    void KdTree::Add( float *c, int id )
+    void KdTree::Build(int node, int lo, int hi, float **coords, int *index)
     {
-        KdItem *ki = new (m_pool->NewObject()) KdItem();
-
-        ki->m_coord[0] = c[0];
-        ki->m_coord[1] = c[1];
-        ki->m_id = id;
+        if(hi - lo <= BUCKET_SIZE) return;
 
-        if( m_root == NULL )
+        float lower[2] = {coords[index[lo]][0], coords[index[lo]][1]};
+        float upper[2] = {lower[0], lower[1]};
+        for(int i=lo+1; i<hi; i++)
         {
-            m_root = new KdNode( this );
+            for(int d=0; d<2; d++)
+            {
+                lower[d] = min(lower[d], coords[index[i]][d]);
+                upper[d] = max(upper[d], coords[index[i]][d]);
+            }
         }
 
-        m_root->Add( ki );
+        KdCompare compare = {coords, (upper[0]-lower[0]) >= (upper[1]-lower[1]) ? 0 : 1};
+        int mid = (lo + hi) / 2;
+        nth_element(index + lo, index + mid, index + hi, compare);
+
+        m_splitDims[node]   = compare.dim;
+        m_splitValues[node] = coords[index[mid]][compare.dim];
 
-        m_itemCount++;
+        Build(2*node+1, lo, mid, coords, index);
+        Build(2*node+2, mid, hi, coords, index);
     }
 
     /*
      *--------------------------------------------------------------------------------------
      *       Class:  KdTree
-     *      Method:  KdTree :: Print
-     * Description:  Prints kd-tree nodes
+     *      Method:  KdTree :: QueryRadius
+     * Description:  Points in [lo, mid) lie on or below the split-value of a node and 
+     *               points in [mid, hi) on or above it.
      *--------------------------------------------------------------------------------------
      */
-    void KdTree::Print()
+    int KdTree::QueryRadius(const float *pos, float r, int maxResults, int *ids, float *distances) const
     {
-        if( m_root )
+        if(m_n == 0) return 0;
+
+        KdStackEntry stack[MAX_DEPTH];
+        int top = 0;
+        int count = 0;
+        float r2 = r*r;
+
+        KdStackEntry root = {0, 0, m_n, 0};
+        stack[top++] = root;
+        
+        while(top)
         {
-            m_root->Print();
+            KdStackEntry e = stack[--top];
+
+            if(IsLeaf(e.node))
+            {
+                for(int i=e.lo; i<e.hi; i++)
+                {
+                    float dx = m_x[i] - pos[0];
+                    float dy = m_y[i] - pos[1];
+                    float d2 = dx*dx + dy*dy;
+
+                    if(d2 < r2)
+                    {
+                        if(count < maxResults)
+                        {
+                            ids[count] = m_ids[i];
+                            distances[count] = sqrt(d2);
+                        }
+                        count++;
+                    }
+                }
+                continue;
+            }
+
+            int dim = m_splitDims[e.node];
+            float split = m_splitValues[e.node];
+            int mid = (e.lo + e.hi) / 2;
+
+            if(pos[dim] - r <= split)
+            {
+                KdStackEntry left = {2*e.node+1, e.lo, mid, 0};
+                stack[top++] = left;
+            }
+            if(pos[dim] + r >= split)
+            {
+                KdStackEntry right = {2*e.node+2, mid, e.hi, 0};
+                stack[top++] = right;
+            }
         }
+
+        return count;
     }
 
     /*
      *--------------------------------------------------------------------------------------
      *       Class:  KdTree
-     *      Method:  KdTree :: Range
-     * Description:  Returns all the KdItems that are within [lower[..], upper[..]]
+     *      Method:  KdTree :: QueryNearest
+     * Description:  Depth-first search, descending into the nearer child first. The k 
+     *               nearest points found so far are kept sorted in the output buffers and
+     *               subtrees farther than the current k-th distance are pruned.
      *--------------------------------------------------------------------------------------
      */
-    void KdTree::Range( double *upper, double *lower, vector<KdItem*> *result )
+    int KdTree::QueryNearest(const float *pos, int k, int *ids, float *distances) const
     {
-        if( m_root )
+        k = min(k, m_n);
+        if(k <= 0) return 0;
+
+        KdStackEntry stack[MAX_DEPTH];
+        int top = 0;
+        int count = 0;
+        float worst = numeric_limits<float>::max(); /* Squared distance of k-th point */
+
+        KdStackEntry root = {0, 0, m_n, 0};
+        stack[top++] = root;
+        
+        while(top)
         {
-            m_root->Range( upper, lower, result );
+            KdStackEntry e = stack[--top];
+            if((count == k) && (e.bound >= worst)) continue;
+
+            if(IsLeaf(e.node))
+            {
+                for(int i=e.lo; i<e.hi; i++)
+                {
+                    float dx = m_x[i] - pos[0];
+                    float dy = m_y[i] - pos[1];
+                    float d2 = dx*dx + dy*dy;
+                    
+                    if((count == k) && (d2 >= worst)) continue;
+
+                    /* Insertion into sorted buffers; distances hold squares until the end */
+                    int j = (count < k) ? count++ : k-1;
+                    while((j > 0) && (distances[j-1] > d2))
+                    {
+                        distances[j] = distances[j-1];
+                        ids[j] = ids[j-1];
+                        j--;
+                    }
+                    distances[j] = d2;
+                    ids[j] = m_ids[i];
+                    
+                    if(count == k) worst = distances[k-1];
+                }
+                continue;
+            }
+
+            int dim = m_splitDims[e.node];
+            float diff = pos[dim] - m_splitValues[e.node];
+            int mid = (e.lo + e.hi) / 2;
+
+            KdStackEntry left  = {2*e.node+1, e.lo, mid, e.bound};
+            KdStackEntry right = {2*e.node+2, mid, e.hi, e.bound};
+            
+            /* Far child is pushed first, so that the near child is visited first */
+            if(diff < 0)
+            {
+                right.bound = max(e.bound, diff*diff);
+                stack[top++] = right;
+                stack[top++] = left;
+            }
+            else
+            {
+                left.bound = max(e.bound, diff*diff);
+                stack[top++] = left;
+                stack[top++] = right;
+            }
         }
+
+        for(int i=0; i<count; i++) distances[i] = sqrt(distances[i]);
+        return count;
     }
 
     /*
      *--------------------------------------------------------------------------------------
      *       Class:  KdTree
-     *      Method:  KdTree :: DeleteAll
-     * Description:  Deletes all entries
+     *      Method:  KdTree :: QueryRadius
+     * Description:  Batched radius queries
      *--------------------------------------------------------------------------------------
      */
-    void KdTree::DeleteAll()
+    void KdTree::QueryRadius(int nPos, const float *pos, float r, int maxResults, 
+                             int *counts, int *ids, float *distances) const
     {
-        if( m_root )
+        #pragma omp parallel for schedule(dynamic, 256)
+        for(int i=0; i<nPos; i++)
         {
-            m_root->DeleteHelper();
-            delete m_root;
-
-            m_root = NULL;
+            counts[i] = QueryRadius(pos + 2*i, r, maxResults, 
+                                    ids + long(i)*maxResults, distances + long(i)*maxResults);
         }
-
-        m_itemCount = 0;
     }
 
     /*
      *--------------------------------------------------------------------------------------
      *       Class:  KdTree
-     *      Method:  KdTree :: Size
-     * Description:  Returns the size of the kd-tree
+     *      Method:  KdTree :: QueryNearest
+     * Description:  Batched k-nearest-neighbour queries
      *--------------------------------------------------------------------------------------
      */
-    int KdTree::Size()
+    void KdTree::QueryNearest(int nPos, const float *pos, int k, int *ids, float *distances) const
     {
-        return m_itemCount;
+        #pragma omp parallel for schedule(dynamic, 256)
+        for(int i=0; i<nPos; i++)
+        {
+            QueryNearest(pos + 2*i, k, ids + long(i)*k, distances + long(i)*k);
+        }
     }
 
     /*
@@ -164,43 +321,56 @@ using namespace std;
      *               distances
      *--------------------------------------------------------------------------------------
      */
-    void KdTree::QueryBallPoint(float *pos, float r, vector<float> *distance, vector<int> *id)
+    void KdTree::QueryBallPoint(float *pos, float r, vector<float> *distance, vector<int> *id) const
     {
-        vector<KdItem*> initialResults;
-        double upper[2];
-        double lower[2];
+        distance->resize(max(int(distance->capacity()), BUCKET_SIZE));
+        id->resize(distance->size());
 
-        for(int i=0; i<2; i++) 
+        int count = QueryRadius(pos, r, id->size(), &(*id)[0], &(*distance)[0]);
+        if(count > int(id->size()))
         {
-            lower[i] = pos[i] - r;
-            upper[i] = pos[i] + r;
+            distance->resize(count);
+            id->resize(count);
+            QueryRadius(pos, r, count, &(*id)[0], &(*distance)[0]);
         }
 
-        Range(upper, lower, &initialResults);
+        distance->resize(count);
+        id->resize(count);
+    }
 
-        /*-----------------------------------------------------------------------------
-         * Filter out points that lie outside the r-sphere
-         *-----------------------------------------------------------------------------*/
-        distance->clear();
-        id->clear();
-        for(vector<KdItem*>::iterator rit = initialResults.begin();
-            rit != initialResults.end(); rit++)
-        {
-            double dist = 0.;
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  KdTree
+     *      Method:  KdTree :: Print
+     * Description:  Prints leaf buckets
+     *--------------------------------------------------------------------------------------
+     */
+    void KdTree::Print() const
+    {
+        KdStackEntry stack[MAX_DEPTH];
+        int top = 0;
 
-            for(int i=0; i<2; i++)
-            {
-                double diff = (*rit)->m_coord[i] - pos[i];
-                dist += diff*diff;
-            }
+        if(m_n == 0) return;
 
-            dist = sqrt(dist);
+        KdStackEntry root = {0, 0, m_n, 0};
+        stack[top++] = root;
+        
+        while(top)
+        {
+            KdStackEntry e = stack[--top];
 
-            if(dist < r)
+            if(IsLeaf(e.node))
             {
-                distance->push_back(dist);
-                id->push_back((*rit)->m_id);
+                printf("Leaf %d:\n", e.node);
+                for(int i=e.lo; i<e.hi; i++) printf("\t%d (%f, %f)\n", m_ids[i], m_x[i], m_y[i]);
+                continue;
             }
+            
+            int mid = (e.lo + e.hi) / 2;
+            KdStackEntry right = {2*e.node+2, mid, e.hi, 0};
+            KdStackEntry left  = {2*e.node+1, e.lo, mid, 0};
+            stack[top++] = right;
+            stack[top++] = left;
         }
     }
 
@@ -213,7 +383,5 @@ using namespace std;
      */
     KdTree::~KdTree()
     {
-        DeleteAll();
-        delete m_pool;
     }
 }}
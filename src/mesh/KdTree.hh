@@ -38,61 +38,77 @@
 #ifndef SRC_MESH_KDTREE_HH
 #define SRC_MESH_KDTREE_HH
 
-#include <Timer.hh>
-#include <KdItem.hh>
-#include <KdNode.hh>
-#include <MemoryPool.hh>
+#include <vector>
 
 namespace src { namespace mesh {
     using namespace std;
-    using namespace src::mem;
 
     /*
      * =====================================================================================
      *        Class:  KdTree
-     *  Description:  kd-tree definition for spatial analysis
+     *  Description:  Static 2D kd-tree for spatial analysis. The tree is bulk-loaded by 
+     *                recursive median-partitioning (nth_element) of a flat index array 
+     *                and is implicit: node k spans a range of points that follows from the
+     *                number of points alone, its children being 2k+1 and 2k+2, so that 
+     *                only a split-value and a split-dimension are stored per node. Points
+     *                are stored in tree-order, so that leaf buckets are contiguous.
+     *                
+     *                Queries write into caller-provided buffers and do not allocate; 
+     *                being const, they can be issued concurrently from several threads.
      * =====================================================================================
      */
     class KdTree
     {
         public:
 
-        friend class src::mesh::KdNode;
-
         /*-----------------------------------------------------------------------------
          * Public interface
          *-----------------------------------------------------------------------------*/
-        KdTree( int maxElems );
+        KdTree( int n, float **coords );
+        ~KdTree();
 
-        void Add( float *c, int id );
+        int Size() const { return m_n; }
 
-        void Print();
+        /* Ids of up to maxResults points within distance r of pos, along with their 
+         * distances, in no particular order. Returns the number of points within r, 
+         * which can exceed maxResults. */
+        int QueryRadius(const float *pos, float r, int maxResults, int *ids, float *distances) const;
 
-        void DeleteAll();
+        /* Ids of the k nearest points, ordered by increasing distance. Returns the 
+         * number of points found, min(k, Size()). */
+        int QueryNearest(const float *pos, int k, int *ids, float *distances) const;
 
-        int Size();
+        /* Batched queries over nPos positions (pos[2*i], pos[2*i+1]), processed in 
+         * parallel. Results for position i are written at offset i*maxResults (radius)
+         * or i*k (nearest). */
+        void QueryRadius(int nPos, const float *pos, float r, int maxResults, 
+                         int *counts, int *ids, float *distances) const;
+        void QueryNearest(int nPos, const float *pos, int k, int *ids, float *distances) const;
 
-        void QueryBallPoint(float *pos, float r, vector<float> *distance, vector<int> *id);
+        void QueryBallPoint(float *pos, float r, vector<float> *distance, vector<int> *id) const;
 
-        ~KdTree();
+        void Print() const;
 
         private:
         
         /*-----------------------------------------------------------------------------
          * Private internals
          *-----------------------------------------------------------------------------*/
-        void Range( double *upper, double *lower, vector<KdItem*> *result );
+        static const int BUCKET_SIZE = 16;
+        static const int MAX_DEPTH   = 64;
 
-        int m_bucketSize;
-        int m_itemCount;
-        int m_maxElems;
+        int m_n;
+        vector<float> m_x;              /* Coordinates in tree-order */
+        vector<float> m_y;
+        vector<int> m_ids;              /* Original ids in tree-order */
+        vector<float> m_splitValues;    /* Per node */
+        vector<char> m_splitDims;       /* Per node; -1 for leaves */
 
-        KdNode *m_root;
-
-        /* pool */
-        MemoryPool *m_pool;
+        void Build(int node, int lo, int hi, float **coords, int *index);
+        
+        inline bool IsLeaf(int node) const { return m_splitDims[node] < 0; }
+        inline const float *Coordinates(int dim) const { return dim ? &m_y[0] : &m_x[0]; }
     };
 
 }}
 #endif
-
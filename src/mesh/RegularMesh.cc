@@ -37,6 +37,7 @@
  */
 
 #include <RegularMesh.hh>
+#include <stdio.h>
 #include <math.h>
 #include <assert.h>
 namespace src { namespace mesh {
@@ -76,8 +77,8 @@ using namespace std;
         {
             for(int j=0; j<m_ny; j++)
             {
-                m_coords[i*m_nx+j][0]   = i*m_dx;
-                m_coords[i*m_nx+j][1]   = j*m_dy;
+                m_coords[i*m_ny+j][0]   = i*m_dx;
+                m_coords[i*m_ny+j][1]   = j*m_dy;
                 m_values(i,j)           = 0;
             }
         }
@@ -111,7 +112,7 @@ using namespace std;
         {
             for(int j=0; j<m_ny; j++)
             {
-                printf("%f %f %f\n", m_coords[i*m_nx+j][0], m_coords[i*m_nx+j][1],
+                printf("%f %f %f\n", m_coords[i*m_ny+j][0], m_coords[i*m_ny+j][1],
                         m_values(i,j));
             }
         }
@@ -121,7 +122,10 @@ using namespace std;
      *--------------------------------------------------------------------------------------
      *       Class:  RegularMesh
      *      Method:  RegularMesh :: UpdateInterpolator
-     * Description:  Update m_ya and m_y2a 
+     * Description:  Computes the coefficients of the natural bicubic spline in each cell.
+     *               The spline is the tensor-product of 1D natural cubic splines, so that
+     *               within a cell it is determined by values (f) and second derivatives 
+     *               along x2 (m_y2a), along x1 (fxx) and along both (fxxyy) at its corners.
      *--------------------------------------------------------------------------------------
      */
     void RegularMesh::UpdateInterpolator()
@@ -130,8 +134,76 @@ using namespace std;
         m_y2a.setZero();
 
         splie2(m_x1a, m_x2a, m_values, m_y2a);
+
+        MatrixRM fxx(m_nx, m_ny), fxxyy(m_nx, m_ny);
+        splie1(m_x1a, m_values, fxx);
+        splie1(m_x1a, m_y2a, fxxyy);
+
+        /*-----------------------------------------------------------------------------
+         * 1D basis polynomials in the local coordinate u (0..1) of a cell: linear 
+         * weights of the end-values and cubic weights of the end-second-derivatives
+         *-----------------------------------------------------------------------------*/
+        double hx = m_dx*m_dx/6.;
+        double hy = m_dy*m_dy/6.;
+        double A[2][4]  = {{1, -1, 0, 0}, {0, 1, 0, 0}};
+        double Cx[2][4] = {{0, -2*hx, 3*hx, -hx}, {0, -hx, 0, hx}};
+        double Cy[2][4] = {{0, -2*hy, 3*hy, -hy}, {0, -hy, 0, hy}};
+
+        m_coefficients.resize((m_nx-1)*(m_ny-1)*16);
+        
+        #pragma omp parallel for
+        for(int i=0; i<m_nx-1; i++)
+        {
+            for(int j=0; j<m_ny-1; j++)
+            {
+                double *c = &m_coefficients[(i*(m_ny-1) + j)*16];
+                for(int k=0; k<16; k++) c[k] = 0;
+
+                for(int a=0; a<2; a++)
+                {
+                    for(int b=0; b<2; b++)
+                    {
+                        double f    = m_values(i+a, j+b);
+                        double fyy  = m_y2a(i+a, j+b);
+                        double fxx_ = fxx(i+a, j+b);
+                        double fxy  = fxxyy(i+a, j+b);
+                        
+                        for(int p=0; p<4; p++)
+                        {
+                            for(int q=0; q<4; q++)
+                            {
+                                c[p*4+q] += A[a][p]*A[b][q]*f    + A[a][p]*Cy[b][q]*fyy +
+                                            Cx[a][p]*A[b][q]*fxx_ + Cx[a][p]*Cy[b][q]*fxy;
+                            }
+                        }
+                    }
+                }
+            }
+        }
     }
     
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  RegularMesh
+     *      Method:  RegularMesh :: GetFunctionValueAt
+     * Description:  Evaluates the interpolant at a point
+     *--------------------------------------------------------------------------------------
+     */
+    double RegularMesh::GetFunctionValueAt(double x, double y) const
+    {
+        double u, v;
+        int cell = LocateCell(x, y, u, v);
+
+        return EvaluateCell(cell, u, v);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  RegularMesh
+     *      Method:  RegularMesh :: GetFunctionValuesAt
+     * Description:  Updates the interpolator and evaluates it at the given points
+     *--------------------------------------------------------------------------------------
+     */
     void RegularMesh::GetFunctionValuesAt(int nCoor, float **coor, vector<float> *result)
     {
         UpdateInterpolator();
@@ -141,9 +213,131 @@ using namespace std;
         #pragma omp parallel for
         for(int i=0; i<nCoor; i++)
         {
-            double res = 0;
-            splin2(m_x1a, m_x2a, m_values, m_y2a, coor[i][0], coor[i][1], res);
-            (*result)[i] = res;
+            (*result)[i] = GetFunctionValueAt(coor[i][0], coor[i][1]);
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  RegularMesh
+     *      Method:  RegularMesh :: GetFunctionValuesAt
+     * Description:  Batched evaluation for large numbers of points. Points are processed 
+     *               in blocks: cells and local coordinates of all points in a block are 
+     *               located first, in a loop free of dependencies, followed by evaluation
+     *               of the cell polynomials.
+     *--------------------------------------------------------------------------------------
+     */
+    void RegularMesh::GetFunctionValuesAt(int nCoor, const float *x, const float *y, float *result) const
+    {
+        const int BLOCK_SIZE = 256;
+
+        #pragma omp parallel for schedule(static)
+        for(int start=0; start<nCoor; start+=BLOCK_SIZE)
+        {
+            int cells[BLOCK_SIZE];
+            double u[BLOCK_SIZE], v[BLOCK_SIZE];
+            int n = min(BLOCK_SIZE, nCoor-start);
+
+            for(int k=0; k<n; k++)
+            {
+                cells[k] = LocateCell(x[start+k], y[start+k], u[k], v[k]);
+            }
+
+            for(int k=0; k<n; k++)
+            {
+                result[start+k] = EvaluateCell(cells[k], u[k], v[k]);
+            }
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  RegularMesh
+     *      Method:  RegularMesh :: BuildInterpolationWeights
+     * Description:  Computes the weights of grid-values contributing to each point: 2x2 
+     *               for bilinear and 4x4 for bicubic (cubic-convolution) interpolation. 
+     *               The natural bicubic spline used by GetFunctionValuesAt depends on all
+     *               grid-values, which would yield dense weights. Points beyond the grid
+     *               take values from the nearest edge.
+     *--------------------------------------------------------------------------------------
+     */
+    void RegularMesh::BuildInterpolationWeights(int nCoor, float **coor, InterpolationType type)
+    {
+        int ns = (type == Interpolation_Bicubic) ? 4 : 2;
+        vector< Triplet<double> > triplets;
+        triplets.reserve(nCoor*ns*ns);
+
+        for(int k=0; k<nCoor; k++)
+        {
+            int ix[4], iy[4];
+            double wx[4], wy[4];
+            
+            GetStencilWeights((coor[k][0]-m_lower[0])/m_dx, m_nx, type, ix, wx);
+            GetStencilWeights((coor[k][1]-m_lower[1])/m_dy, m_ny, type, iy, wy);
+
+            for(int a=0; a<ns; a++)
+            {
+                for(int b=0; b<ns; b++)
+                {
+                    triplets.push_back(Triplet<double>(k, ix[a]*m_ny + iy[b], wx[a]*wy[b]));
+                }
+            }
+        }
+
+        /* Repeated indices, at edges, are summed */
+        m_weights.resize(nCoor, m_nx*m_ny);
+        m_weights.setFromTriplets(triplets.begin(), triplets.end());
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  RegularMesh
+     *      Method:  RegularMesh :: ApplyInterpolationWeights
+     * Description:  Interpolates current grid-values onto the points passed to 
+     *               BuildInterpolationWeights
+     *--------------------------------------------------------------------------------------
+     */
+    void RegularMesh::ApplyInterpolationWeights(vector<double> *result) const
+    {
+        result->resize(m_weights.rows());
+
+        Map<const VectorXd> values(m_values.data(), m_nx*m_ny);
+        Map<VectorXd> r(&(*result)[0], result->size());
+        
+        r = m_weights * values;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  RegularMesh
+     *      Method:  RegularMesh :: GetStencilWeights
+     * Description:  1D interpolation stencil at fractional grid-position t, for a grid of
+     *               n nodes; indices beyond the grid are clamped to its edges. Bicubic 
+     *               weights follow the cubic-convolution kernel of Keys (1981), a = -0.5.
+     *--------------------------------------------------------------------------------------
+     */
+    void RegularMesh::GetStencilWeights(double t, int n, InterpolationType type, int *idx, double *w) const
+    {
+        t = min(max(t, 0.), double(n-1));
+        int i = min(int(floor(t)), n-2);
+        double f = t - i;
+
+        if(type == Interpolation_Bicubic)
+        {
+            double f2 = f*f, f3 = f2*f;
+
+            w[0] = -0.5*f3 + f2 - 0.5*f;
+            w[1] =  1.5*f3 - 2.5*f2 + 1.;
+            w[2] = -1.5*f3 + 2.*f2 + 0.5*f;
+            w[3] =  0.5*f3 - 0.5*f2;
+            for(int k=0; k<4; k++) idx[k] = min(max(i-1+k, 0), n-1);
+        }
+        else
+        {
+            w[0] = 1.-f;
+            w[1] = f;
+            idx[0] = i;
+            idx[1] = i+1;
         }
     }
 
@@ -183,28 +377,6 @@ using namespace std;
             y2[k]=y2[k]*y2[k+1]+u[k];
     }
     
-    void RegularMesh::splint( vector<double> &xa, vector<double> &ya, 
-                             vector<double> &y2a, const double x, double &y )
-    {
-        int k;
-        double h,b,a;
-
-        int n=xa.size();
-        int klo=0;
-        int khi=n-1;
-        while (khi-klo > 1) {
-            k=(khi+klo) >> 1;
-            if (xa[k] > x) khi=k;
-            else klo=k;
-        }
-        h=xa[khi]-xa[klo];
-        if (h == 0.0) assert("Bad xa input to routine splint");
-        a=(xa[khi]-x)/h;
-        b=(x-xa[klo])/h;
-        y=a*ya[klo]+b*ya[khi]+((a*a*a-a)*y2a[klo]
-            +(b*b*b-b)*y2a[khi])*(h*h)/6.0;
-    }
-
     void RegularMesh::splie2(vector<double> &x1a, vector<double> &x2a, 
                              MatrixRM &ya, MatrixRM &y2a)
     {
@@ -220,23 +392,17 @@ using namespace std;
         }
     }
 
-    void RegularMesh::splin2(vector<double> &x1a, vector<double> &x2a, 
-                             MatrixRM &ya, MatrixRM &y2a, const double x1, 
-                             const double x2, double &y)
+    void RegularMesh::splie1(vector<double> &x1a, MatrixRM &ya, MatrixRM &y2a)
     {
-        int j,k;
+        int m,n,j,k;
 
-        int m=x1a.size();
-        int n=x2a.size();
-        vector<double> ya_t(n),y2a_t(n),yytmp(m),ytmp(m);
-        for (j=0;j<m;j++) {
-            for (k=0;k<n;k++) {
-                ya_t[k]=ya(j,k);
-                y2a_t[k]=y2a(j,k);
-            }
-            splint(x2a,ya_t,y2a_t,x2,yytmp[j]);
+        m=ya.rows();
+        n=ya.cols();
+        vector<double> ya_t(m),y2a_t(m);
+        for (k=0;k<n;k++) {
+            for (j=0;j<m;j++) ya_t[j]=ya(j,k);
+            spline(x1a,ya_t,1.0e30,1.0e30,y2a_t);
+            for (j=0;j<m;j++) y2a(j,k)=y2a_t[j];
         }
-        spline(x1a,yytmp,1.0e30,1.0e30,ytmp);
-        splint(x1a,yytmp,ytmp,x1,y);
     }
 }}
@@ -41,6 +41,7 @@
 #include <KdTree.hh>
 #include <Timer.hh>
 #include <Eigen/Dense>
+#include <Eigen/Sparse>
 
 namespace src { namespace mesh {
 
@@ -58,18 +59,48 @@ namespace src { namespace mesh {
         public:
 
         typedef Matrix<double, Dynamic, Dynamic, RowMajor> MatrixRM;
+        typedef SparseMatrix<double, RowMajor> WeightMatrix;
+
+        typedef enum InterpolationType_t
+        {
+            Interpolation_Bilinear,
+            Interpolation_Bicubic
+        }InterpolationType;
 
         friend class SurfaceTopology;
 
         RegularMesh(int nx, int ny, const float *upper, const float *lower);
         ~RegularMesh();
         
-        inline double X(int i, int j){ return m_coords[i*m_nx + j][0]; }
-        inline double Y(int i, int j){ return m_coords[i*m_nx + j][1]; }
+        inline double X(int i, int j){ return m_coords[i*m_ny + j][0]; }
+        inline double Y(int i, int j){ return m_coords[i*m_ny + j][1]; }
         inline double &V(int i, int j){ return m_values(i,j); }
+        
+        /* Absolute coordinates of grid-nodes */
+        inline double GridX(int i) const { return m_lower[0] + i*m_dx; }
+        inline double GridY(int j) const { return m_lower[1] + j*m_dy; }
+        inline int NX() const { return m_nx; }
+        inline int NY() const { return m_ny; }
 
+        /*-----------------------------------------------------------------------------
+         * Natural bicubic-spline interpolation. UpdateInterpolator computes the 
+         * polynomial coefficients of each cell once, after which a value at a point is
+         * evaluated in O(1). Points beyond the grid are extrapolated from edge cells. 
+         * The batched (structure-of-arrays) variant requires UpdateInterpolator to 
+         * have been called after the last change to grid-values.
+         *-----------------------------------------------------------------------------*/
         void UpdateInterpolator();
+        double GetFunctionValueAt(double x, double y) const;
         void GetFunctionValuesAt(int nCoor, float **coor, vector<float> *result);
+        void GetFunctionValuesAt(int nCoor, const float *x, const float *y, float *result) const;
+
+        /*-----------------------------------------------------------------------------
+         * Interpolation onto a fixed set of points, with absolute coordinates, as a 
+         * sparse matrix-vector product. Weights depend only on the points, so they are
+         * computed once and can be applied to any number of value-sets. 
+         *-----------------------------------------------------------------------------*/
+        void BuildInterpolationWeights(int nCoor, float **coor, InterpolationType type);
+        void ApplyInterpolationWeights(vector<double> *result) const;
         
         void Print();
 
@@ -90,17 +121,42 @@ namespace src { namespace mesh {
         MatrixRM m_y2a;
         vector<double> m_x1a;
         vector<double> m_x2a;
+        vector<double> m_coefficients;  /* 16 per cell: c[p*4+q] multiplies u^p.v^q */
+        WeightMatrix m_weights;
+        WeightMatrix m_meshWeights;     /* Grid-node x mesh-node, built by SurfaceTopology */
+
+        inline int LocateCell(double x, double y, double &u, double &v) const
+        {
+            double s = x/m_dx;
+            double t = y/m_dy;
+            int i = min(max(int(floor(s)), 0), m_nx-2);
+            int j = min(max(int(floor(t)), 0), m_ny-2);
+            
+            u = s - i;
+            v = t - j;
+            return i*(m_ny-1) + j;
+        }
+
+        inline double EvaluateCell(int cell, double u, double v) const
+        {
+            const double *c = &m_coefficients[cell*16];
+            double r = 0;
+            
+            for(int p=3; p>=0; p--)
+            {
+                r = r*u + (((c[p*4+3]*v + c[p*4+2])*v + c[p*4+1])*v + c[p*4]);
+            }
+            return r;
+        }
+
+        void GetStencilWeights(double t, int n, InterpolationType type, int *idx, double *w) const;
 
         void spline( vector<double> &x, vector<double> &y, 
                      const double yp1, const double ypn,
                      vector<double> &y2 );
-        void splint( vector<double> &xa, vector<double> &ya, 
-                     vector<double> &y2a, const double x, double &y );
         void splie2( vector<double> &x1a, vector<double> &x2a, 
                      MatrixRM &ya, MatrixRM &y2a );   
-        void splin2(vector<double> &x1a, vector<double> &x2a, 
-                    MatrixRM &ya, MatrixRM &y2a, const double x1, 
-                    const double x2, double &y);
+        void splie1( vector<double> &x1a, MatrixRM &ya, MatrixRM &y2a );
     };
 }}
 #endif
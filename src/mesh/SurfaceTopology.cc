@@ -40,13 +40,13 @@
 #include <ScalarField.hh>
 #include <Timer.hh>
 #include <Log.hh>
-#include <tinyxml2.hh>
+#include <VTUReader.hh>
+#include <Checkpoint.hh>
 
 namespace src { namespace mesh {
     using namespace std;
     using namespace src::util;
     using namespace src::parser;
-    using namespace src::parser::tinyxml2;
     
     const int SurfaceTopology::DIRICHLET                = 1;
     const int SurfaceTopology::NEUMANN                  = 2;
@@ -58,10 +58,12 @@ namespace src { namespace mesh {
      *--------------------------------------------------------------------------------------
      *       Class:  SurfaceTopology
      *      Method:  SurfaceTopology :: SurfaceTopology
-     * Description:  Constructor initializes mesh and network.
+     * Description:  Constructor initializes mesh and network. When a checkpoint is given,
+     *               the mesh-geometry, elevations and, if cached, the triangulation are 
+     *               restored from it instead.
      *--------------------------------------------------------------------------------------
      */
-    SurfaceTopology::SurfaceTopology(Config *c)
+    SurfaceTopology::SurfaceTopology(Config *c, Checkpoint *cp)
     :m_config(c)
     {
         /*-----------------------------------------------------------------------------
@@ -77,7 +79,10 @@ namespace src { namespace mesh {
         m_smoothingIterations   = m_config->PInt("smoothingIterations");
         m_meshStartTime         = 0;
 
-        m_rawGeometry = ReadMeshGeometry(&m_nMeshPoints);
+        if(cp)
+            m_rawGeometry = RestoreMeshGeometry(cp, &m_nMeshPoints);
+        else
+            m_rawGeometry = ReadMeshGeometry(&m_nMeshPoints);
         
         /*-----------------------------------------------------------------------------
          * Initialize kd-tree for spatial queries
@@ -88,18 +93,30 @@ namespace src { namespace mesh {
         /*-----------------------------------------------------------------------------
          * Initialize triangulation
          *-----------------------------------------------------------------------------*/
+        bool cachedTriangulation = false;
+        if(cp) cp->Value(cachedTriangulation);
+
         printf("[Delaunay Triangulation: ");
         Timer tTriangulationBegin;
-        m_triangulator = new Triangulator(m_nMeshPoints, m_rawGeometry, 
-                                   Triangulator::Triangulator_TriangleIndices       | 
-                                   Triangulator::Triangulator_TriangleNeighbours    | 
-                                   Triangulator::Triangulator_VoronoiVertices       | 
-                                   Triangulator::Triangulator_VoronoiSides          |
-                                   Triangulator::Triangulator_VoronoiCellAreas      |
-                                   Triangulator::Triangulator_NodeNeighbours);
+        if(cachedTriangulation)
+        {
+            m_triangulator = new Triangulator(m_nMeshPoints, m_rawGeometry, cp);
+        }
+        else
+        {
+            m_triangulator = new Triangulator(m_nMeshPoints, m_rawGeometry, 
+                                       Triangulator::Triangulator_TriangleIndices       | 
+                                       Triangulator::Triangulator_TriangleNeighbours    | 
+                                       Triangulator::Triangulator_VoronoiVertices       | 
+                                       Triangulator::Triangulator_VoronoiSides          |
+                                       Triangulator::Triangulator_VoronoiCellAreas      |
+                                       Triangulator::Triangulator_NodeNeighbours);
+        }
         Timer tTriangulationEnd; 
         printf("%lf s]\n", Timer::Elapsed(tTriangulationBegin, tTriangulationEnd));
     
+        InitializeNodeTriangles();
+
         /*-----------------------------------------------------------------------------
          * Validate boundary conditions 
          *-----------------------------------------------------------------------------*/
@@ -143,6 +160,12 @@ namespace src { namespace mesh {
         {
             m_z0[i] = m_zp[i] = m_rawGeometry[i][2];
         }
+        
+        if(cp)
+        {
+            cp->Data(m_z0, sizeof(float)*m_nMeshPoints);
+            cp->Data(m_zp, sizeof(float)*m_nMeshPoints);
+        }
 
         printf("[Initializing Network: ");Timer tInitNetworkBegin;
         InitializeNetwork();
@@ -193,12 +216,7 @@ namespace src { namespace mesh {
     {
         if(m_kdTree) delete m_kdTree;
 
-        m_kdTree = new KdTree(m_nMeshPoints);
-
-        for(int i=0; i<m_nMeshPoints; i++)
-        {
-            m_kdTree->Add(m_rawGeometry[i], i);
-        }
+        m_kdTree = new KdTree(m_nMeshPoints, m_rawGeometry);
     }
 
     /*
@@ -494,96 +512,27 @@ namespace src { namespace mesh {
      */
     void SurfaceTopology::ReadVTUMesh(int *nMeshPoints, float ***points, float ***pointsSorted)
     {
-        XMLDocument xmlDoc;
-        
-        if(xmlDoc.LoadFile(m_meshFileName.c_str()) == tinyxml2::XML_NO_ERROR){}
-        else
-        {
-            LogError(cout << "Error loading xml ifle: " << m_meshFileName << endl);
-            exit(EXIT_FAILURE);
-        }
-
-        vector<float> bcVec, xVec, yVec, hVec, tVec;
+        vector<float> bcVec, pointsVec, tVec;
         vector<int>order;
         /*-----------------------------------------------------------------------------
-         * Parse xml file
+         * Stream the required arrays out of the vtu file
          *-----------------------------------------------------------------------------*/
         {
-            /* Get number of points */
-            tinyxml2::XMLElement *piece = xmlDoc.FirstChildElement("VTKFile")->
-                                            FirstChildElement("UnstructuredGrid")->
-                                            FirstChildElement("Piece");
-            *nMeshPoints  = atoi(piece->Attribute("NumberOfPoints"));
-            
-            /* Resize vectors */
-            bcVec.resize(*nMeshPoints);
-            xVec.resize(*nMeshPoints);
-            yVec.resize(*nMeshPoints); 
-            hVec.resize(*nMeshPoints);
-            order.resize(*nMeshPoints);
-            tVec.resize(*nMeshPoints);
-
-            /* bc */
-            tinyxml2::XMLElement *pointData = piece->FirstChildElement("PointData");
-            for(tinyxml2::XMLElement *dataArray = pointData->
-                                                  FirstChildElement("DataArray"); dataArray;
-                dataArray = dataArray->NextSiblingElement())
-            {
-                if(string(dataArray->Attribute("Name"))=="bc")
-                {
-                    stringstream ss (dataArray->GetText());
-                    for(int i=0; i<*nMeshPoints; i++)
-                    {
-                        float bc;
-
-                        ss >> bc;
-                        bcVec[i] = bc;
-                    }                    
-                }
-                
-                if(string(dataArray->Attribute("Name"))=="order")
-                {
-                    stringstream ss (dataArray->GetText());
-                    for(int i=0; i<*nMeshPoints; i++)
-                    {
-                        int o;
-
-                        ss >> o;
-                        order[i] = o;
-                    }                    
-                }
-                
-                if(string(dataArray->Attribute("Name"))=="t")
-                {
-                    stringstream ss (dataArray->GetText());
-                    for(int i=0; i<*nMeshPoints; i++)
-                    {
-                        float t;
+            VTUReader reader(m_meshFileName);
 
-                        ss >> t;
-                        tVec[i] = t;
-                    }                    
-                }                
-            }
+            reader.Request("Points", &pointsVec);
+            reader.Request("bc", &bcVec);
+            reader.Request("order", &order);
+            reader.Request("t", &tVec, true);
 
-            /* Read points */
+            if(!reader.Read())
             {
-                tinyxml2::XMLElement *pointsDataArray = piece->FirstChildElement("Points")->
-                                                        FirstChildElement("DataArray");
-                stringstream ss (pointsDataArray->GetText());
-                for(int i=0; i<*nMeshPoints; i++)
-                {
-                    float x, y, h;
-
-                    ss >> x;
-                    ss >> y;
-                    ss >> h;
-                    
-                    xVec[i] = x;
-                    yVec[i] = y;
-                    hVec[i] = h;
-                }                   
+                LogError(cout << "Error loading vtu file: " << m_meshFileName << " (" << 
+                         reader.GetError() << ")" << endl);
+                exit(EXIT_FAILURE);
             }
+
+            *nMeshPoints = reader.GetNumberOfPoints();
         }
         
         /* Allocate return arrays */
@@ -613,9 +562,9 @@ namespace src { namespace mesh {
         int dirichletCount=0;
         for(count=0; count<npt; count++)
         {
-            (*points)[count][0] = xVec [order[count]];
-            (*points)[count][1] = yVec [order[count]];
-            (*points)[count][2] = hVec [order[count]];
+            (*points)[count][0] = pointsVec [order[count]*3];
+            (*points)[count][1] = pointsVec [order[count]*3+1];
+            (*points)[count][2] = pointsVec [order[count]*3+2];
             (*points)[count][3] = bcVec[order[count]];
             
             if((*points)[count][3] > 2 || (*points)[count][3] < 0)
@@ -639,7 +588,8 @@ namespace src { namespace mesh {
             exit(EXIT_FAILURE);
         }   
 
-        m_meshStartTime = tVec[0];
+        /* Meshes without a time-stamp start at 0 */
+        if(tVec.size()) m_meshStartTime = tVec[0];
     }
 
     /*
@@ -751,6 +701,58 @@ err:    LogError(cout << "Invalid mesh file: " << m_meshFileName << ". Format mu
         exit(EXIT_FAILURE);
     }
 
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopology
+     *      Method:  SurfaceTopology :: RestoreMeshGeometry
+     * Description:  Reads the (smoothed and re-ordered) mesh-geometry from a checkpoint
+     *--------------------------------------------------------------------------------------
+     */
+    float **SurfaceTopology::RestoreMeshGeometry(Checkpoint *cp, int *nMeshPoints)
+    {
+        cp->Section("TOPO");
+        cp->Value(*nMeshPoints);
+        
+        int npt = *nMeshPoints;
+        float **points = new float*[npt];
+        points[0] = new float[npt*4];
+        for(int i=0; i<npt; i++) points[i] = points[0] + i*4;
+
+        cp->Data(points[0], sizeof(float)*npt*4);
+        cp->Array(m_originalOrder);
+        cp->Data(m_upper, sizeof(m_upper));
+        cp->Data(m_lower, sizeof(m_lower));
+        cp->Value(m_meshStartTime);
+
+        return points;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopology
+     *      Method:  SurfaceTopology :: Save
+     * Description:  Saves mesh-geometry and elevations to a checkpoint, in the order they
+     *               are restored by the constructor. The triangulation is optionally 
+     *               included, so that it need not be recomputed on restart.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopology::Save(Checkpoint *cp, bool includeTriangulation)
+    {
+        cp->Section("TOPO");
+        cp->Value(m_nMeshPoints);
+        cp->Data(m_rawGeometry[0], sizeof(float)*m_nMeshPoints*4);
+        cp->Array(m_originalOrder);
+        cp->Data(m_upper, sizeof(m_upper));
+        cp->Data(m_lower, sizeof(m_lower));
+        cp->Value(m_meshStartTime);
+        
+        cp->Value(includeTriangulation);
+        if(includeTriangulation) m_triangulator->Save(cp);
+
+        cp->Data(m_z0, sizeof(float)*m_nMeshPoints);
+        cp->Data(m_zp, sizeof(float)*m_nMeshPoints);
+    }
+
     /*
      *--------------------------------------------------------------------------------------
      *       Class:  SurfaceTopology
@@ -842,7 +844,7 @@ err:    LogError(cout << "Invalid mesh file: " << m_meshFileName << ". Format mu
             }
         }
         
-        m_triangulator->ComputeBound(&(m_lower[0]), &(m_lower[1]), &(m_upper[0]), &(m_upper[0]));
+        m_triangulator->ComputeBound(&(m_lower[0]), &(m_lower[1]), &(m_upper[0]), &(m_upper[1]));
 
         //TODO: Check if Neumann BCs are valid edges in the triangulated mesh.
     }
@@ -871,59 +873,295 @@ err:    LogError(cout << "Invalid mesh file: " << m_meshFileName << ". Format mu
      *--------------------------------------------------------------------------------------
      *       Class:  SurfaceTopology
      *      Method:  SurfaceTopology :: InterpolateToRegularmesh
-     * Description:  
+     * Description:  Interpolates a nodal field onto grid-nodes of rm. Inverse-distance 
+     *               weighting starts with a search-radius of one grid-diagonal per 
+     *               grid-node, doubling it until at least one mesh-node is found. 
+     *               Barycentric interpolation assigns noData to grid-nodes outside the
+     *               triangulation.
      *--------------------------------------------------------------------------------------
      */
-    void SurfaceTopology::InterpolateToRegularmesh(RegularMesh *rm, vector<float> &field) const
+    void SurfaceTopology::InterpolateToRegularmesh(RegularMesh *rm, const vector<float> &field, 
+                                                   GridInterpolation type, double noData) const
     {
-        double radius = sqrt(rm->m_dx*rm->m_dx + rm->m_dy*rm->m_dy);
-
         int nx = rm->m_nx;
         int ny = rm->m_ny;
+
+        if(type == GridInterpolation_Barycentric)
+        {
+            if(rm->m_meshWeights.rows() == 0) BuildRasterizationWeights(rm);
+
+            const RegularMesh::WeightMatrix &w = rm->m_meshWeights;
+            double *values = rm->m_values.data();
+
+            #pragma omp parallel for
+            for(int r=0; r<nx*ny; r++)
+            {
+                RegularMesh::WeightMatrix::InnerIterator it(w, r);
+                if(!it)
+                {
+                    values[r] = noData;
+                    continue;
+                }
+
+                double sum = 0;
+                for(; it; ++it)
+                {
+                    sum += it.value() * field[it.col()];
+                }
+                values[r] = sum;
+            }
+            return;
+        }
+
+        double initialRadius = sqrt(rm->m_dx*rm->m_dx + rm->m_dy*rm->m_dy);
         
-        #pragma omp parallel for
-        for(int i=0; i<nx; i++)
+        #pragma omp parallel
         {
-            for(int j=0; j<ny; j++)
+            vector<float> distance;
+            vector<int> id;
+
+            #pragma omp for
+            for(int i=0; i<nx; i++)
             {
-                vector<float> distance;
-                vector<int> id;
+                for(int j=0; j<ny; j++)
+                {
+                    float pos[2] = {float(rm->GridX(i)), float(rm->GridY(j))};
+                    
+                    for(double radius=initialRadius; ; radius*=2)
+                    {
+                        m_kdTree->QueryBallPoint(pos, radius, &distance, &id);
+                        if(distance.size()) break;
+                    }
 
-                float pos[2] = {float(rm->m_x1a[i]), float(rm->m_x2a[j])};
-                
-                m_kdTree->QueryBallPoint(pos, radius, &distance, &id);
-                while(distance.size()==0)
+                    rm->m_values(i,j) = 0.;
+                    /* IDW interpolation */
+                    double distInvSum = 0.;
+                    double distInv = 0;
+                    double weightedVal = 0;
+                    int nn = distance.size();
+                    int foundCoincidentNode = 0;
+                    for(int k=0; k<nn; k++) 
+                    {
+                        if(distance[k]==0)
+                        {
+                            rm->m_values(i,j) = field[id[k]];
+                            foundCoincidentNode = 1;
+                            break;
+                        }
+                        distInv = 1./distance[k];
+                        distInvSum += distInv;
+                        weightedVal += distInv * field[id[k]];
+                    }
+                    
+                    if(foundCoincidentNode) continue;
+                    
+                    /* Assign interpolated value */
+                    rm->m_values(i,j) = weightedVal / distInvSum;
+                }
+            }
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopology
+     *      Method:  SurfaceTopology :: BuildRasterizationWeights
+     * Description:  Rasterizes each triangle onto the grid-nodes within its bounding-box,
+     *               assigning each grid-node covered by a triangle the barycentric 
+     *               weights of its vertices; grid-nodes on shared edges are assigned by 
+     *               the first triangle. Rows of grid-nodes outside the triangulation 
+     *               are left empty.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopology::BuildRasterizationWeights(RegularMesh *rm) const
+    {
+        const unsigned int **triangles = GetTriangleIndices();
+        long int nTriangles = GetNumTriangles();
+        int nx = rm->m_nx;
+        int ny = rm->m_ny;
+        const double eps = 1e-9;
+
+        vector<int> triangleIds(nx*ny, -1);
+        vector<double> weights(3*nx*ny);
+
+        for(long int t=0; t<nTriangles; t++)
+        {
+            const unsigned int *v = triangles[t];
+            double x0 = X(v[0]), y0 = Y(v[0]);
+            double x1 = X(v[1]), y1 = Y(v[1]);
+            double x2 = X(v[2]), y2 = Y(v[2]);
+            
+            double det = (y1-y2)*(x0-x2) + (x2-x1)*(y0-y2);
+            if(det == 0) continue;
+
+            int iMin = max(int(ceil((min(x0, min(x1, x2)) - rm->m_lower[0]) / rm->m_dx)), 0);
+            int iMax = min(int(floor((max(x0, max(x1, x2)) - rm->m_lower[0]) / rm->m_dx)), nx-1);
+            int jMin = max(int(ceil((min(y0, min(y1, y2)) - rm->m_lower[1]) / rm->m_dy)), 0);
+            int jMax = min(int(floor((max(y0, max(y1, y2)) - rm->m_lower[1]) / rm->m_dy)), ny-1);
+
+            for(int i=iMin; i<=iMax; i++)
+            {
+                for(int j=jMin; j<=jMax; j++)
                 {
-                    m_kdTree->QueryBallPoint(pos, radius, &distance, &id);
-                    radius*=2;
+                    int g = i*ny + j;
+                    if(triangleIds[g] >= 0) continue;
+
+                    double px = rm->GridX(i);
+                    double py = rm->GridY(j);
+                    double l0 = ((y1-y2)*(px-x2) + (x2-x1)*(py-y2)) / det;
+                    double l1 = ((y2-y0)*(px-x2) + (x0-x2)*(py-y2)) / det;
+                    double l2 = 1. - l0 - l1;
+
+                    if((l0 < -eps) || (l1 < -eps) || (l2 < -eps)) continue;
+
+                    triangleIds[g] = t;
+                    weights[3*g]   = l0;
+                    weights[3*g+1] = l1;
+                    weights[3*g+2] = l2;
                 }
+            }
+        }
+
+        vector< Triplet<double> > triplets;
+        triplets.reserve(3*nx*ny);
+        for(int g=0; g<nx*ny; g++)
+        {
+            if(triangleIds[g] < 0) continue;
+
+            const unsigned int *v = triangles[triangleIds[g]];
+            for(int k=0; k<3; k++) triplets.push_back(Triplet<double>(g, v[k], weights[3*g+k]));
+        }
+
+        rm->m_meshWeights.resize(nx*ny, m_nMeshPoints);
+        rm->m_meshWeights.setFromTriplets(triplets.begin(), triplets.end());
+    }
 
-                rm->m_values(i,j) = 0.;
-                /* IDW interpolation */
-                double distInvSum = 0.;
-                double distInv = 0;
-                double weightedVal = 0;
-                int nn = distance.size();
-                int foundCoincidentNode = 0;
-                for(int k=0; k<nn; k++) 
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopology
+     *      Method:  SurfaceTopology :: LocatePoint
+     * Description:  Visibility-walk: starting from the hint triangle, repeatedly steps 
+     *               across the edge opposite the vertex with the most negative 
+     *               barycentric weight until all weights are non-negative. Crossing an 
+     *               edge without a neighbouring triangle implies the point lies outside
+     *               the (convex) triangulation. The walk terminates on Delaunay
+     *               triangulations; a linear search serves as a safeguard otherwise.
+     *--------------------------------------------------------------------------------------
+     */
+    long int SurfaceTopology::LocatePoint(float x, float y, long int hint, double *weights) const
+    {
+        const unsigned int **triangles = GetTriangleIndices();
+        const unsigned int **neighbours = GetTriangleNeighbours();
+        long int nTriangles = GetNumTriangles();
+        const double eps = 1e-9;
+        double w[3];
+
+        if(nTriangles == 0) return -1;
+
+        long int t = hint;
+        if((t < 0) || (t >= nTriangles))
+        {
+            float pos[2] = {x, y};
+            int nearest;
+            float distance;
+            
+            m_kdTree->QueryNearest(pos, 1, &nearest, &distance);
+            t = max(m_nodeTriangles[nearest], 0);
+        }
+
+        if(neighbours)
+        {
+            for(long int step=0; step<nTriangles; step++)
+            {
+                if(!GetBarycentricWeights(t, x, y, w)) break;
+
+                int k = 0;
+                if(w[1] < w[k]) k = 1;
+                if(w[2] < w[k]) k = 2;
+
+                if(w[k] >= -eps)
                 {
-                    if(distance[k]==0)
+                    if(weights) for(int j=0; j<3; j++) weights[j] = w[j];
+                    return t;
+                }
+
+                /* Find the neighbour sharing the edge opposite vertex k */
+                unsigned int a = triangles[t][(k+1)%3];
+                unsigned int b = triangles[t][(k+2)%3];
+                long int next = -1;
+                for(int j=0; j<3; j++)
+                {
+                    long int n = neighbours[t][j];
+                    if(n >= nTriangles) continue;
+
+                    const unsigned int *v = triangles[n];
+                    if(((v[0]==a) || (v[1]==a) || (v[2]==a)) && 
+                       ((v[0]==b) || (v[1]==b) || (v[2]==b)))
                     {
-                        rm->m_values(i,j) = field[id[k]];
-                        foundCoincidentNode = 1;
+                        next = n;
                         break;
                     }
-                    distInv = 1./distance[k];
-                    distInvSum += distInv;
-                    weightedVal += distInv * field[id[k]];
                 }
                 
-                if(foundCoincidentNode) continue;
-                
-                /* Assign interpolated value */
-                rm->m_values(i,j) = weightedVal / distInvSum;
+                if(next < 0) return -1;
+                t = next;
+            }
+        }
+        
+        for(t=0; t<nTriangles; t++)
+        {
+            if(!GetBarycentricWeights(t, x, y, w)) continue;
+            if((w[0] >= -eps) && (w[1] >= -eps) && (w[2] >= -eps))
+            {
+                if(weights) for(int j=0; j<3; j++) weights[j] = w[j];
+                return t;
             }
         }
+        return -1;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopology
+     *      Method:  SurfaceTopology :: GetBarycentricWeights
+     * Description:  Computes the barycentric weights of (x, y) w.r.t. the vertices of
+     *               triangle t. Returns false for degenerate triangles.
+     *--------------------------------------------------------------------------------------
+     */
+    bool SurfaceTopology::GetBarycentricWeights(long int t, float x, float y, double *weights) const
+    {
+        const unsigned int *v = GetTriangleIndices()[t];
+        double x0 = X(v[0]), y0 = Y(v[0]);
+        double x1 = X(v[1]), y1 = Y(v[1]);
+        double x2 = X(v[2]), y2 = Y(v[2]);
+
+        double det = (y1-y2)*(x0-x2) + (x2-x1)*(y0-y2);
+        if(det == 0) return false;
+
+        weights[0] = ((y1-y2)*(x-x2) + (x2-x1)*(y-y2)) / det;
+        weights[1] = ((y2-y0)*(x-x2) + (x0-x2)*(y-y2)) / det;
+        weights[2] = 1. - weights[0] - weights[1];
+        return true;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopology
+     *      Method:  SurfaceTopology :: InitializeNodeTriangles
+     * Description:  Records a triangle incident to each node, used as the starting point
+     *               for point-location queries without a hint.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopology::InitializeNodeTriangles()
+    {
+        const unsigned int **triangles = GetTriangleIndices();
+        long int nTriangles = GetNumTriangles();
+
+        m_nodeTriangles.assign(m_nMeshPoints, -1);
+        for(long int t=0; t<nTriangles; t++)
+        {
+            for(int k=0; k<3; k++) m_nodeTriangles[triangles[t][k]] = t;
+        }
     }
 
     /*
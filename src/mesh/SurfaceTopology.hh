@@ -57,6 +57,7 @@
 
 namespace src { namespace util {
     template <class T> class ScalarField;
+    class Checkpoint;
 }}
 
 namespace src { namespace mesh {
@@ -85,10 +86,37 @@ namespace src { namespace mesh {
         /*-----------------------------------------------------------------------------
          * Public interface 
          *-----------------------------------------------------------------------------*/
-        SurfaceTopology(Config *c);
+        SurfaceTopology(Config *c, Checkpoint *cp=NULL);
         ~SurfaceTopology();
+
+        void Save(Checkpoint *cp, bool includeTriangulation);
         
-        void InterpolateToRegularmesh(RegularMesh *rm, vector<float> &field) const;
+        /*-----------------------------------------------------------------------------
+         * Interpolation of a nodal field onto a regular grid, either by inverse-
+         * distance weighting or by rasterizing the triangulation with barycentric 
+         * weights. The latter are computed once per grid and cached in it as a sparse
+         * matrix, so that subsequent interpolations are a single parallel SpMV. 
+         * Grid-nodes outside the triangulation are assigned noData.
+         *-----------------------------------------------------------------------------*/
+        typedef enum GridInterpolation_t
+        {
+            GridInterpolation_InverseDistance,
+            GridInterpolation_Barycentric
+        }GridInterpolation;
+
+        void InterpolateToRegularmesh(RegularMesh *rm, const vector<float> &field, 
+                                      GridInterpolation type=GridInterpolation_InverseDistance,
+                                      double noData=0.) const;
+
+        /*-----------------------------------------------------------------------------
+         * Point-location by walking the triangulation from a hint triangle, e.g. the 
+         * result of a previous query nearby, which makes lookups along a path or 
+         * within a cluster of sites O(1) amortized. Without a hint, the walk starts 
+         * from a triangle incident to the nearest mesh-node. Returns -1 for points 
+         * outside the triangulation; otherwise the barycentric weights of the 
+         * vertices of the triangle returned are optionally stored in 'weights'.
+         *-----------------------------------------------------------------------------*/
+        long int LocatePoint(float x, float y, long int hint=-1, double *weights=NULL) const;
 
         /*-----------------------------------------------------------------------------
          * Private internals 
@@ -110,6 +138,7 @@ namespace src { namespace mesh {
         float m_upper[2]; /* Upper bounding-box coords */
         float m_lower[2]; /* Lower bounding-box coords */
         vector<int> m_originalOrder;
+        vector<int> m_nodeTriangles; /* A triangle incident to each node */
 
         int *m_receivers;
         int *m_receiversSillCorrected;
@@ -130,9 +159,14 @@ namespace src { namespace mesh {
         void InitializeStack(int *index, int node, int catchmentId);
         void PropagateCatchmentTagUpstream(int node, int catchmentId);
         
+        void BuildRasterizationWeights(RegularMesh *rm) const;
+        void InitializeNodeTriangles();
+        bool GetBarycentricWeights(long int t, float x, float y, double *weights) const;
+        
         void ReadTextMesh(int *nMeshPoints, float ***points, float ***pointsSorted);
         void ReadVTUMesh(int *nMeshPoints, float ***points, float ***pointsSorted);
         float **ReadMeshGeometry(int *nMeshPoints);
+        float **RestoreMeshGeometry(Checkpoint *cp, int *nMeshPoints);
         
         int CountOrphanNodes();
         void PrintMeshDetails();
@@ -167,6 +201,7 @@ namespace src { namespace mesh {
 
         /* Triangulation attributes */
         const unsigned int **GetTriangleIndices() const {return (const unsigned int **)m_triangulator->GetTriangleIndices();}
+        const unsigned int **GetTriangleNeighbours() const {return (const unsigned int **)m_triangulator->GetTriangleNeighbours();}
         const float **GetVoronoiSides() const {return (const float **) m_triangulator->GetVoronoiSides();}
         const float *GetVoronoiCellAreas() const {return (const float*) m_triangulator->GetVoronoiCellAreas();}
         const unsigned int *GetNumNeighbours() const {return (const unsigned int*) m_triangulator->GetNumNeighbours();}
@@ -35,14 +35,68 @@
  *
  * =====================================================================================
  */
+#include <algorithm>
+#include <sstream>
+#include <string.h>
+#include <unistd.h>
+#include <omp.h>
+
 #include <SurfaceTopologyOutput.hh>
+#include <Triangulator.hh>
+#include <LossyCodec.hh>
+#include <AsciiFormatter.hh>
 #include <Timer.hh>
+#include <Checkpoint.hh>
 
 namespace src { namespace mesh {
 using namespace std;
 using namespace src::util;
 
     const float SCALAR = 1;
+    const float NODATA = -9999;
+
+    /* 
+     * ===  FUNCTION  ======================================================================
+     *         Name:  IsBigEndianHost
+     *  Description:  Binary output is written in host byte-order, which is declared in the
+     *                headers of vtk, xdmf and raster files.
+     * =====================================================================================
+     */
+    static bool IsBigEndianHost()
+    {
+        const unsigned int one = 1;
+        return (*((const unsigned char*)&one) == 0);
+    }
+
+    /* 
+     * ===  FUNCTION  ======================================================================
+     *         Name:  HilbertIndex
+     *  Description:  Returns the distance of cell (x, y) along a Hilbert curve filling an 
+     *                n x n grid, n being a power of 2.
+     * =====================================================================================
+     */
+    static unsigned long int HilbertIndex(unsigned int n, unsigned int x, unsigned int y)
+    {
+        unsigned long int d = 0;
+        for(unsigned int s=n/2; s>0; s/=2)
+        {
+            unsigned int rx = (x & s) > 0;
+            unsigned int ry = (y & s) > 0;
+            d += (unsigned long int)s * s * ((3 * rx) ^ ry);
+
+            /* Rotate quadrant */
+            if(ry == 0)
+            {
+                if(rx == 1)
+                {
+                    x = n-1 - x;
+                    y = n-1 - y;
+                }
+                unsigned int t = x; x = y; y = t;
+            }
+        }
+        return d;
+    }
 
     /*
      *--------------------------------------------------------------------------------------
@@ -66,27 +120,1299 @@ using namespace src::util;
         m_frequency             = m_config->PInt("frequency");
         m_writeMesh             = m_config->PBool("writeMesh");
         m_writeDrainage         = m_config->PBool("writeDrainage");
+        m_xdmf                  = (m_outputFormat=="xdmf");
+        m_binary                = (m_outputFormat=="vtk-binary") || m_xdmf; /* Drainage is written as vtk-binary */
+        
+        /*-----------------------------------------------------------------------------
+         * Read optional parameters 
+         *-----------------------------------------------------------------------------*/
+        m_async                 = m_config->PBool("asyncWrite", false);
+        m_queueDepth            = m_config->PInt("asyncQueueDepth", 2);
+        m_nPieces               = m_config->PInt("pieces", 1);
+        m_lossy                 = (m_config->PString("compression", "none") == "lossy");
+        m_errorBound            = m_lossy ? m_config->PDouble("errorBound") : 0.;
         
         if(m_path[m_path.length()-1] != '/') m_path = m_path + "/";
 
-        /*-----------------------------------------------------------------------------
-         * Check if path is valid 
-         *-----------------------------------------------------------------------------*/
+        /*-----------------------------------------------------------------------------
+         * Check if path is valid 
+         *-----------------------------------------------------------------------------*/
+        {
+            char tempFileName[1024]={};
+
+            sprintf(tempFileName, "%stemp.txt", m_path.c_str());
+
+            FILE *f = fopen(tempFileName, "w");
+            if(f)
+            {
+                fclose(f);
+                remove(tempFileName);
+            }
+            else
+            {
+                cerr << "Error: invalid path specified for output-file.." << endl;
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        if(m_nPieces < 1) m_nPieces = 1;
+        
+        if(m_lossy && !m_binary)
+        {
+            cerr << "Warning: lossy compression is only supported for vtk-binary output.." << endl;
+            m_lossy = false;
+        }
+        if(m_lossy && !(m_errorBound > 0))
+        {
+            cerr << "Error: errorBound must be positive for lossy compression.." << endl;
+            exit(EXIT_FAILURE);
+        }
+        if(m_writeMesh && !m_xdmf) BuildMeshPieces();
+        
+        ReadOutputStreams();
+
+        m_heavyFileName         = m_path + m_prefix + ".bin";
+        m_xdmfFileName          = m_path + m_prefix + ".xmf";
+        m_heavyOffset           = 0;
+        m_xdmfTail              = 0;
+
+        /*-----------------------------------------------------------------------------
+         * Cell areas for drainage-area computation; hull nodes are assigned the 
+         * average cell-area, as in FluvialErosion
+         *-----------------------------------------------------------------------------*/
+        m_minDrainageArea       = m_config->PDouble("minDrainageArea", 0.);
+        if(m_writeDrainage)
+        {
+            const float *surfaceArea = m_surfaceTopology->GetVoronoiCellAreas();
+            const int *hull = m_surfaceTopology->GetHull();
+            int np = m_surfaceTopology->GetNMeshPoints();
+
+            m_cellAreas.resize(np);
+            for(int i=0; i<np; i++)
+            {
+                if(!hull[i]) m_cellAreas[i] = surfaceArea[i];
+                else m_cellAreas[i] = m_surfaceTopology->GetAverageCellArea();
+            }
+        }
+
+        /*-----------------------------------------------------------------------------
+         * Allocate snapshot buffers and start writer thread
+         *-----------------------------------------------------------------------------*/
+        if(m_queueDepth < 1) m_queueDepth = 1;
+        if(!m_async) m_queueDepth = 1;
+        
+        for(int i=0; i<m_queueDepth; i++)
+        {
+            m_snapshots.push_back(new Snapshot());
+            m_freeSnapshots.push_back(m_snapshots.back());
+        }
+        
+        m_shutdown = false;
+        m_busy = false;
+        pthread_mutex_init(&m_mutex, NULL);
+        pthread_cond_init(&m_cond, NULL);
+        
+        if(m_async && pthread_create(&m_writerThread, NULL, WriterThread, this))
+        {
+            cerr << "Warning: could not start output thread; writing synchronously.." << endl;
+            m_async = false;
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: ~SurfaceTopologyOutput
+     * Description:  Destructor
+     *--------------------------------------------------------------------------------------
+     */
+    SurfaceTopologyOutput::~SurfaceTopologyOutput()
+    {
+        if(m_async)
+        {
+            pthread_mutex_lock(&m_mutex);
+            m_shutdown = true;
+            pthread_cond_broadcast(&m_cond);
+            pthread_mutex_unlock(&m_mutex);
+            
+            pthread_join(m_writerThread, NULL);
+        }
+        
+        pthread_mutex_destroy(&m_mutex);
+        pthread_cond_destroy(&m_cond);
+
+        for(unsigned int i=0; i<m_snapshots.size(); i++) delete m_snapshots[i];
+        for(unsigned int i=0; i<m_streams.size(); i++) delete m_streams[i].raster;
+        for(unsigned int i=0; i<m_registeredScalarFields.size(); i++) delete m_registeredScalarFields[i];
+    }
+
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: RegisterFieldProvider
+     * Description:  Registers a provider for a named output-field, which is evaluated 
+     *               only at output time-steps. Providers are not owned and must outlive 
+     *               this object.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::RegisterFieldProvider(string name, FieldProvider *fp)
+    {
+        m_fieldProviders.push_back(pair<string, FieldProvider*>(name, fp));
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: RegisterScalarField
+     * Description:  Method to register scalar-fields for output, which are destroyed 
+     *               immediately after they are written.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::RegisterScalarField(ScalarField<float> *sf)
+    {
+        m_registeredScalarFields.push_back(sf);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: DiscardScalarFields
+     * Description:  Deletes registered scalar-fields without writing them
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::DiscardScalarFields()
+    {
+        for(unsigned int i=0; i<m_registeredScalarFields.size(); i++)
+        {
+            delete m_registeredScalarFields[i];
+        }
+        m_registeredScalarFields.clear();
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: Write
+     * Description:  Writes output after specific intervals. The current state is copied 
+     *               into a snapshot buffer, which is either written immediately or, with 
+     *               'asyncWrite' enabled, handed over to the writer thread. In the latter
+     *               case, this call only blocks if all snapshot buffers are in use.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::Write()
+    {
+        float t = m_model->GetTime();
+        int   ts = m_model->GetTimeStep();
+        
+        if(!IsOutputStep(ts)) 
+        {
+            DiscardScalarFields();
+            return;
+        }
+
+        if(!(m_outputFormat=="vtk" || m_outputFormat=="vtk-binary" || m_xdmf))
+        {
+            cerr << "Warning: Only vtk, vtk-binary and xdmf output are currently supported." << endl;
+            return;
+        }
+
+        /*-----------------------------------------------------------------------------
+         * Acquire a free snapshot buffer
+         *-----------------------------------------------------------------------------*/
+        pthread_mutex_lock(&m_mutex);
+        while(m_freeSnapshots.empty()) pthread_cond_wait(&m_cond, &m_mutex);
+        Snapshot *snapshot = m_freeSnapshots.back();
+        m_freeSnapshots.pop_back();
+        pthread_mutex_unlock(&m_mutex);
+
+        TakeSnapshot(snapshot, t, ts);
+
+        if(m_async)
+        {
+            pthread_mutex_lock(&m_mutex);
+            m_pendingSnapshots.push_back(snapshot);
+            pthread_cond_broadcast(&m_cond);
+            pthread_mutex_unlock(&m_mutex);
+        }
+        else
+        {
+            WriteSnapshot(snapshot);
+            m_freeSnapshots.push_back(snapshot);
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: Flush
+     * Description:  Blocks until all pending snapshots have been written
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::Flush()
+    {
+        if(!m_async) return;
+
+        pthread_mutex_lock(&m_mutex);
+        while(m_pendingSnapshots.size() || m_busy) pthread_cond_wait(&m_cond, &m_mutex);
+        pthread_mutex_unlock(&m_mutex);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: Serialize
+     * Description:  Saves/restores the extent of the XDMF time-series. Pending snapshots
+     *               are written first, so that the saved extent covers all output-steps
+     *               up to the checkpoint.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::Serialize(Checkpoint *cp)
+    {
+        if(cp->IsWriting()) Flush();
+
+        bool started = m_heavyFile.is_open();
+
+        cp->Section("OUTP");
+        cp->Match(m_xdmf, "xdmf-output");
+        cp->Value(started);
+        cp->Value(m_heavyOffset);
+        cp->Value(m_xdmfTail);
+        cp->Value(m_xOffset);
+        cp->Value(m_yOffset);
+        cp->Value(m_connectivityOffset);
+        cp->Value(m_bcOffset);
+        cp->Value(m_idOffset);
+        cp->Value(m_orderOffset);
+
+        if(cp->IsReading() && started) RestoreXDMF();
+    }
+
+    /*-----------------------------------------------------------------------------
+     * Private internals 
+     *-----------------------------------------------------------------------------*/
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: TakeSnapshot
+     * Description:  Copies the time-varying state into a snapshot buffer. Field-providers
+     *               are evaluated directly into the buffer; registered scalar-fields are 
+     *               copied and then destroyed. Buffers are reused, so no allocations take
+     *               place once they have grown to size. The mesh-state is only captured 
+     *               if the main output or a mesh/raster-stream is due; steps with only 
+     *               probe-streams due copy just the probe samples.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::TakeSnapshot(Snapshot *s, float t, int ts)
+    {
+        const SurfaceTopology *st = m_surfaceTopology;
+        int np = st->m_nMeshPoints;
+
+        s->t = t;
+        s->ts = ts;
+        s->streamValues.resize(m_streams.size());
+        EvaluateProbes(s);
+
+        bool captureState = ((ts % m_frequency) == 0);
+        for(unsigned int i=0; (i<m_streams.size()) && !captureState; i++)
+        {
+            if(m_streams[i].type == Stream_Probes) continue;
+            if((ts % m_streams[i].frequency) == 0) captureState = true;
+        }
+        if(!captureState)
+        {
+            DiscardScalarFields();
+            return;
+        }
+
+        s->z.resize(np);
+        s->zp.resize(np);
+        s->cid.resize(np);
+        s->rid.resize(np);
+        s->donorOffsets.resize(np+1);
+        s->donors.resize(np);
+
+        s->donorOffsets[0] = 0;
+        for(int i=0; i<np; i++)
+        {
+            s->z[i]   = st->Z(i);
+            s->zp[i]  = st->Zp(i);
+            s->cid[i] = st->C(i);
+            s->rid[i] = st->R(i);
+            
+            int offset = s->donorOffsets[i];
+            for(int j=0; j<st->Dn(i); j++) s->donors[offset+j] = st->D(i)[j];
+            s->donorOffsets[i+1] = offset + st->Dn(i);
+        }
+
+        int nfp = m_fieldProviders.size();
+        int nf = nfp + m_registeredScalarFields.size();
+        s->fieldNames.resize(nf);
+        s->fields.resize(nf);
+        for(int i=0; i<nfp; i++)
+        {
+            s->fieldNames[i] = m_fieldProviders[i].first;
+            s->fields[i].resize(np);
+            m_fieldProviders[i].second->EvaluateOutputField(m_fieldProviders[i].first, s->fields[i]);
+        }
+
+        for(int i=nfp; i<nf; i++)
+        {
+            ScalarField<float>* sf = m_registeredScalarFields[i-nfp];
+            int length = sf->GetLength();
+
+            s->fieldNames[i] = sf->GetName();
+            s->fields[i].resize(length);
+            for(int j=0; j<length; j++) s->fields[i][j] = (*sf)(j);
+
+            delete sf;
+        }
+        m_registeredScalarFields.clear();
+
+        EvaluateRasters(s);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: WriteSnapshot
+     * Description:  Writes all requested outputs for a snapshot
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::WriteSnapshot(const Snapshot *s)
+    {
+        if((s->ts % m_frequency) == 0)
+        {
+            if(m_writeMesh)
+            {
+                if(m_xdmf) WriteXDMF(s);
+                else       WriteVTKMesh(s);
+            }
+            if(m_writeDrainage) WriteVTKDrainage(s);
+        }
+
+        for(unsigned int i=0; i<m_streams.size(); i++)
+        {
+            if((s->ts % m_streams[i].frequency) != 0) continue;
+
+            if(m_streams[i].type == Stream_Probes)      WriteProbeStream(s, m_streams[i], s->streamValues[i]);
+            else if(m_streams[i].type == Stream_Raster) WriteRasterStream(s, m_streams[i], s->streamValues[i]);
+            else                                        WriteVTKStream(s, m_streams[i]);
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: IsOutputStep
+     * Description:  Returns true if any output is due at time-step ts
+     *--------------------------------------------------------------------------------------
+     */
+    bool SurfaceTopologyOutput::IsOutputStep(int ts)
+    {
+        if((ts % m_frequency) == 0) return true;
+        
+        for(unsigned int i=0; i<m_streams.size(); i++)
+        {
+            if((ts % m_streams[i].frequency) == 0) return true;
+        }
+        return false;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: WriterThread
+     * Description:  Entry point of the writer thread
+     *--------------------------------------------------------------------------------------
+     */
+    void *SurfaceTopologyOutput::WriterThread(void *arg)
+    {
+        static_cast<SurfaceTopologyOutput*>(arg)->WriterLoop();
+        return NULL;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: WriterLoop
+     * Description:  Writes pending snapshots in order and returns their buffers to the 
+     *               free-list. Pending snapshots are drained before shutting down.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::WriterLoop()
+    {
+        pthread_mutex_lock(&m_mutex);
+        while(true)
+        {
+            while(m_pendingSnapshots.empty() && !m_shutdown) pthread_cond_wait(&m_cond, &m_mutex);
+            if(m_pendingSnapshots.empty()) break;
+
+            Snapshot *snapshot = m_pendingSnapshots.front();
+            m_pendingSnapshots.pop_front();
+            m_busy = true;
+            pthread_mutex_unlock(&m_mutex);
+
+            WriteSnapshot(snapshot);
+
+            pthread_mutex_lock(&m_mutex);
+            m_busy = false;
+            m_freeSnapshots.push_back(snapshot);
+            pthread_cond_broadcast(&m_cond);
+        }
+        pthread_mutex_unlock(&m_mutex);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: WriteDataArray
+     * Description:  Write a data-array associated with vtk point-data. For vtk-binary 
+     *               output only the header is written here and the data is queued for the
+     *               AppendedData section.
+     *--------------------------------------------------------------------------------------
+     */
+    template<class T>
+    void SurfaceTopologyOutput::WriteDataArray(VTKFile &ofs, int nElem, T *data, int nComponents, string dataType, string name)
+    {
+        char buffer[1024] = {0};
+        
+        if(m_binary)
+        {
+            bool lossy = IsLossy(dataType, name);
+
+            sprintf(buffer, "<DataArray type=\"%s\" Name=\"%s\" format=\"appended\" offset=\"%ld\" NumberOfComponents=\"%d\"%s/>",
+                    dataType.c_str(), name.c_str(), ofs.appendedOffset, nComponents, 
+                    lossy ? " compression=\"lossy\"" : "");
+            ofs << buffer << "\n";
+
+            if(lossy) AppendLossyDataArray(ofs, nElem, data);
+            else      AppendDataArray(ofs, nElem, data, dataType);
+            return;
+        }
+
+        sprintf(buffer, "<DataArray type=\"%s\" Name=\"%s\" format=\"ascii\"  NumberOfComponents=\"%d\">",
+                dataType.c_str(), name.c_str(), nComponents);
+
+        ofs << buffer << endl;
+        
+        WriteAsciiValues(ofs, nElem, data);
+
+        ofs << "</DataArray>" << endl;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: WriteAsciiValues
+     * Description:  Writes the values of a data-array as text. The array is split into 
+     *               contiguous chunks, which are formatted concurrently into separate 
+     *               buffers and then written in order. Floats are written with the fewest
+     *               digits that read back exactly.
+     *--------------------------------------------------------------------------------------
+     */
+    template<class T>
+    void SurfaceTopologyOutput::WriteAsciiValues(VTKFile &ofs, int nElem, T *data)
+    {
+        const int itemsPerLine = 10;
+        const int minChunkSize = 4096;
+        
+        int nChunks = min(omp_get_max_threads(), (nElem + minChunkSize - 1)/minChunkSize);
+        if(nChunks < 1) nChunks = 1;
+
+        vector< vector<char> > buffers(nChunks);
+
+        #pragma omp parallel for schedule(static) if(nChunks > 1)
+        for(int c=0; c<nChunks; c++)
+        {
+            int begin = (long int)(nElem) * c / nChunks;
+            int end   = (long int)(nElem) * (c+1) / nChunks;
+            
+            vector<char> &buffer = buffers[c];
+            buffer.resize((long int)(end-begin) * (AsciiFormatter::MAX_LENGTH + 2) + 1);
+            
+            char *p = &buffer[0];
+            for(int i=begin; i<end; i++)
+            {
+                p += AsciiFormatter::Format(p, data[i]);
+                *p++ = ' ';
+                if((!(i%itemsPerLine)) && (i>0)) *p++ = '\n';
+            }
+            buffer.resize(p - &buffer[0]);
+        }
+
+        for(int c=0; c<nChunks; c++)
+        {
+            if(buffers[c].size()) ofs.write(&buffers[c][0], buffers[c].size());
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: AppendDataArray
+     * Description:  Converts a data-array to the raw host-order representation of
+     *               'dataType', prefixed by a UInt64 byte-count, and queues it for output
+     *               in the AppendedData section.
+     *--------------------------------------------------------------------------------------
+     */
+    template<class T>
+    void SurfaceTopologyOutput::AppendDataArray(VTKFile &ofs, int nElem, T *data, string dataType)
+    {
+        int size = 0;
+        
+        if(dataType=="UInt8")                               size = 1;
+        else if(dataType=="Int32" || dataType=="Float32")   size = 4;
+        else if(dataType=="Int64" || dataType=="Float64")   size = 8;
+        else assert(0);
+
+        unsigned long long nbytes = (unsigned long long)(nElem) * size;
+
+        ofs.appendedArrays.push_back(vector<char>());
+        vector<char> &bytes = ofs.appendedArrays.back();
+        bytes.resize(sizeof(nbytes) + nbytes);
+        
+        memcpy(&bytes[0], &nbytes, sizeof(nbytes));
+        char *dest = &bytes[sizeof(nbytes)];
+
+        if(dataType=="UInt8")
+            for(int i=0; i<nElem; i++) ((unsigned char*)dest)[i] = (unsigned char)(data[i]);
+        else if(dataType=="Int32")
+            for(int i=0; i<nElem; i++) ((int*)dest)[i] = (int)(data[i]);
+        else if(dataType=="Float32")
+            for(int i=0; i<nElem; i++) ((float*)dest)[i] = (float)(data[i]);
+        else if(dataType=="Int64")
+            for(int i=0; i<nElem; i++) ((long long*)dest)[i] = (long long)(data[i]);
+        else if(dataType=="Float64")
+            for(int i=0; i<nElem; i++) ((double*)dest)[i] = (double)(data[i]);
+
+        ofs.appendedOffset += bytes.size();
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: IsLossy
+     * Description:  Returns true if an array is to be lossy-compressed. Coordinates and 
+     *               boundary-conditions are always stored exactly.
+     *--------------------------------------------------------------------------------------
+     */
+    bool SurfaceTopologyOutput::IsLossy(string dataType, string name)
+    {
+        return m_lossy && (dataType=="Float32") && (name!="Points") && (name!="bc");
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: AppendLossyDataArray
+     * Description:  Encodes a data-array within m_errorBound, prefixed by the UInt64 
+     *               byte-count of the encoding, and queues it for output in the 
+     *               AppendedData section.
+     *--------------------------------------------------------------------------------------
+     */
+    template<class T>
+    void SurfaceTopologyOutput::AppendLossyDataArray(VTKFile &ofs, int nElem, T *data)
+    {
+        vector<float> values(nElem);
+        for(int i=0; i<nElem; i++) values[i] = (float)(data[i]);
+
+        ofs.appendedArrays.push_back(vector<char>());
+        vector<char> &bytes = ofs.appendedArrays.back();
+        unsigned long long nbytes = 0;
+        bytes.resize(sizeof(nbytes));
+
+        Timer tEncodeBegin;
+        LossyCodec::Encode(values.data(), nElem, m_errorBound, bytes);
+        Timer tEncodeEnd;
+
+        nbytes = bytes.size() - sizeof(nbytes);
+        memcpy(&bytes[0], &nbytes, sizeof(nbytes));
+
+        ofs.rawBytes += (double)(nElem) * sizeof(float);
+        ofs.encodedBytes += nbytes;
+        ofs.encodeTime += Timer::Elapsed(tEncodeBegin, tEncodeEnd);
+        ofs.appendedOffset += bytes.size();
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: OpenVTKFile
+     * Description:  Opens a vtk xml-file and writes the header
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::OpenVTKFile(VTKFile &ofs, const char *fileName, const char *type)
+    {
+        ofs.appendedArrays.clear();
+        ofs.appendedOffset = 0;
+        ofs.rawBytes = ofs.encodedBytes = ofs.encodeTime = 0;
+
+        ofs.precision(4);
+        ofs.open(fileName, m_binary ? (ios_base::out | ios_base::binary) : ios_base::out);
+        
+        ofs << "<?xml version=\"1.0\"?>" << endl;
+        ofs << "<VTKFile type=\"" << type << "\" version=\"0.1\" byte_order=\"" 
+            << (IsBigEndianHost() ? "BigEndian" : "LittleEndian") << "\"";
+        if(m_binary) ofs << " header_type=\"UInt64\"";
+        if(m_lossy) ofs << " compressor=\"spgmLossyCodec\"";
+        ofs << ">" << endl;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: CloseVTKFile
+     * Description:  Writes queued arrays to the AppendedData section, one write per array,
+     *               and closes the file.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::CloseVTKFile(VTKFile &ofs)
+    {
+        if(m_binary)
+        {
+            ofs << "<AppendedData encoding=\"raw\">\n_";
+            for(unsigned int i=0; i<ofs.appendedArrays.size(); i++)
+            {
+                ofs.write(&(ofs.appendedArrays[i][0]), ofs.appendedArrays[i].size());
+                vector<char>().swap(ofs.appendedArrays[i]);
+            }
+            ofs << "\n</AppendedData>\n";
+            ofs.appendedArrays.clear();
+        }
+        
+        ofs << "</VTKFile>" << endl;
+        ofs.close();
+
+        if(ofs.encodedBytes > 0)
+        {
+            printf("[Lossy compression: ratio %.2f, %.1f MB/s]\n", ofs.rawBytes/ofs.encodedBytes,
+                   (ofs.encodeTime > 0) ? ofs.rawBytes/ofs.encodeTime/1e6 : 0.);
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: BuildMeshPieces
+     * Description:  Partitions triangles into m_nPieces spatially contiguous strips, based
+     *               on the position of their centroids along the longer axis of the 
+     *               bounding-box. A single piece retains the original node-ordering.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::BuildMeshPieces()
+    {
+        const SurfaceTopology *st = m_surfaceTopology;
+        int np = st->m_nMeshPoints;
+        int ntri = st->GetNumTriangles();
+        const unsigned int **triIndices = st->GetTriangleIndices();
+
+        m_meshPieces.clear();
+        m_meshPieces.resize(m_nPieces);
+
+        if(m_nPieces == 1)
+        {
+            MeshPiece &piece = m_meshPieces[0];
+
+            piece.nodes.resize(np);
+            for(int i=0; i<np; i++) piece.nodes[i] = i;
+
+            piece.connectivity.resize(ntri*3);
+            for(int i=0; i<ntri; i++)
+                for(int j=0; j<3; j++)
+                    piece.connectivity[i*3+j] = triIndices[i][j];
+            
+            return;
+        }
+
+        /*-----------------------------------------------------------------------------
+         * Sort triangles by centroid along the longer axis
+         *-----------------------------------------------------------------------------*/
+        vector<float> upper, lower;
+        st->GetBounds(upper, lower);
+        int axis = ((upper[0]-lower[0]) >= (upper[1]-lower[1])) ? 0 : 1;
+
+        vector< pair<float, int> > keys(ntri);
+        for(int i=0; i<ntri; i++)
+        {
+            float c = 0;
+            for(int j=0; j<3; j++)
+            {
+                int node = triIndices[i][j];
+                c += (axis==0) ? st->X(node) : st->Y(node);
+            }
+            keys[i] = pair<float, int>(c, i);
+        }
+        sort(keys.begin(), keys.end());
+
+        /*-----------------------------------------------------------------------------
+         * Assign contiguous chunks of triangles to pieces and renumber nodes locally
+         *-----------------------------------------------------------------------------*/
+        vector<int> localId(np, -1);
+        for(int p=0; p<m_nPieces; p++)
+        {
+            MeshPiece &piece = m_meshPieces[p];
+            int begin = (long int)(ntri) * p / m_nPieces;
+            int end   = (long int)(ntri) * (p+1) / m_nPieces;
+
+            piece.connectivity.resize((end-begin)*3);
+            for(int i=begin; i<end; i++)
+            {
+                int tri = keys[i].second;
+                for(int j=0; j<3; j++)
+                {
+                    int node = triIndices[tri][j];
+                    if(localId[node] < 0)
+                    {
+                        localId[node] = piece.nodes.size();
+                        piece.nodes.push_back(node);
+                    }
+                    piece.connectivity[(i-begin)*3+j] = localId[node];
+                }
+            }
+            
+            for(unsigned int i=0; i<piece.nodes.size(); i++) localId[piece.nodes[i]] = -1;
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: BuildSubsetPiece
+     * Description:  Builds a piece from triangles whose nodes are all selected. Nodes 
+     *               retain their relative ordering.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::BuildSubsetPiece(const vector<char> &selected, MeshPiece &piece)
+    {
+        const SurfaceTopology *st = m_surfaceTopology;
+        int np = st->m_nMeshPoints;
+        int ntri = st->GetNumTriangles();
+        const unsigned int **triIndices = st->GetTriangleIndices();
+
+        vector<char> used(np, 0);
+        piece.connectivity.clear();
+        for(int i=0; i<ntri; i++)
+        {
+            const unsigned int *tri = triIndices[i];
+            if(!(selected[tri[0]] && selected[tri[1]] && selected[tri[2]])) continue;
+
+            for(int j=0; j<3; j++)
+            {
+                piece.connectivity.push_back(tri[j]);
+                used[tri[j]] = 1;
+            }
+        }
+
+        vector<int> localId(np, -1);
+        piece.nodes.clear();
+        for(int i=0; i<np; i++)
+        {
+            if(!used[i]) continue;
+            
+            localId[i] = piece.nodes.size();
+            piece.nodes.push_back(i);
+        }
+
+        for(unsigned int i=0; i<piece.connectivity.size(); i++) 
+            piece.connectivity[i] = localId[piece.connectivity[i]];
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: BuildLevelOfDetailPiece
+     * Description:  Builds a decimated mesh from every stride-th node along a Hilbert 
+     *               curve, which retains a roughly uniform density of nodes. Hull nodes 
+     *               are always retained so that the domain is covered. Retained nodes 
+     *               are re-triangulated.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::BuildLevelOfDetailPiece(int stride, MeshPiece &piece)
+    {
+        const SurfaceTopology *st = m_surfaceTopology;
+        int np = st->m_nMeshPoints;
+        const int *hull = st->GetHull();
+        const unsigned int n = 1<<16;
+
+        vector<float> upper, lower;
+        st->GetBounds(upper, lower);
+        float sx = (upper[0] > lower[0]) ? (n-1)/(upper[0]-lower[0]) : 0;
+        float sy = (upper[1] > lower[1]) ? (n-1)/(upper[1]-lower[1]) : 0;
+
+        /*-----------------------------------------------------------------------------
+         * Sort nodes along the Hilbert curve and pick every stride-th node
+         *-----------------------------------------------------------------------------*/
+        vector< pair<unsigned long int, int> > keys(np);
+        for(int i=0; i<np; i++)
+        {
+            unsigned int x = (unsigned int)((st->X(i)-lower[0])*sx);
+            unsigned int y = (unsigned int)((st->Y(i)-lower[1])*sy);
+            keys[i] = pair<unsigned long int, int>(HilbertIndex(n, x, y), i);
+        }
+        sort(keys.begin(), keys.end());
+
+        vector<char> selected(np, 0);
+        for(int i=0; i<np; i++)
+        {
+            if((i % stride) == 0 || hull[keys[i].second]) selected[keys[i].second] = 1;
+        }
+
+        piece.nodes.clear();
+        for(int i=0; i<np; i++) if(selected[i]) piece.nodes.push_back(i);
+
+        /*-----------------------------------------------------------------------------
+         * Re-triangulate retained nodes
+         *-----------------------------------------------------------------------------*/
+        int ns = piece.nodes.size();
+        vector<float> coords(ns*2);
+        vector<float*> sites(ns);
+        for(int i=0; i<ns; i++)
+        {
+            coords[i*2]   = st->X(piece.nodes[i]);
+            coords[i*2+1] = st->Y(piece.nodes[i]);
+            sites[i] = &coords[i*2];
+        }
+
+        Triangulator t(ns, &sites[0], Triangulator::Triangulator_TriangleIndices);
+        unsigned int **triIndices = t.GetTriangleIndices();
+        int ntri = t.GetNumTriangles();
+
+        piece.connectivity.resize(ntri*3);
+        for(int i=0; i<ntri; i++)
+            for(int j=0; j<3; j++)
+                piece.connectivity[i*3+j] = triIndices[i][j];
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: ReadOutputStreams
+     * Description:  Reads additional output streams from sub-groups of the output config.
+     *               Each stream has a 'type' (boundingBox/catchments/lod/probes/raster)
+     *               and a 'frequency', along with 'boundingBox' (xmin ymin xmax ymax), 
+     *               'catchments' (ids of catchment outlets), 'lodStride', 'sites' 
+     *               (x0 y0 x1 y1 ..) or 'resolution' and 'fields' respectively. Probes 
+     *               are written every time-step by default, in 'csv' or 'binary' format.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::ReadOutputStreams()
+    {
+        const SurfaceTopology *st = m_surfaceTopology;
+        int np = st->m_nMeshPoints;
+        map<string, Config*> &groups = m_config->GetGroups();
+
+        for(map<string, Config*>::iterator it = groups.begin(); it != groups.end(); it++)
+        {
+            Config *sc = it->second;
+            OutputStream os;
+            string type = sc->PString("type");
+            
+            os.name = it->first;
+            os.frequency = (type == "probes") ? sc->PInt("frequency", 1) : sc->PInt("frequency");
+            os.binary = false;
+            os.headerWritten = false;
+            os.raster = NULL;
+            os.raw = false;
+            if(os.frequency < 1)
+            {
+                cerr << "Error: frequency of output-stream '" << os.name << "' must be positive.." << endl;
+                exit(EXIT_FAILURE);
+            }
+
+            if(type == "boundingBox")
+            {
+                float bbox[4] = {0};
+                istringstream iss(sc->PString("boundingBox"));
+                for(int i=0; i<4; i++) iss >> bbox[i];
+                if(iss.fail())
+                {
+                    cerr << "Error: boundingBox of output-stream '" << os.name 
+                         << "' must be specified as 'xmin ymin xmax ymax'.." << endl;
+                    exit(EXIT_FAILURE);
+                }
+
+                vector<char> selected(np, 0);
+                for(int i=0; i<np; i++)
+                {
+                    selected[i] = (st->X(i) >= bbox[0] && st->Y(i) >= bbox[1] && 
+                                   st->X(i) <= bbox[2] && st->Y(i) <= bbox[3]);
+                }
+
+                os.type = Stream_BoundingBox;
+                BuildSubsetPiece(selected, os.piece);
+            }
+            else if(type == "catchments")
+            {
+                int id;
+                istringstream iss(sc->PString("catchments"));
+                while(iss >> id) os.catchments.insert(id);
+
+                os.type = Stream_Catchments;
+            }
+            else if(type == "lod")
+            {
+                int stride = sc->PInt("lodStride");
+                if(stride < 1)
+                {
+                    cerr << "Error: lodStride of output-stream '" << os.name << "' must be positive.." << endl;
+                    exit(EXIT_FAILURE);
+                }
+
+                os.type = Stream_LevelOfDetail;
+                BuildLevelOfDetailPiece(stride, os.piece);
+            }
+            else if(type == "probes")
+            {
+                os.type = Stream_Probes;
+                ReadProbeSites(sc, os);
+            }
+            else if(type == "raster")
+            {
+                os.type = Stream_Raster;
+                ReadRasterGrid(sc, os);
+            }
+            else
+            {
+                cerr << "Error: unknown type '" << type << "' for output-stream '" << os.name 
+                     << "'. Options are (boundingBox/catchments/lod/probes/raster).." << endl;
+                exit(EXIT_FAILURE);
+            }
+
+            m_streams.push_back(os);
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: ReadProbeSites
+     * Description:  Reads the sites of a probe-stream and locates them within the 
+     *               triangulation, walking from the triangle of the previous site. Sites
+     *               outside the triangulation take the values of their nearest node.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::ReadProbeSites(Config *sc, OutputStream &os)
+    {
+        const SurfaceTopology *st = m_surfaceTopology;
+        const unsigned int **triangles = st->GetTriangleIndices();
+
+        float coord;
+        istringstream iss(sc->PString("sites"));
+        while(iss >> coord) os.sites.push_back(coord);
+        if(os.sites.empty() || (os.sites.size() % 2))
+        {
+            cerr << "Error: sites of output-stream '" << os.name 
+                 << "' must be specified as 'x0 y0 x1 y1 ..'.." << endl;
+            exit(EXIT_FAILURE);
+        }
+
+        string format = sc->PString("format", "csv");
+        if(format == "binary") os.binary = true;
+        else if(format != "csv")
+        {
+            cerr << "Error: unknown format '" << format << "' for output-stream '" << os.name 
+                 << "'. Options are (csv/binary).." << endl;
+            exit(EXIT_FAILURE);
+        }
+
+        int nSites = os.sites.size() / 2;
+        os.siteNodes.resize(3*nSites);
+        os.siteWeights.resize(3*nSites);
+
+        long int t = -1;
+        for(int i=0; i<nSites; i++)
+        {
+            float x = os.sites[2*i];
+            float y = os.sites[2*i+1];
+            long int result = st->LocatePoint(x, y, t, &os.siteWeights[3*i]);
+
+            if(result < 0)
+            {
+                cerr << "Warning: site (" << x << ", " << y << ") of output-stream '" << os.name 
+                     << "' lies outside the mesh; using values of the nearest node.." << endl;
+
+                float pos[2] = {x, y};
+                int nearest;
+                float distance;
+                st->m_kdTree->QueryNearest(pos, 1, &nearest, &distance);
+                
+                for(int k=0; k<3; k++) os.siteNodes[3*i+k] = nearest;
+                os.siteWeights[3*i] = 1.;
+                os.siteWeights[3*i+1] = os.siteWeights[3*i+2] = 0.;
+                continue;
+            }
+
+            for(int k=0; k<3; k++) os.siteNodes[3*i+k] = triangles[result][k];
+            t = result;
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: EvaluateProbes
+     * Description:  Interpolates elevation, and discharge and sediment where available,
+     *               at the sites of the probe-streams due at the current snapshot.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::EvaluateProbes(Snapshot *s)
+    {
+        const SurfaceTopology *st = m_surfaceTopology;
+
+        if(m_probeQuantities.empty())
+        {
+            const char *names[] = {"discharge", "sediment"};
+
+            m_probeQuantities.push_back("z");
+            m_probeFields.push_back(NULL);
+            for(int i=0; i<2; i++)
+            {
+                ScalarField<float> *sf = static_cast< ScalarField<float>* >(m_model->GetField(names[i]));
+                if(!sf) continue;
+
+                m_probeQuantities.push_back(names[i]);
+                m_probeFields.push_back(sf);
+            }
+        }
+
+        int nq = m_probeQuantities.size();
+        for(unsigned int i=0; i<m_streams.size(); i++)
+        {
+            const OutputStream &os = m_streams[i];
+            if((os.type != Stream_Probes) || (s->ts % os.frequency)) continue;
+
+            int nSites = os.sites.size() / 2;
+            vector<float> &values = s->streamValues[i];
+            values.resize(nSites*nq);
+            for(int j=0; j<nSites; j++)
+            {
+                for(int q=0; q<nq; q++)
+                {
+                    ScalarField<float> *sf = m_probeFields[q];
+                    double sum = 0;
+                    for(int k=0; k<3; k++)
+                    {
+                        unsigned int node = os.siteNodes[3*j+k];
+                        sum += os.siteWeights[3*j+k] * (sf ? (*sf)(node) : st->Z(node));
+                    }
+                    values[j*nq+q] = sum;
+                }
+            }
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: WriteProbeStream
+     * Description:  Appends a record of probe-values to the file of a probe-stream, which
+     *               is created along with a header if it is new or empty; an existing 
+     *               file, e.g. from before a restart, is appended to. Csv-files have a column 
+     *               per site and quantity, following 'ts' and 't'. Binary files start with
+     *               the magic 'SPGMPRB1', the number of sites and quantities (Int32), the 
+     *               site-coordinates (Float32) and the quantity-names (16 chars each), 
+     *               followed by a record per output-step: ts (Int32), t (Float32) and the 
+     *               values (Float32), ordered by site and then quantity.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::WriteProbeStream(const Snapshot *s, OutputStream &os, const vector<float> &values)
+    {
+        char fileName[256]={0};
+        sprintf(fileName, "%s%s.%s.%s", m_path.c_str(), m_prefix.c_str(), os.name.c_str(), 
+                os.binary ? "bin" : "csv");
+        
+        int nSites = os.sites.size() / 2;
+        int nq = m_probeQuantities.size();
+        
+        ios_base::openmode mode = ios::out | ios::app;
+        if(os.binary) mode |= ios::binary;
+
+        ofstream ofs(fileName, mode);
+        if(!ofs.good())
+        {
+            cerr << "Warning: could not open " << fileName << " for writing.." << endl;
+            return;
+        }
+
+        /* Records of a restarted run are appended to the existing file */
+        if(!os.headerWritten)
+        {
+            ofs.seekp(0, ios::end);
+            if(ofs.tellp() > 0) os.headerWritten = true;
+        }
+
+        if(os.binary)
+        {
+            if(!os.headerWritten)
+            {
+                int header[2] = {nSites, nq};
+                ofs.write("SPGMPRB1", 8);
+                ofs.write((const char*)header, sizeof(header));
+                ofs.write((const char*)&os.sites[0], sizeof(float)*os.sites.size());
+                for(int q=0; q<nq; q++)
+                {
+                    char name[16] = {0};
+                    strncpy(name, m_probeQuantities[q].c_str(), sizeof(name)-1);
+                    ofs.write(name, sizeof(name));
+                }
+            }
+            
+            ofs.write((const char*)&s->ts, sizeof(int));
+            ofs.write((const char*)&s->t, sizeof(float));
+            ofs.write((const char*)&values[0], sizeof(float)*values.size());
+        }
+        else
+        {
+            if(!os.headerWritten)
+            {
+                ofs << "ts,t";
+                for(int j=0; j<nSites; j++)
+                {
+                    for(int q=0; q<nq; q++) ofs << "," << m_probeQuantities[q] << "_" << j;
+                }
+                ofs << endl;
+            }
+
+            ofs.precision(9);
+            ofs << s->ts << "," << s->t;
+            for(unsigned int j=0; j<values.size(); j++) ofs << "," << values[j];
+            ofs << endl;
+        }
+
+        os.headerWritten = true;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: ReadRasterGrid
+     * Description:  Reads the grid of a raster-stream: square cells of size 'resolution'
+     *               covering 'boundingBox' (xmin ymin xmax ymax), or the mesh by default,
+     *               along with the names of the fields to be written ('z' by default) 
+     *               and the 'format' (flt/raw).
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::ReadRasterGrid(Config *sc, OutputStream &os)
+    {
+        double resolution = sc->PDouble("resolution", 0.);
+        if(!(resolution > 0))
+        {
+            cerr << "Error: resolution of output-stream '" << os.name << "' must be positive.." << endl;
+            exit(EXIT_FAILURE);
+        }
+
+        vector<float> upper, lower;
+        m_surfaceTopology->GetBounds(upper, lower);
+        
+        string bbox = sc->PString("boundingBox", "");
+        if(bbox.length())
+        {
+            istringstream iss(bbox);
+            iss >> lower[0] >> lower[1] >> upper[0] >> upper[1];
+            if(iss.fail())
+            {
+                cerr << "Error: boundingBox of output-stream '" << os.name 
+                     << "' must be specified as 'xmin ymin xmax ymax'.." << endl;
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        int nx = int(floor((upper[0]-lower[0]) / resolution + 1e-6)) + 1;
+        int ny = int(floor((upper[1]-lower[1]) / resolution + 1e-6)) + 1;
+        if((nx < 2) || (ny < 2))
+        {
+            cerr << "Error: resolution of output-stream '" << os.name 
+                 << "' must be smaller than the extent of the raster.." << endl;
+            exit(EXIT_FAILURE);
+        }
+        upper[0] = lower[0] + (nx-1)*resolution;
+        upper[1] = lower[1] + (ny-1)*resolution;
+
+        string field;
+        istringstream iss(sc->PString("fields", "z"));
+        while(iss >> field) os.fields.push_back(field);
+
+        string format = sc->PString("format", "flt");
+        if(format == "raw") os.raw = true;
+        else if(format != "flt")
+        {
+            cerr << "Error: unknown format '" << format << "' for output-stream '" << os.name 
+                 << "'. Options are (flt/raw).." << endl;
+            exit(EXIT_FAILURE);
+        }
+
+        os.raster = new RegularMesh(nx, ny, &upper[0], &lower[0]);
+        os.cellSize = resolution;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: EvaluateRasters
+     * Description:  Interpolates the fields of the raster-streams due at the current 
+     *               snapshot onto their grids. The barycentric weights are computed once
+     *               per grid, so that each field costs a single SpMV. Fields are looked up
+     *               among the snapshot's output-fields, then the model's fields; values
+     *               are stored in row-major order, starting with the northernmost row. 
+     *               Cells outside the mesh are NODATA.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::EvaluateRasters(Snapshot *s)
+    {
+        const SurfaceTopology *st = m_surfaceTopology;
+        int np = st->m_nMeshPoints;
+        vector<float> buffer;
+        
+        for(unsigned int i=0; i<m_streams.size(); i++)
         {
-            char tempFileName[1024]={};
+            const OutputStream &os = m_streams[i];
+            if((os.type != Stream_Raster) || (s->ts % os.frequency)) continue;
 
-            sprintf(tempFileName, "%stemp.txt", m_path.c_str());
+            RegularMesh *rm = os.raster;
+            int nx = rm->NX();
+            int ny = rm->NY();
+            vector<float> &values = s->streamValues[i];
+            values.resize(os.fields.size()*nx*ny);
 
-            FILE *f = fopen(tempFileName, "w");
-            if(f)
-            {
-                fclose(f);
-                remove(tempFileName);
-            }
-            else
+            for(unsigned int f=0; f<os.fields.size(); f++)
             {
-                cerr << "Error: invalid path specified for output-file.." << endl;
-                exit(EXIT_FAILURE);
+                const string &name = os.fields[f];
+                const vector<float> *field = NULL;
+
+                if(name == "z") field = &s->z;
+                for(unsigned int j=0; (j<s->fieldNames.size()) && !field; j++)
+                {
+                    if(s->fieldNames[j] == name) field = &s->fields[j];
+                }
+                if(!field)
+                {
+                    ScalarField<float> *sf = static_cast< ScalarField<float>* >(m_model->GetField(name));
+                    if(sf)
+                    {
+                        buffer.resize(np);
+                        for(int j=0; j<np; j++) buffer[j] = (*sf)(j);
+                        field = &buffer;
+                    }
+                }
+
+                float *dest = &values[f*nx*ny];
+                if(!field)
+                {
+                    if(m_missingRasterFields.insert(name).second)
+                        cerr << "Warning: field '" << name << "' of output-stream '" << os.name 
+                             << "' not found; writing NODATA values.." << endl;
+                    
+                    for(int j=0; j<nx*ny; j++) dest[j] = NODATA;
+                    continue;
+                }
+
+                st->InterpolateToRegularmesh(rm, *field, SurfaceTopology::GridInterpolation_Barycentric, NODATA);
+                for(int r=0; r<ny; r++)
+                {
+                    for(int c=0; c<nx; c++) dest[r*nx+c] = rm->V(c, ny-1-r);
+                }
             }
         }
     }
@@ -94,124 +1420,192 @@ using namespace src::util;
     /*
      *--------------------------------------------------------------------------------------
      *       Class:  SurfaceTopologyOutput
-     *      Method:  SurfaceTopologyOutput :: ~SurfaceTopologyOutput
-     * Description:  Destructor
+     *      Method:  SurfaceTopologyOutput :: WriteRasterStream
+     * Description:  Writes each field of a raster-stream as 
+     *               <prefix>.<stream-name>.<field>.<time-step>.flt, along with an ESRI 
+     *               .hdr file, or as a headerless .raw file of Float32 values.
      *--------------------------------------------------------------------------------------
      */
-    SurfaceTopologyOutput::~SurfaceTopologyOutput()
+    void SurfaceTopologyOutput::WriteRasterStream(const Snapshot *s, const OutputStream &os, const vector<float> &values)
     {
-    }
+        const RegularMesh *rm = os.raster;
+        int nx = rm->NX();
+        int ny = rm->NY();
+
+        for(unsigned int f=0; f<os.fields.size(); f++)
+        {
+            char fileName[256]={0};
+            sprintf(fileName, "%s%s.%s.%s.%d.%s", m_path.c_str(), m_prefix.c_str(), os.name.c_str(), 
+                    os.fields[f].c_str(), s->ts, os.raw ? "raw" : "flt");
+            printf ("Writing %s\n", fileName);
+
+            ofstream ofs(fileName, ios::out | ios::binary);
+            ofs.write((const char*)&values[f*nx*ny], sizeof(float)*nx*ny);
+            ofs.close();
 
+            if(os.raw) continue;
+
+            strcpy(fileName + strlen(fileName) - 3, "hdr");
+            ofstream hdr(fileName);
+            hdr.precision(12);
+            hdr << "ncols         " << nx << endl;
+            hdr << "nrows         " << ny << endl;
+            hdr << "xllcenter     " << rm->GridX(0) << endl;
+            hdr << "yllcenter     " << rm->GridY(0) << endl;
+            hdr << "cellsize      " << os.cellSize << endl;
+            hdr << "NODATA_value  " << NODATA << endl;
+            hdr << "byteorder     " << (IsBigEndianHost() ? "MSBFIRST" : "LSBFIRST") << endl;
+        }
+    }
 
     /*
      *--------------------------------------------------------------------------------------
      *       Class:  SurfaceTopologyOutput
-     *      Method:  SurfaceTopologyOutput :: RegisterScalarField
-     * Description:  Method to register scalar-fields for output, which are destroyed 
-     *               immediately after they are written.
+     *      Method:  SurfaceTopologyOutput :: WriteVTKStream
+     * Description:  Write the part of the unstructured-grid covered by an output-stream
      *--------------------------------------------------------------------------------------
      */
-    void SurfaceTopologyOutput::RegisterScalarField(ScalarField<float> *sf)
+    void SurfaceTopologyOutput::WriteVTKStream(const Snapshot *s, const OutputStream &os)
     {
-        m_registeredScalarFields.push_back(sf);
+        char fileName[256]={0};
+        sprintf(fileName, "%s%s.%s.%d.vtu", m_path.c_str(), m_prefix.c_str(), os.name.c_str(), s->ts);
+        printf ("Writing %s\n", fileName);
+
+        if(os.type == Stream_Catchments)
+        {
+            int np = m_surfaceTopology->m_nMeshPoints;
+            vector<char> selected(np, 0);
+            for(int i=0; i<np; i++) selected[i] = os.catchments.count(s->cid[i]) > 0;
+
+            MeshPiece piece;
+            BuildSubsetPiece(selected, piece);
+            WriteVTKMeshPiece(s, piece, fileName);
+        }
+        else
+        {
+            WriteVTKMeshPiece(s, os.piece, fileName);
+        }
     }
 
     /*
      *--------------------------------------------------------------------------------------
      *       Class:  SurfaceTopologyOutput
-     *      Method:  SurfaceTopologyOutput :: Write
-     * Description:  Writes output after specific intervals
+     *      Method:  SurfaceTopologyOutput :: WriteVTKMesh
+     * Description:  Write unstructured-grid along with associated field variables. When 
+     *               the mesh is split into several pieces, they are written concurrently
+     *               and indexed by a .pvtu file.
      *--------------------------------------------------------------------------------------
      */
-    void SurfaceTopologyOutput::Write()
+    void SurfaceTopologyOutput::WriteVTKMesh(const Snapshot *s)
     {
-        float t = m_model->GetTime();
-        int   ts = m_model->GetTimeStep();
+        char fileName[256]={0};
         
-        if(ts % m_frequency) 
+        if(m_nPieces == 1)
         {
-            /*-----------------------------------------------------------------------------
-             * Delete registered scalar-fields
-             *-----------------------------------------------------------------------------*/
-            for(unsigned int i=0; i<m_registeredScalarFields.size(); i++)
-            {
-                delete m_registeredScalarFields[i];
-            }
-            m_registeredScalarFields.clear();
-            
+            sprintf(fileName, "%s%s.mesh.%d.vtu", m_path.c_str(), m_prefix.c_str(), s->ts);
+            printf ("Writing %s\n", fileName);
+
+            WriteVTKMeshPiece(s, m_meshPieces[0], fileName);
             return;
         }
 
-        if(m_outputFormat=="vtk")
+        sprintf(fileName, "%s%s.mesh.%d.pvtu", m_path.c_str(), m_prefix.c_str(), s->ts);
+        printf ("Writing %s (%d pieces)\n", fileName, m_nPieces);
+        
+        WriteVTKMeshIndex(s, fileName);
+
+        #pragma omp parallel for schedule(dynamic)
+        for(int p=0; p<m_nPieces; p++)
         {
-            if(m_writeMesh)     WriteVTKMesh(t, ts);
-            if(m_writeDrainage) WriteVTKDrainage(t, ts);
+            char pieceFileName[256]={0};
+            sprintf(pieceFileName, "%s%s.mesh.%d.%d.vtu", m_path.c_str(), m_prefix.c_str(), s->ts, p);
+
+            WriteVTKMeshPiece(s, m_meshPieces[p], pieceFileName);
         }
-        else
-            cerr << "Warning: Only vtk-output is currently supported." << endl;
     }
 
-    /*-----------------------------------------------------------------------------
-     * Private internals 
-     *-----------------------------------------------------------------------------*/
-
     /*
      *--------------------------------------------------------------------------------------
      *       Class:  SurfaceTopologyOutput
-     *      Method:  SurfaceTopologyOutput :: WriteDataArray
-     * Description:  Write a data-array associated with vtk point-data
+     *      Method:  SurfaceTopologyOutput :: WriteVTKMeshIndex
+     * Description:  Write .pvtu file listing the arrays and pieces of a partitioned mesh.
+     *               Array declarations must match those in WriteVTKMeshPiece.
      *--------------------------------------------------------------------------------------
      */
-    template<class T>
-    void SurfaceTopologyOutput::WriteDataArray(ofstream &ofs, int nElem, T *data, int nComponents, string dataType, string name)
+    void SurfaceTopologyOutput::WriteVTKMeshIndex(const Snapshot *s, const char *fileName)
     {
-        const int itemsPerLine = 10;
-        char buffer[1024] = {0};
-        
-        sprintf(buffer, "<DataArray type=\"%s\" Name=\"%s\" format=\"ascii\"  NumberOfComponents=\"%d\">",
-                dataType.c_str(), name.c_str(), nComponents);
+        ofstream indexFile(fileName);
 
-        ofs << buffer << endl;
+        indexFile << "<?xml version=\"1.0\"?>" << endl;
+        indexFile << "<VTKFile type=\"PUnstructuredGrid\" version=\"0.1\" byte_order=\"" 
+                  << (IsBigEndianHost() ? "BigEndian" : "LittleEndian") << "\"";
+        if(m_binary) indexFile << " header_type=\"UInt64\"";
+        indexFile << ">" << endl;
+        indexFile << "<PUnstructuredGrid GhostLevel=\"0\">" << endl;
         
-        for(int i=0; i<nElem; i++)
+        /* PPointData */
+        indexFile << "<PPointData Scalars=\"h\">" << endl;
         {
-            ofs << data[i] << " ";
-            if((!(i%itemsPerLine)) && (i>0)) ofs << endl;
+            const char *arrays[][2] = {{"Float32", "h"}, {"Float32", "bc"}, {"Int32", "cid"}, 
+                                       {"Int32", "rid"}, {"Int32", "id"}, {"Float32", "dh"}, 
+                                       {"Int32", "order"}, {"Float32", "t"}};
+            
+            for(unsigned int i=0; i<sizeof(arrays)/sizeof(arrays[0]); i++)
+                indexFile << "<PDataArray type=\"" << arrays[i][0] << "\" Name=\"" << arrays[i][1] 
+                          << "\" NumberOfComponents=\"1\"/>" << endl;
+
+            for(unsigned int i=0; i<s->fieldNames.size(); i++)
+                indexFile << "<PDataArray type=\"Float32\" Name=\"" << s->fieldNames[i] 
+                          << "\" NumberOfComponents=\"1\"/>" << endl;
         }
+        indexFile << "</PPointData>" << endl;
 
-        ofs << "</DataArray>" << endl;
+        /* PCellData */
+        indexFile << "<PCellData>" << endl;
+        indexFile << "</PCellData>" << endl;
+
+        /* PPoints */
+        indexFile << "<PPoints>" << endl;
+        indexFile << "<PDataArray type=\"Float32\" Name=\"Points\" NumberOfComponents=\"3\"/>" << endl;
+        indexFile << "</PPoints>" << endl;
+
+        /* Pieces are referenced relative to the .pvtu file */
+        for(int p=0; p<m_nPieces; p++)
+        {
+            indexFile << "<Piece Source=\"" << m_prefix << ".mesh." << s->ts << "." << p << ".vtu\"/>" << endl;
+        }
+
+        indexFile << "</PUnstructuredGrid>" << endl;
+        indexFile << "</VTKFile>" << endl;
+        indexFile.close();
     }
 
     /*
      *--------------------------------------------------------------------------------------
      *       Class:  SurfaceTopologyOutput
-     *      Method:  SurfaceTopologyOutput :: WriteVTKMesh
-     * Description:  Write unstructured-grid along with associated field variables
+     *      Method:  SurfaceTopologyOutput :: WriteVTKMeshPiece
+     * Description:  Write a piece of the unstructured-grid along with associated field 
+     *               variables. Uses only local state, so that pieces can be written 
+     *               concurrently.
      *--------------------------------------------------------------------------------------
      */
-    void SurfaceTopologyOutput::WriteVTKMesh( float t, int ts)
+    void SurfaceTopologyOutput::WriteVTKMeshPiece(const Snapshot *s, const MeshPiece &piece, const char *fileName)
     {
         const SurfaceTopology *st = m_surfaceTopology;
-        int np = st->m_nMeshPoints;
-        Triangulator *tr = st->m_triangulator;
+        const vector<int> &nodes = piece.nodes;
+        int np = nodes.size();
+        int ntri = piece.connectivity.size()/3;
 
-        char fileName[256]={0};
-        sprintf(fileName, "%s%s.mesh.%d.vtu", m_path.c_str(), m_prefix.c_str(), ts);
-        
-        ofstream meshFile;
-        meshFile.precision(4);
-        meshFile.open(fileName, ios_base::out);
-        printf ("Writing %s\n", fileName);
+        VTKFile meshFile;
+        OpenVTKFile(meshFile, fileName, "UnstructuredGrid");
 
-        meshFile << "<?xml version=\"1.0\"?>" << endl;
-        meshFile << "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\" byte_order=\"LittleEndian\">" << endl;
         meshFile << "<UnstructuredGrid>" << endl;
         
         /* piece begin */
         {
             char buffer[1024] = {0};
             sprintf(buffer, "<Piece NumberOfPoints=\"%d\" NumberOfCells=\"%ld\">", 
-                    st->m_nMeshPoints, tr->GetNumTriangles());
+                    np, (long int)ntri);
             meshFile << buffer << endl;
         }
 
@@ -220,50 +1614,49 @@ using namespace src::util;
         {
             /* h */
             {
-                vector<float> h(np); for(int i=0; i<np; i++) h[i] = st->Zp(i)*SCALAR;
+                vector<float> h(np); for(int i=0; i<np; i++) h[i] = s->zp[nodes[i]]*SCALAR;
                 WriteDataArray(meshFile, np, h.data(), 1, "Float32", "h");
             }
             
             /* bc */
             {
-                vector<float> bc(np); for(int i=0; i<np; i++) bc[i] = st->B(i);
+                vector<float> bc(np); for(int i=0; i<np; i++) bc[i] = st->B(nodes[i]);
                 WriteDataArray(meshFile, np, bc.data(), 1, "Float32", "bc");
             }
      
             /* cid */
             {
-                vector<int> cid(np); for(int i=0; i<np; i++) cid[i] = st->C(i);
+                vector<int> cid(np); for(int i=0; i<np; i++) cid[i] = s->cid[nodes[i]];
                 WriteDataArray(meshFile, np, cid.data(), 1, "Int32", "cid");
             }
 
             /* rid */
             {
-                vector<int> rid(np); for(int i=0; i<np; i++) rid[i] = st->R(i);
+                vector<int> rid(np); for(int i=0; i<np; i++) rid[i] = s->rid[nodes[i]];
                 WriteDataArray(meshFile, np, rid.data(), 1, "Int32", "rid");
             }
 
             /* id */
             {
-                vector<int> id(np); for(int i=0; i<np; i++) id[i] = i;
-                WriteDataArray(meshFile, np, id.data(), 1, "Int32", "id");
+                WriteDataArray(meshFile, np, nodes.data(), 1, "Int32", "id");
             }
 
             /* dh */
             {
-                vector<float> dh(np); for(int i=0; i<np; i++) dh[i] = st->Z(i)*SCALAR - 
-                                                                      st->Z0(i)*SCALAR;
+                vector<float> dh(np); for(int i=0; i<np; i++) dh[i] = s->z[nodes[i]]*SCALAR - 
+                                                                      st->Z0(nodes[i])*SCALAR;
                 WriteDataArray(meshFile, np, dh.data(), 1, "Float32", "dh");
             }
 
             /* order */
             {
-                vector<int> order(np); for(int i=0; i<np; i++) order[i] = st->O(i);
+                vector<int> order(np); for(int i=0; i<np; i++) order[i] = st->O(nodes[i]);
                 WriteDataArray(meshFile, np, order.data(), 1, "Int32", "order");
             }
 
             /* t */
             {
-                vector<float> mt(np); for(int i=0; i<np; i++) mt[i] = t;
+                vector<float> mt(np); for(int i=0; i<np; i++) mt[i] = s->t;
                 WriteDataArray(meshFile, np, mt.data(), 1, "Float32", "t");
             }
 
@@ -271,25 +1664,11 @@ using namespace src::util;
             /*-----------------------------------------------------------------------------
              * Output registered scalar-fields
              *-----------------------------------------------------------------------------*/
-            for(unsigned int i=0; i<m_registeredScalarFields.size(); i++)
-            {
-                ScalarField<float>* sf = m_registeredScalarFields[i];
-                int length = sf->GetLength();
-
-                vector<float> vf(length); 
-                for(int j=0; j<length; j++) vf[j] = (*sf)(j);
-                
-                WriteDataArray(meshFile, length, vf.data(), 1, "Float32", sf->GetName());
-            }
-
-            /*-----------------------------------------------------------------------------
-             * Delete registered scalar-fields
-             *-----------------------------------------------------------------------------*/
-            for(unsigned int i=0; i<m_registeredScalarFields.size(); i++)
+            for(unsigned int i=0; i<s->fields.size(); i++)
             {
-                delete m_registeredScalarFields[i];
+                vector<float> vf(np); for(int j=0; j<np; j++) vf[j] = s->fields[i][nodes[j]];
+                WriteDataArray(meshFile, np, vf.data(), 1, "Float32", s->fieldNames[i]);
             }
-            m_registeredScalarFields.clear();
         }
         meshFile << "</PointData>" << endl;
 
@@ -303,9 +1682,9 @@ using namespace src::util;
             vector<float> coords(np*3);
             for(int i=0; i<np; i++)
             {
-                coords[i*3]   = st->X(i);
-                coords[i*3+1] = st->Y(i);
-                coords[i*3+2] = st->Z(i)*SCALAR;
+                coords[i*3]   = st->X(nodes[i]);
+                coords[i*3+1] = st->Y(nodes[i]);
+                coords[i*3+2] = s->z[nodes[i]]*SCALAR;
             }
 
             WriteDataArray(meshFile, np*3, coords.data(), 3, "Float32", "Points");
@@ -315,18 +1694,9 @@ using namespace src::util;
         /* Cells */
         meshFile << "<Cells>" << endl;
         {
-            int ntri = tr->GetNumTriangles();
-            unsigned int **triIndices = tr->GetTriangleIndices();
-            
             /* connectivity */
             {
-                vector<long int> triIndicesVector(ntri*3);
-
-                for(int i=0; i<ntri; i++)
-                    for(int j=0; j<3; j++)
-                        triIndicesVector[i*3+j] = triIndices[i][j];
-                
-                WriteDataArray(meshFile, ntri*3, triIndicesVector.data(), 1, "Int64", "connectivity");
+                WriteDataArray(meshFile, ntri*3, piece.connectivity.data(), 1, "Int64", "connectivity");
             }
 
             /* offsets */
@@ -348,117 +1718,43 @@ using namespace src::util;
         meshFile << "</Cells>" << endl;
         meshFile << "</Piece>" << endl;
         meshFile << "</UnstructuredGrid>" << endl;
-        meshFile << "</VTKFile>" << endl;
 
-        meshFile.close();
+        CloseVTKFile(meshFile);
     }
 
     /*
      *--------------------------------------------------------------------------------------
      *       Class:  SurfaceTopologyOutput
      *      Method:  SurfaceTopologyOutput :: WriteVTKDrainage
-     * Description:  Write vtp file for drainage-network.
+     * Description:  Write vtp file for drainage-network. Each channel segment is written 
+     *               once as a poly-line, along with its Strahler order and drainage area.
+     *               Nodes draining less than 'minDrainageArea' are omitted.
      *--------------------------------------------------------------------------------------
      */
-    void SurfaceTopologyOutput::WriteVTKDrainage( float t, int ts)
+    void SurfaceTopologyOutput::WriteVTKDrainage(const Snapshot *s)
     {
-        struct Recursor
-        {
-            static void TraverseUpstream(const SurfaceTopology *st, int node, vector<int> *pointVec)
-            {
-                for(int i=0; i<st->Dn(node); i++)
-                {
-                    int donor = st->D(node)[i];
-
-                    TraverseUpstream(st, donor, pointVec);
-                }
-                pointVec->push_back(node);
-            }
-        };
-
-        vector<int> globalPointIdList;
-        vector<int> connectivity;
-        vector<int> offsets;
-        int polyLineCount = 0;
-
-        for(int i=0; i<m_surfaceTopology->m_nMeshPoints; i++)
-        {
-            vector<int> catchmentNodes;
-            vector<int> visited(m_surfaceTopology->m_nMeshPoints);
-            if(m_surfaceTopology->B(i) || (m_surfaceTopology->R(i)==i)) 
-            {
-                if(m_surfaceTopology->Dn(i))
-                {
-                    Recursor::TraverseUpstream(m_surfaceTopology, i, 
-                                               &catchmentNodes);
-                }
-                
-                if(catchmentNodes.size())
-                {
-                    for(unsigned int j=0; j<catchmentNodes.size(); j++)
-                    {
-                        int node = catchmentNodes[j];
-
-                        vector<int> pointIdList; 
-                        int visitedAddCount=0;
-                        while(!visitedAddCount)
-                        {
-                            if(visited[node]) visitedAddCount++;
-                            pointIdList.push_back(node);
-                            visited[node] = 1;
-                            
-                            node = m_surfaceTopology->R(node);
-                            
-                            /* Termination condition */
-                            if(m_surfaceTopology->R(node)==node)
-                            {
-                                int lastnode = m_surfaceTopology->R(node);
-                                if(visited[lastnode]) visitedAddCount++;
-                                
-                                pointIdList.push_back(lastnode);
-                                visited[lastnode] = 1;
-                                break;
-                            }
-                        }
-
-                        if(pointIdList.size()>1)
-                        {
-                            int pointIdListSize = pointIdList.size();
-                            int connectivitySize = connectivity.size();
-                            int offsetsSize = offsets.size();
-
-                            for(int i=0; i<pointIdListSize; i++)
-                            {
-                                globalPointIdList.push_back(pointIdList[i]);
-                                connectivity.push_back(connectivitySize+i);
-                            }
-                            
-                            if(offsetsSize)
-                                offsets.push_back(offsets[offsetsSize-1] + pointIdListSize);
-                            else
-                                offsets.push_back(pointIdListSize);
-
-                            polyLineCount++;
-                        }
-                    }
-                }
-            }
-        }
+        DrainageNetwork &dn = m_drainageNetwork;
+        dn.Extract(m_surfaceTopology->m_nMeshPoints, s->rid.data(), s->donorOffsets.data(), 
+                   s->donors.data(), m_cellAreas.data(), m_minDrainageArea);
+        
+        const vector<int> &globalPointIdList = dn.GetSegmentNodes();
+        const vector<int> &offsets = dn.GetSegmentOffsets();
+        int polyLineCount = dn.GetNumSegments();
+        
+        vector<int> connectivity(globalPointIdList.size());
+        for(unsigned int i=0; i<connectivity.size(); i++) connectivity[i] = i;
 
         /*-----------------------------------------------------------------------------
          * Write drainage network
          *-----------------------------------------------------------------------------*/
         int globalPointIdListSize = globalPointIdList.size();
         char fileName[256]={0};
-        sprintf(fileName, "%s%s.drainage.%d.vtp", m_path.c_str(), m_prefix.c_str(), ts);
+        sprintf(fileName, "%s%s.drainage.%d.vtp", m_path.c_str(), m_prefix.c_str(), s->ts);
         printf ("Writing %s\n", fileName);
         
-        ofstream drainageFile;
-        drainageFile.precision(4);
-        drainageFile.open(fileName, ios_base::out);
+        VTKFile drainageFile;
+        OpenVTKFile(drainageFile, fileName, "PolyData");
 
-        drainageFile << "<?xml version=\"1.0\"?>" << endl;
-        drainageFile << "<VTKFile type=\"PolyData\" version=\"0.1\" byte_order=\"LittleEndian\">" << endl;
         drainageFile << "<PolyData>" << endl;
         
         /* piece begin */
@@ -477,7 +1773,7 @@ using namespace src::util;
             {
                 coords[i*3]   = m_surfaceTopology->X(globalPointIdList[i]);
                 coords[i*3+1] = m_surfaceTopology->Y(globalPointIdList[i]);
-                coords[i*3+2] = m_surfaceTopology->Z(globalPointIdList[i])*SCALAR;
+                coords[i*3+2] = s->z[globalPointIdList[i]]*SCALAR;
             }
 
             WriteDataArray(drainageFile, globalPointIdListSize*3, coords.data(), 3, "Float32", "Points");
@@ -489,21 +1785,21 @@ using namespace src::util;
             /* h */
             {
                 vector<float> h(globalPointIdListSize); 
-                for(int i=0; i<globalPointIdListSize; i++) h[i] = m_surfaceTopology->Zp(globalPointIdList[i])*SCALAR;
+                for(int i=0; i<globalPointIdListSize; i++) h[i] = s->zp[globalPointIdList[i]]*SCALAR;
                 WriteDataArray(drainageFile, globalPointIdListSize, h.data(), 1, "Float32", "h");
             }
             
             /* cid */
             {
                 vector<int> cid(globalPointIdListSize); 
-                for(int i=0; i<globalPointIdListSize; i++) cid[i] = m_surfaceTopology->C(globalPointIdList[i]);
+                for(int i=0; i<globalPointIdListSize; i++) cid[i] = s->cid[globalPointIdList[i]];
                 WriteDataArray(drainageFile, globalPointIdListSize, cid.data(), 1, "Int32", "cid");
             }
 
             /* rid */
             {
                 vector<int> rid(globalPointIdListSize); 
-                for(int i=0; i<globalPointIdListSize; i++) rid[i] = m_surfaceTopology->R(globalPointIdList[i]);
+                for(int i=0; i<globalPointIdListSize; i++) rid[i] = s->rid[globalPointIdList[i]];
                 WriteDataArray(drainageFile, globalPointIdListSize, rid.data(), 1, "Int32", "rid");
             }
 
@@ -518,14 +1814,23 @@ using namespace src::util;
             {
                 vector<float> dh(globalPointIdListSize); 
                 for(int i=0; i<globalPointIdListSize; i++) 
-                    dh[i] = m_surfaceTopology->Z(globalPointIdList[i])*SCALAR - 
-                            m_surfaceTopology->Zp(globalPointIdList[i])*SCALAR;
+                    dh[i] = s->z[globalPointIdList[i]]*SCALAR - 
+                            s->zp[globalPointIdList[i]]*SCALAR;
                 WriteDataArray(drainageFile, globalPointIdListSize, dh.data(), 1, "Float32", "dh");
             }        
+
+            /* area */
+            {
+                vector<float> area(globalPointIdListSize); 
+                for(int i=0; i<globalPointIdListSize; i++) area[i] = dn.GetDrainageAreas()[globalPointIdList[i]];
+                WriteDataArray(drainageFile, globalPointIdListSize, area.data(), 1, "Float32", "area");
+            }
         drainageFile << "</PointData>" << endl;
 
         /* CellData */
         drainageFile << "<CellData>" << endl;
+            WriteDataArray(drainageFile, polyLineCount, dn.GetSegmentOrders().data(), 1, "Int32", "strahler");
+            WriteDataArray(drainageFile, polyLineCount, dn.GetSegmentAreas().data(), 1, "Float32", "area");
         drainageFile << "</CellData>" << endl;
         
         /* Lines */
@@ -539,9 +1844,283 @@ using namespace src::util;
 
         drainageFile << "</Piece>" << endl;
         drainageFile << "</PolyData>" << endl;
-        drainageFile << "</VTKFile>" << endl;
 
-        drainageFile.close();            
+        CloseVTKFile(drainageFile);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: WriteHeavyData
+     * Description:  Appends a raw array to the heavy-data file and returns its offset
+     *--------------------------------------------------------------------------------------
+     */
+    template<class T>
+    long int SurfaceTopologyOutput::WriteHeavyData(int nElem, const T *data)
+    {
+        long int offset = m_heavyOffset;
+
+        m_heavyFile.write((const char*)data, sizeof(T)*nElem);
+        m_heavyOffset += sizeof(T)*nElem;
+
+        return offset;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: XDMFDataItem
+     * Description:  Returns a DataItem referencing an array in the heavy-data file
+     *--------------------------------------------------------------------------------------
+     */
+    string SurfaceTopologyOutput::XDMFDataItem(const char *numberType, long int nElem, int nComponents, long int offset)
+    {
+        char buffer[1024] = {0};
+        string heavyFileName = m_prefix + ".bin"; /* Relative to the .xmf file */
+        
+        if(nComponents > 1)
+            sprintf(buffer, "<DataItem Dimensions=\"%ld %d\" ", nElem, nComponents);
+        else
+            sprintf(buffer, "<DataItem Dimensions=\"%ld\" ", nElem);
+
+        string result = buffer;
+        sprintf(buffer, "NumberType=\"%s\" Precision=\"4\" Format=\"Binary\" Endian=\"%s\" Seek=\"%ld\">%s</DataItem>",
+                numberType, IsBigEndianHost() ? "Big" : "Little", offset, heavyFileName.c_str());
+        
+        return result + buffer;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: WriteXDMFTopology
+     * Description:  Creates the heavy-data file and the .xmf index and writes the static 
+     *               topology.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::WriteXDMFTopology()
+    {
+        const SurfaceTopology *st = m_surfaceTopology;
+        int np = st->m_nMeshPoints;
+        int ntri = st->GetNumTriangles();
+        const unsigned int **triIndices = st->GetTriangleIndices();
+
+        m_heavyFile.open(m_heavyFileName.c_str(), ios_base::out | ios_base::binary | ios_base::trunc);
+        if(!m_heavyFile.good())
+        {
+            cerr << "Error: could not create " << m_heavyFileName << ".." << endl;
+            exit(EXIT_FAILURE);
+        }
+        m_heavyOffset = 0;
+        printf ("Writing %s\n", m_heavyFileName.c_str());
+
+        {
+            vector<float> x(np), y(np), bc(np);
+            vector<int> id(np), order(np);
+
+            for(int i=0; i<np; i++)
+            {
+                x[i]     = st->X(i);
+                y[i]     = st->Y(i);
+                bc[i]    = st->B(i);
+                id[i]    = i;
+                order[i] = st->O(i);
+            }
+
+            m_xOffset     = WriteHeavyData(np, x.data());
+            m_yOffset     = WriteHeavyData(np, y.data());
+            m_bcOffset    = WriteHeavyData(np, bc.data());
+            m_idOffset    = WriteHeavyData(np, id.data());
+            m_orderOffset = WriteHeavyData(np, order.data());
+        }
+
+        {
+            vector<int> connectivity(ntri*3);
+            
+            for(int i=0; i<ntri; i++)
+                for(int j=0; j<3; j++)
+                    connectivity[i*3+j] = triIndices[i][j];
+
+            m_connectivityOffset = WriteHeavyData(ntri*3, connectivity.data());
+        }
+
+        /*-----------------------------------------------------------------------------
+         * Index with an empty temporal collection 
+         *-----------------------------------------------------------------------------*/
+        FILE *f = fopen(m_xdmfFileName.c_str(), "w");
+        if(!f)
+        {
+            cerr << "Error: could not create " << m_xdmfFileName << ".." << endl;
+            exit(EXIT_FAILURE);
+        }
+
+        fprintf(f, "<?xml version=\"1.0\" ?>\n");
+        fprintf(f, "<!DOCTYPE Xdmf SYSTEM \"Xdmf.dtd\" []>\n");
+        fprintf(f, "<Xdmf Version=\"2.0\">\n");
+        fprintf(f, "<Domain>\n");
+        fprintf(f, "<Grid Name=\"%s\" GridType=\"Collection\" CollectionType=\"Temporal\">\n", m_prefix.c_str());
+        m_xdmfTail = ftell(f);
+        fprintf(f, "</Grid>\n</Domain>\n</Xdmf>\n");
+        fclose(f);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: RestoreXDMF
+     * Description:  Reopens the heavy-data file and the .xmf index of a restarted run. 
+     *               Both are cut back to their extent at the checkpoint, which drops any
+     *               steps written after it, and the temporal collection is closed again.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::RestoreXDMF()
+    {
+        string index;
+        {
+            ifstream ifs(m_xdmfFileName.c_str(), ios_base::in | ios_base::binary);
+            ostringstream oss;
+            oss << ifs.rdbuf();
+            index = oss.str();
+        }
+
+        ifstream heavy(m_heavyFileName.c_str(), ios_base::in | ios_base::binary | ios_base::ate);
+        long int heavySize = heavy.good() ? (long int)heavy.tellg() : 0;
+        heavy.close();
+
+        if((heavySize < m_heavyOffset) || ((long int)index.length() < m_xdmfTail))
+        {
+            cerr << "Error: " << m_heavyFileName << " and " << m_xdmfFileName 
+                 << " do not extend to the checkpoint being restarted from.." << endl;
+            exit(EXIT_FAILURE);
+        }
+
+        if(truncate(m_heavyFileName.c_str(), m_heavyOffset) != 0)
+        {
+            cerr << "Error: could not truncate " << m_heavyFileName << ".." << endl;
+            exit(EXIT_FAILURE);
+        }
+
+        m_heavyFile.open(m_heavyFileName.c_str(), ios_base::out | ios_base::binary | ios_base::app);
+        if(!m_heavyFile.good())
+        {
+            cerr << "Error: could not open " << m_heavyFileName << ".." << endl;
+            exit(EXIT_FAILURE);
+        }
+
+        FILE *f = fopen(m_xdmfFileName.c_str(), "w");
+        if(!f)
+        {
+            cerr << "Error: could not open " << m_xdmfFileName << ".." << endl;
+            exit(EXIT_FAILURE);
+        }
+
+        fwrite(index.data(), 1, m_xdmfTail, f);
+        fprintf(f, "</Grid>\n</Domain>\n</Xdmf>\n");
+        fclose(f);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  SurfaceTopologyOutput
+     *      Method:  SurfaceTopologyOutput :: WriteXDMF
+     * Description:  Appends time-varying arrays of a snapshot to the heavy-data file and 
+     *               adds a grid referencing them, along with the static topology, to the
+     *               temporal collection in the .xmf index.
+     *--------------------------------------------------------------------------------------
+     */
+    void SurfaceTopologyOutput::WriteXDMF(const Snapshot *s)
+    {
+        const SurfaceTopology *st = m_surfaceTopology;
+        int np = st->m_nMeshPoints;
+        int ntri = st->GetNumTriangles();
+
+        if(!m_heavyFile.is_open()) WriteXDMFTopology();
+        
+        printf ("Writing %s (time-step %d)\n", m_xdmfFileName.c_str(), s->ts);
+
+        /*-----------------------------------------------------------------------------
+         * Heavy data 
+         *-----------------------------------------------------------------------------*/
+        long int zOffset   = 0;
+        long int hOffset   = 0;
+        long int dhOffset  = 0;
+        {
+            vector<float> buffer(np);
+
+            for(int i=0; i<np; i++) buffer[i] = s->z[i]*SCALAR;
+            zOffset = WriteHeavyData(np, buffer.data());
+            
+            for(int i=0; i<np; i++) buffer[i] = s->zp[i]*SCALAR;
+            hOffset = WriteHeavyData(np, buffer.data());
+            
+            for(int i=0; i<np; i++) buffer[i] = s->z[i]*SCALAR - st->Z0(i)*SCALAR;
+            dhOffset = WriteHeavyData(np, buffer.data());
+        }
+        long int cidOffset = WriteHeavyData(np, s->cid.data());
+        long int ridOffset = WriteHeavyData(np, s->rid.data());
+        
+        vector<long int> fieldOffsets(s->fields.size());
+        for(unsigned int i=0; i<s->fields.size(); i++) 
+            fieldOffsets[i] = WriteHeavyData(s->fields[i].size(), s->fields[i].data());
+        
+        m_heavyFile.flush();
+
+        /*-----------------------------------------------------------------------------
+         * Light data 
+         *-----------------------------------------------------------------------------*/
+        ostringstream grid;
+        grid.precision(9);      /* Round-trips Float32 output-times */
+        
+        grid << "<Grid Name=\"" << m_prefix << "." << s->ts << "\" GridType=\"Uniform\">" << endl;
+        grid << "<Time Value=\"" << s->t << "\"/>" << endl;
+        grid << "<Topology TopologyType=\"Triangle\" NumberOfElements=\"" << ntri << "\">" << endl;
+        grid << XDMFDataItem("Int", ntri, 3, m_connectivityOffset) << endl;
+        grid << "</Topology>" << endl;
+        grid << "<Geometry GeometryType=\"X_Y_Z\">" << endl;
+        grid << XDMFDataItem("Float", np, 1, m_xOffset) << endl;
+        grid << XDMFDataItem("Float", np, 1, m_yOffset) << endl;
+        grid << XDMFDataItem("Float", np, 1, zOffset) << endl;
+        grid << "</Geometry>" << endl;
+
+        struct Attribute
+        {
+            const char *name;
+            const char *numberType;
+            long int offset;
+        } attributes[] = {{"h", "Float", hOffset}, {"bc", "Float", m_bcOffset}, {"cid", "Int", cidOffset}, 
+                          {"rid", "Int", ridOffset}, {"id", "Int", m_idOffset}, {"dh", "Float", dhOffset}, 
+                          {"order", "Int", m_orderOffset}};
+
+        for(unsigned int i=0; i<sizeof(attributes)/sizeof(attributes[0]); i++)
+        {
+            grid << "<Attribute Name=\"" << attributes[i].name << "\" AttributeType=\"Scalar\" Center=\"Node\">" << endl;
+            grid << XDMFDataItem(attributes[i].numberType, np, 1, attributes[i].offset) << endl;
+            grid << "</Attribute>" << endl;
+        }
+        
+        for(unsigned int i=0; i<s->fields.size(); i++)
+        {
+            grid << "<Attribute Name=\"" << s->fieldNames[i] << "\" AttributeType=\"Scalar\" Center=\"Node\">" << endl;
+            grid << XDMFDataItem("Float", s->fields[i].size(), 1, fieldOffsets[i]) << endl;
+            grid << "</Attribute>" << endl;
+        }
+        grid << "</Grid>" << endl;
+
+        /*-----------------------------------------------------------------------------
+         * Overwrite closing tags of the temporal collection with the new grid 
+         *-----------------------------------------------------------------------------*/
+        FILE *f = fopen(m_xdmfFileName.c_str(), "r+");
+        if(!f)
+        {
+            cerr << "Error: could not open " << m_xdmfFileName << ".." << endl;
+            exit(EXIT_FAILURE);
+        }
+
+        fseek(f, m_xdmfTail, SEEK_SET);
+        fputs(grid.str().c_str(), f);
+        m_xdmfTail = ftell(f);
+        fprintf(f, "</Grid>\n</Domain>\n</Xdmf>\n");
+        fclose(f);
     }
 
     /*
@@ -38,10 +38,14 @@
 #ifndef SRC_MESH_SURFACE_TOPOLOGY_OUTPUT_HH
 #define SRC_MESH_SURFACE_TOPOLOGY_OUTPUT_HH
 
+#include <pthread.h>
+#include <deque>
+
 #include <Model.hh>
 #include <SurfaceTopology.hh>
 #include <ScalarField.hh>
 #include <Config.hh>
+#include <DrainageNetwork.hh>
 
 namespace src { namespace mesh {
     using namespace src::mem;
@@ -69,12 +73,28 @@ namespace src { namespace mesh {
            SurfaceTopologyOutput_WriteNetwork   = (1<<1),
         }Attributes;
 
+        /*-----------------------------------------------------------------------------
+         * Interface for output-fields that are evaluated only when output is written.
+         * Providers are registered once and fill a buffer owned by 
+         * SurfaceTopologyOutput with the current values of the named field.
+         *-----------------------------------------------------------------------------*/
+        class FieldProvider
+        {
+            public:
+            virtual ~FieldProvider() {}
+            virtual void EvaluateOutputField(const string &name, vector<float> &values) = 0;
+        };
+
         SurfaceTopologyOutput(const Model *m, Config *c);
         ~SurfaceTopologyOutput();
 
+        void RegisterFieldProvider(string name, FieldProvider *fp);
         void RegisterScalarField(ScalarField<float> *sf);
 
         void Write();
+        void Flush();
+        void DiscardScalarFields();
+        void Serialize(Checkpoint *cp);
         
         /*-----------------------------------------------------------------------------
          * Private internals 
@@ -87,17 +107,199 @@ namespace src { namespace mesh {
         int    m_timeStepOffset;
         bool   m_writeMesh;
         bool   m_writeDrainage;
+        bool   m_binary;
         const Model *m_model;
         Config *m_config;
         const SurfaceTopology *m_surfaceTopology;
         void WriteVTK( float t, int ts);
         
         vector<ScalarField<float>*> m_registeredScalarFields;
+        vector< pair<string, FieldProvider*> > m_fieldProviders;
+
+        /*-----------------------------------------------------------------------------
+         * Copy of the time-varying state written at an output step. Static attributes
+         * (coordinates, BCs, triangulation) are read directly from SurfaceTopology.
+         *-----------------------------------------------------------------------------*/
+        struct Snapshot
+        {
+            float t;
+            int ts;
+            vector<float> z;
+            vector<float> zp;
+            vector<int> cid;
+            vector<int> rid;
+            vector<int> donorOffsets;   /* Donors of node i: donors[donorOffsets[i]..[i+1]] */
+            vector<int> donors;
+            vector<string> fieldNames;
+            vector< vector<float> > fields;
+            vector< vector<float> > streamValues;   /* Probe or raster values, per output-stream */
+        };
+
+        /*-----------------------------------------------------------------------------
+         * Asynchronous output: snapshots are handed to a writer thread through a queue
+         * bounded by the number of snapshot buffers (m_queueDepth).
+         *-----------------------------------------------------------------------------*/
+        bool   m_async;
+        int    m_queueDepth;
+        bool   m_shutdown;
+        bool   m_busy;
+        vector<Snapshot*> m_snapshots;
+        vector<Snapshot*> m_freeSnapshots;
+        deque<Snapshot*> m_pendingSnapshots;
+        pthread_t m_writerThread;
+        pthread_mutex_t m_mutex;
+        pthread_cond_t m_cond;
+
+        void TakeSnapshot(Snapshot *s, float t, int ts);
+        void WriteSnapshot(const Snapshot *s);
+        void WriterLoop();
+        static void *WriterThread(void *arg);
+
+        /*-----------------------------------------------------------------------------
+         * Spatial partition of the mesh into pieces, written concurrently as separate
+         * .vtu files and indexed by a .pvtu file. Nodes on piece-boundaries are 
+         * duplicated. The triangulation is static, so pieces are built only once.
+         *-----------------------------------------------------------------------------*/
+        struct MeshPiece
+        {
+            vector<int> nodes;              /* Global node-ids */
+            vector<long int> connectivity;  /* Local node-ids */
+        };
+        int m_nPieces;
+        vector<MeshPiece> m_meshPieces;
+        void BuildMeshPieces();
+        void BuildSubsetPiece(const vector<char> &selected, MeshPiece &piece);
+
+        /*-----------------------------------------------------------------------------
+         * Additional output streams, configured as sub-groups of 'output', each 
+         * covering part of the mesh and written at its own frequency: nodes within a
+         * bounding-box, nodes within a set of catchments, or a decimated 
+         * level-of-detail mesh. Catchments change over time, so their pieces are 
+         * built when written; the others are built only once. Probe-streams instead
+         * sample a set of sites, located once within the triangulation, and append 
+         * the interpolated values to a single csv or binary file. Raster-streams 
+         * write fields interpolated onto a regular grid, using barycentric weights 
+         * cached in the grid.
+         *-----------------------------------------------------------------------------*/
+        typedef enum StreamType_t
+        {
+            Stream_BoundingBox,
+            Stream_Catchments,
+            Stream_LevelOfDetail,
+            Stream_Probes,
+            Stream_Raster
+        }StreamType;
+
+        struct OutputStream
+        {
+            string name;
+            StreamType type;
+            int frequency;
+            MeshPiece piece;
+            set<int> catchments;
+            
+            /* Probes: site-coordinates, and vertices and barycentric weights of the
+             * enclosing triangles, 3 per site */
+            vector<float> sites;
+            vector<unsigned int> siteNodes;
+            vector<double> siteWeights;
+            bool binary;
+            bool headerWritten;
+
+            /* Rasters: grid and names of fields written as .flt/.hdr or raw Float32 */
+            RegularMesh *raster;
+            double cellSize;
+            vector<string> fields;
+            bool raw;
+        };
+        vector<OutputStream> m_streams;
+        vector<string> m_probeQuantities;
+        vector<ScalarField<float>*> m_probeFields;  /* NULL for elevation */
+        set<string> m_missingRasterFields;
+
+        void ReadOutputStreams();
+        void BuildLevelOfDetailPiece(int stride, MeshPiece &piece);
+        bool IsOutputStep(int ts);
+        void WriteVTKStream(const Snapshot *s, const OutputStream &os);
+        void ReadProbeSites(Config *sc, OutputStream &os);
+        void EvaluateProbes(Snapshot *s);
+        void WriteProbeStream(const Snapshot *s, OutputStream &os, const vector<float> &values);
+        void ReadRasterGrid(Config *sc, OutputStream &os);
+        void EvaluateRasters(Snapshot *s);
+        void WriteRasterStream(const Snapshot *s, const OutputStream &os, const vector<float> &values);
+
+        /*-----------------------------------------------------------------------------
+         * Output file along with its queue of arrays for the AppendedData section 
+         * (vtk-binary), so that several files can be written concurrently.
+         *-----------------------------------------------------------------------------*/
+        struct VTKFile : public ofstream
+        {
+            vector< vector<char> > appendedArrays;
+            long int appendedOffset;
+            
+            /* Statistics for lossy-compressed arrays */
+            double rawBytes;
+            double encodedBytes;
+            double encodeTime;
+        };
+
+        void WriteVTKMesh(const Snapshot *s);
+        void WriteVTKMeshPiece(const Snapshot *s, const MeshPiece &piece, const char *fileName);
+        void WriteVTKMeshIndex(const Snapshot *s, const char *fileName);
+        void WriteVTKDrainage(const Snapshot *s);
+
+        /* Drainage-network extraction */
+        DrainageNetwork m_drainageNetwork;
+        vector<float> m_cellAreas;
+        float m_minDrainageArea;
+        template <class T>
+        void WriteDataArray(VTKFile &ofs, int nElem, T *data, int nComponents, string dataType, string name);
+        template <class T>
+        void WriteAsciiValues(VTKFile &ofs, int nElem, T *data);
+        
+        /* Appended-data (vtk-binary) output */
+        template <class T>
+        void AppendDataArray(VTKFile &ofs, int nElem, T *data, string dataType);
+        void OpenVTKFile(VTKFile &ofs, const char *fileName, const char *type);
+        void CloseVTKFile(VTKFile &ofs);
+
+        /*-----------------------------------------------------------------------------
+         * Error-bounded lossy compression of Float32 point-data (vtk-binary). Encoded
+         * arrays are tagged with compression="lossy" and are converted back to plain 
+         * vtk-binary files by the 'spgmdecode' utility.
+         *-----------------------------------------------------------------------------*/
+        bool   m_lossy;
+        double m_errorBound;
+        template <class T>
+        void AppendLossyDataArray(VTKFile &ofs, int nElem, T *data);
+        bool IsLossy(string dataType, string name);
+        
+        /*-----------------------------------------------------------------------------
+         * XDMF time-series output: static topology (x, y, triangles, bc, id, order) is 
+         * written once to a binary heavy-data file, to which per-step arrays are 
+         * appended. The light-weight .xmf index references both and is extended in 
+         * place after each step. On restart, both files are cut back to their state 
+         * at the checkpoint and appended to.
+         *-----------------------------------------------------------------------------*/
+        bool     m_xdmf;
+        ofstream m_heavyFile;
+        string   m_heavyFileName;
+        string   m_xdmfFileName;
+        long int m_heavyOffset;
+        long int m_xdmfTail;        /* Position of closing tags in the .xmf file */
+        long int m_xOffset;
+        long int m_yOffset;
+        long int m_connectivityOffset;
+        long int m_bcOffset;
+        long int m_idOffset;
+        long int m_orderOffset;
 
-        void WriteVTKMesh( float t, int ts);
-        void WriteVTKDrainage( float t, int ts);
+        void WriteXDMF(const Snapshot *s);
+        void WriteXDMFTopology();
+        void RestoreXDMF();
         template <class T>
-        void WriteDataArray(ofstream &ofs, int nElem, T *data, int nComponents, string dataType, string name);
+        long int WriteHeavyData(int nElem, const T *data);
+        string XDMFDataItem(const char *numberType, long int nElem, int nComponents, long int offset);
         
         void WriteTXT( float t, int ts);
     };
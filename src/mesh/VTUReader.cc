@@ -0,0 +1,803 @@
+/*
+ * =====================================================================================
+ * Scalable PaleoGeomorphology Model (SPGM)
+ *
+ * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * This program is free software; you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
+ * Place, Suite 330, Boston, MA 02111-1307 USA
+ * ===================================================================================== 
+ */
+/*
+ * =====================================================================================
+ *
+ *       Filename:  VTUReader.cc
+ *
+ *    Description:  Implementation of VTUReader
+ *
+ *        Version:  1.0
+ *        Created:  18/10/26 10:00:00
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * =====================================================================================
+ */
+
+#include <VTUReader.hh>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+namespace src { namespace mesh {
+    using namespace std;
+
+    const size_t BUFFER_SIZE        = 1<<20;
+    const size_t MAX_TOKEN_LENGTH   = 128;
+    const size_t CHUNK_SIZE         = 1<<16;
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  VTUReader
+     *      Method:  VTUReader :: VTUReader
+     * Description:  Constructor
+     *--------------------------------------------------------------------------------------
+     */
+    VTUReader::VTUReader(string fileName)
+    :m_fileName(fileName),
+    m_file(NULL),
+    m_begin(0),
+    m_end(0),
+    m_bufferOffset(0),
+    m_eof(false),
+    m_nPoints(-1),
+    m_bigEndian(false),
+    m_header64(false),
+    m_carryBegin(0),
+    m_carryEnd(0)
+    {
+        m_buffer.resize(BUFFER_SIZE);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  VTUReader
+     *      Method:  VTUReader :: ~VTUReader
+     * Description:  Destructor
+     *--------------------------------------------------------------------------------------
+     */
+    VTUReader::~VTUReader()
+    {
+        if(m_file) fclose(m_file);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  VTUReader
+     *      Method:  VTUReader :: Request
+     * Description:  Registers a DataArray to be decoded into 'result' on Read(). Values are
+     *               converted from their on-disk type. Optional arrays may be missing, 
+     *               which can be checked with Found().
+     *--------------------------------------------------------------------------------------
+     */
+    void VTUReader::Request(string name, vector<float> *result, bool optional)
+    {
+        ArrayRequest r;
+        r.name = name; r.floatResult = result; r.intResult = NULL;
+        r.found = false; r.optional = optional; r.appendedOffset = -1; r.type = VTUReader_Unknown; r.nComponents = 1;
+        m_requests.push_back(r);
+    }
+
+    void VTUReader::Request(string name, vector<int> *result, bool optional)
+    {
+        ArrayRequest r;
+        r.name = name; r.floatResult = NULL; r.intResult = result;
+        r.found = false; r.optional = optional; r.appendedOffset = -1; r.type = VTUReader_Unknown; r.nComponents = 1;
+        m_requests.push_back(r);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  VTUReader
+     *      Method:  VTUReader :: Found
+     * Description:  Returns true if the named DataArray was read successfully
+     *--------------------------------------------------------------------------------------
+     */
+    bool VTUReader::Found(string name) const
+    {
+        for(unsigned int i=0; i<m_requests.size(); i++)
+        {
+            if(m_requests[i].name == name) return m_requests[i].found;
+        }
+        return false;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  VTUReader
+     *      Method:  VTUReader :: Read
+     * Description:  Scans the file once, tag by tag. Inline arrays are decoded as they are
+     *               encountered and all other element content is skipped without being 
+     *               copied. Appended arrays are read by seeking to their offsets once the
+     *               AppendedData section is reached, which follows all pieces of the 
+     *               file; arrays of pieces other than the first are ignored.
+     *--------------------------------------------------------------------------------------
+     */
+    bool VTUReader::Read()
+    {
+        m_file = fopen(m_fileName.c_str(), "rb");
+        if(m_file == NULL)
+        {
+            m_error = "could not open file";
+            return false;
+        }
+
+        string tag;
+        string section;
+        int pieceCount = 0;
+
+        while(ReadTag(&tag))
+        {
+            size_t nameEnd = tag.find_first_of(" \t\r\n/>", 1);
+            if(tag[1] == '/')
+            {
+                if(tag.substr(2, tag.find_first_of(" \t\r\n>", 2)-2) == section) section = "";
+                continue;
+            }
+
+            string name = tag.substr(1, nameEnd-1);
+            bool selfClosing = (tag[tag.length()-2] == '/');
+
+            if(name == "VTKFile")
+            {
+                m_bigEndian = (Attribute(tag, "byte_order") == "BigEndian");
+                m_header64  = (Attribute(tag, "header_type") == "UInt64");
+                if(Attribute(tag, "compressor").length())
+                {
+                    m_error = "compressed data is not supported";
+                    return false;
+                }
+            }
+            else if(name == "Piece")
+            {
+                if(++pieceCount == 1)
+                {
+                    m_nPoints = atoi(Attribute(tag, "NumberOfPoints").c_str());
+                    continue;
+                }
+
+                /* Later pieces are skipped; appended arrays of the first piece are 
+                 * only reached at the end of the file */
+                bool appendedPending = false;
+                for(unsigned int i=0; i<m_requests.size(); i++)
+                {
+                    if(!m_requests[i].found && m_requests[i].appendedOffset >= 0) appendedPending = true;
+                }
+                if(!appendedPending) break;
+            }
+            else if(name == "Points" || name == "PointData" || name == "CellData" || 
+                    name == "Cells" || name == "FieldData")
+            {
+                if(!selfClosing) section = name;
+            }
+            else if(name == "DataArray")
+            {
+                if(pieceCount > 1) continue;
+
+                string key;
+                if(section == "Points") key = "Points";
+                else if(section == "PointData") key = Attribute(tag, "Name");
+                
+                ArrayRequest *r = key.length() ? FindRequest(key) : NULL;
+                if(r == NULL || r->found) continue;
+
+                string nc = Attribute(tag, "NumberOfComponents");
+                string format = Attribute(tag, "format");
+                r->type = ParseType(Attribute(tag, "type"));
+                r->nComponents = nc.length() ? atoi(nc.c_str()) : 1;
+
+                if(r->type == VTUReader_Unknown)
+                {
+                    m_error = "unsupported type for DataArray '" + key + "'";
+                    return false;
+                }
+                if(m_nPoints < 0)
+                {
+                    m_error = "DataArray encountered before Piece";
+                    return false;
+                }
+
+                if(format == "appended")
+                {
+                    r->appendedOffset = atol(Attribute(tag, "offset").c_str());
+                }
+                else if(format == "binary")
+                {
+                    if(!ReadBinaryArray(r, true)) return false;
+                }
+                else
+                {
+                    if(!ReadAsciiArray(r)) return false;
+                }
+            }
+            else if(name == "AppendedData")
+            {
+                bool base64 = (Attribute(tag, "encoding") == "base64");
+
+                if(!SkipTo('_'))
+                {
+                    m_error = "AppendedData marker not found";
+                    return false;
+                }
+                long long base = m_bufferOffset + m_begin + 1;
+
+                /* Visit appended arrays in file order */
+                vector<pair<long int, int> > order;
+                for(unsigned int i=0; i<m_requests.size(); i++)
+                {
+                    if(!m_requests[i].found && m_requests[i].appendedOffset >= 0)
+                        order.push_back(pair<long int, int>(m_requests[i].appendedOffset, i));
+                }
+                sort(order.begin(), order.end());
+
+                for(unsigned int i=0; i<order.size(); i++)
+                {
+                    if(!SeekTo(base + order[i].first))
+                    {
+                        m_error = "invalid offset into AppendedData";
+                        return false;
+                    }
+                    if(!ReadBinaryArray(&(m_requests[order[i].second]), base64)) return false;
+                }
+                break;
+            }
+        }
+
+        for(unsigned int i=0; i<m_requests.size(); i++)
+        {
+            if(!m_requests[i].found && !m_requests[i].optional)
+            {
+                m_error = "DataArray '" + m_requests[i].name + "' not found";
+                return false;
+            }
+        }
+
+        fclose(m_file);
+        m_file = NULL;
+        return true;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  VTUReader
+     *      Method:  VTUReader :: ParseNumber
+     * Description:  Parses decimal integers and floating-point numbers, including 'nan' and
+     *               'inf'. Up to 19 significant digits are accumulated into an integer 
+     *               mantissa, which is scaled exactly by a power of ten when possible.
+     *--------------------------------------------------------------------------------------
+     */
+    const char *VTUReader::ParseNumber(const char *begin, const char *end, double *result)
+    {
+        static const double pow10[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  
+                                         1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                         1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+        const char *p = begin;
+        bool negative = false;
+        
+        if(p < end && (*p == '-' || *p == '+')) 
+        {
+            negative = (*p == '-');
+            p++;
+        }
+
+        unsigned long long mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool any = false;
+
+        while(p < end && *p >= '0' && *p <= '9')
+        {
+            if(digits < 19) 
+            {
+                mantissa = mantissa*10 + (*p - '0');
+                if(mantissa) digits++;
+            }
+            else exponent++;
+            p++;
+            any = true;
+        }
+        
+        if(p < end && *p == '.')
+        {
+            p++;
+            while(p < end && *p >= '0' && *p <= '9')
+            {
+                if(digits < 19)
+                {
+                    mantissa = mantissa*10 + (*p - '0');
+                    if(mantissa) digits++;
+                    exponent--;
+                }
+                p++;
+                any = true;
+            }
+        }
+
+        if(!any)
+        {
+            /* Special values */
+            if(end - p >= 3)
+            {
+                char s[4] = { char(p[0] | 0x20), char(p[1] | 0x20), char(p[2] | 0x20), 0 };
+                if(!strcmp(s, "nan")) 
+                {
+                    *result = NAN;
+                    return p+3;
+                }
+                if(!strcmp(s, "inf"))
+                {
+                    *result = negative ? -INFINITY : INFINITY;
+                    p += 3;
+                    if(end - p >= 5 && !strncmp(p, "inity", 5)) p += 5;
+                    return p;
+                }
+            }
+            return NULL;
+        }
+
+        if(p < end && (*p == 'e' || *p == 'E'))
+        {
+            const char *q = p+1;
+            bool negativeExponent = false;
+            int e = 0;
+
+            if(q < end && (*q == '-' || *q == '+'))
+            {
+                negativeExponent = (*q == '-');
+                q++;
+            }
+            if(q < end && *q >= '0' && *q <= '9')
+            {
+                while(q < end && *q >= '0' && *q <= '9')
+                {
+                    if(e < 10000) e = e*10 + (*q - '0');
+                    q++;
+                }
+                exponent += negativeExponent ? -e : e;
+                p = q;
+            }
+        }
+
+        double value = double(mantissa);
+        if(mantissa == 0)                       value = 0.;
+        else if(exponent >= 0 && exponent <= 22)  value *= pow10[exponent];
+        else if(exponent < 0 && exponent >= -22)  value /= pow10[-exponent];
+        else                                    value *= pow(10., exponent);
+
+        *result = negative ? -value : value;
+        return p;
+    }
+
+    /*-----------------------------------------------------------------------------
+     * Private internals 
+     *-----------------------------------------------------------------------------*/
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  VTUReader
+     *      Method:  VTUReader :: Fill
+     * Description:  Makes sure at least 'minBytes' are available in the buffer, unless the
+     *               end of file has been reached. Returns true if the request was met.
+     *--------------------------------------------------------------------------------------
+     */
+    bool VTUReader::Fill(size_t minBytes)
+    {
+        if(m_end - m_begin >= minBytes) return true;
+        if(m_eof) return false;
+
+        size_t remaining = m_end - m_begin;
+        if(remaining) memmove(&m_buffer[0], &m_buffer[m_begin], remaining);
+        m_bufferOffset += m_begin;
+        m_begin = 0;
+        m_end = remaining;
+
+        while(m_end < minBytes && !m_eof)
+        {
+            size_t n = fread(&m_buffer[m_end], 1, m_buffer.size() - m_end, m_file);
+            if(n == 0) m_eof = true;
+            m_end += n;
+        }
+
+        return (m_end - m_begin >= minBytes);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  VTUReader
+     *      Method:  VTUReader :: SkipTo
+     * Description:  Advances the read position to the next occurrence of 'c'
+     *--------------------------------------------------------------------------------------
+     */
+    bool VTUReader::SkipTo(char c)
+    {
+        while(Fill(1))
+        {
+            const char *start = &m_buffer[m_begin];
+            const char *found = (const char *)memchr(start, c, m_end - m_begin);
+
+            if(found)
+            {
+                m_begin += found - start;
+                return true;
+            }
+            m_begin = m_end;
+        }
+        return false;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  VTUReader
+     *      Method:  VTUReader :: SkipPast
+     * Description:  Advances the read position past the next occurrence of 'pattern'
+     *--------------------------------------------------------------------------------------
+     */
+    bool VTUReader::SkipPast(const char *pattern)
+    {
+        size_t len = strlen(pattern);
+
+        while(Fill(len))
+        {
+            const char *start = &m_buffer[m_begin];
+            const char *stop = &m_buffer[m_end];
+            const char *found = search(start, stop, pattern, pattern+len);
+
+            if(found != stop)
+            {
+                m_begin += (found - start) + len;
+                return true;
+            }
+            m_begin = m_end - (len-1);
+            if(!Fill(m_end - m_begin + 1)) return false;
+        }
+        return false;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  VTUReader
+     *      Method:  VTUReader :: ReadTag
+     * Description:  Reads the next element tag, including angle brackets. Processing 
+     *               instructions and comments are skipped.
+     *--------------------------------------------------------------------------------------
+     */
+    bool VTUReader::ReadTag(string *tag)
+    {
+        while(SkipTo('<'))
+        {
+            if(Fill(4) && !strncmp(&m_buffer[m_begin], "<!--", 4))
+            {
+                if(!SkipPast("-->")) return false;
+                continue;
+            }
+
+            tag->clear();
+            while(Fill(1))
+            {
+                char c = m_buffer[m_begin++];
+
+                tag->push_back(c);
+                if(c == '>') break;
+            }
+            
+            if((*tag)[tag->length()-1] != '>') return false;
+            if((*tag)[1] == '?' || (*tag)[1] == '!') continue;
+
+            return true;
+        }
+        return false;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  VTUReader
+     *      Method:  VTUReader :: SeekTo
+     * Description:  Repositions the read position to an absolute file offset
+     *--------------------------------------------------------------------------------------
+     */
+    bool VTUReader::SeekTo(long long offset)
+    {
+        if(offset >= m_bufferOffset && offset < m_bufferOffset + (long long)m_end)
+        {
+            m_begin = offset - m_bufferOffset;
+            return true;
+        }
+        
+        if(fseeko(m_file, offset, SEEK_SET)) return false;
+
+        m_bufferOffset = offset;
+        m_begin = m_end = 0;
+        m_eof = false;
+        return true;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  VTUReader
+     *      Method:  VTUReader :: Attribute
+     * Description:  Returns the value of an attribute within a tag, or an empty string
+     *--------------------------------------------------------------------------------------
+     */
+    string VTUReader::Attribute(const string &tag, const char *name)
+    {
+        string key = string(name) + "=\"";
+        size_t pos = 0;
+
+        while((pos = tag.find(key, pos)) != string::npos)
+        {
+            if(pos > 0 && isspace(tag[pos-1]))
+            {
+                size_t begin = pos + key.length();
+                size_t end = tag.find('"', begin);
+
+                if(end == string::npos) return "";
+                return tag.substr(begin, end-begin);
+            }
+            pos++;
+        }
+        return "";
+    }
+
+    VTUReader::DataType VTUReader::ParseType(const string &type)
+    {
+        if(type == "Int8")      return VTUReader_Int8;
+        if(type == "UInt8")     return VTUReader_UInt8;
+        if(type == "Int16")     return VTUReader_Int16;
+        if(type == "UInt16")    return VTUReader_UInt16;
+        if(type == "Int32")     return VTUReader_Int32;
+        if(type == "UInt32")    return VTUReader_UInt32;
+        if(type == "Int64")     return VTUReader_Int64;
+        if(type == "UInt64")    return VTUReader_UInt64;
+        if(type == "Float32")   return VTUReader_Float32;
+        if(type == "Float64")   return VTUReader_Float64;
+        return VTUReader_Unknown;
+    }
+
+    int VTUReader::TypeSize(DataType type)
+    {
+        switch(type)
+        {
+            case VTUReader_Int8:    case VTUReader_UInt8:   return 1;
+            case VTUReader_Int16:   case VTUReader_UInt16:  return 2;
+            case VTUReader_Int32:   case VTUReader_UInt32:  
+            case VTUReader_Float32:                         return 4;
+            case VTUReader_Int64:   case VTUReader_UInt64:  
+            case VTUReader_Float64:                         return 8;
+            default:                                        return 0;
+        }
+    }
+
+    VTUReader::ArrayRequest *VTUReader::FindRequest(const string &name)
+    {
+        for(unsigned int i=0; i<m_requests.size(); i++)
+        {
+            if(m_requests[i].name == name) return &(m_requests[i]);
+        }
+        return NULL;
+    }
+
+    void VTUReader::Resize(ArrayRequest *r, size_t count)
+    {
+        if(r->floatResult) r->floatResult->resize(count);
+        else r->intResult->resize(count);
+    }
+
+    inline void VTUReader::Store(ArrayRequest *r, size_t index, double value)
+    {
+        if(r->floatResult) (*r->floatResult)[index] = float(value);
+        else (*r->intResult)[index] = int(value);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  VTUReader
+     *      Method:  VTUReader :: Store
+     * Description:  Converts a single value in on-disk representation
+     *--------------------------------------------------------------------------------------
+     */
+    void VTUReader::Store(ArrayRequest *r, size_t index, const char *bytes)
+    {
+        static const unsigned short one = 1;
+        static const bool hostBigEndian = (*((const unsigned char*)&one) == 0);
+        int size = TypeSize(r->type);
+        char v[8];
+
+        if(m_bigEndian != hostBigEndian) for(int i=0; i<size; i++) v[i] = bytes[size-1-i];
+        else memcpy(v, bytes, size);
+
+        double value = 0;
+        switch(r->type)
+        {
+            case VTUReader_Int8:    value = *((signed char*)v);         break;
+            case VTUReader_UInt8:   value = *((unsigned char*)v);       break;
+            case VTUReader_Int16:   value = *((short*)v);               break;
+            case VTUReader_UInt16:  value = *((unsigned short*)v);      break;
+            case VTUReader_Int32:   value = *((int*)v);                 break;
+            case VTUReader_UInt32:  value = *((unsigned int*)v);        break;
+            case VTUReader_Int64:   value = double(*((long long*)v));   break;
+            case VTUReader_UInt64:  value = double(*((unsigned long long*)v)); break;
+            case VTUReader_Float32: value = *((float*)v);               break;
+            case VTUReader_Float64: value = *((double*)v);              break;
+            default: break;
+        }
+        Store(r, index, value);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  VTUReader
+     *      Method:  VTUReader :: ReadAsciiArray
+     * Description:  Parses whitespace-separated values directly out of the read buffer
+     *--------------------------------------------------------------------------------------
+     */
+    bool VTUReader::ReadAsciiArray(ArrayRequest *r)
+    {
+        size_t count = size_t(m_nPoints) * r->nComponents;
+
+        Resize(r, count);
+        for(size_t i=0; i<count; i++)
+        {
+            while(Fill(1) && isspace(m_buffer[m_begin])) m_begin++;
+            Fill(MAX_TOKEN_LENGTH);
+
+            double value;
+            const char *start = &m_buffer[m_begin];
+            const char *stop = ParseNumber(start, &m_buffer[0] + m_end, &value);
+
+            if(stop == NULL)
+            {
+                m_error = "malformed or truncated DataArray '" + r->name + "'";
+                return false;
+            }
+            Store(r, i, value);
+            m_begin += stop - start;
+        }
+
+        r->found = true;
+        return true;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  VTUReader
+     *      Method:  VTUReader :: ReadBytes
+     * Description:  Reads the next 'n' bytes of binary data, decoding base64 if required.
+     *               Base64 quads are decoded independently, so that separately encoded
+     *               header and data blocks are handled alike.
+     *--------------------------------------------------------------------------------------
+     */
+    bool VTUReader::ReadBytes(char *dest, size_t n, bool base64)
+    {
+        size_t got = 0;
+
+        if(!base64)
+        {
+            while(got < n && Fill(1))
+            {
+                size_t k = min(n - got, m_end - m_begin);
+                memcpy(dest + got, &m_buffer[m_begin], k);
+                m_begin += k;
+                got += k;
+            }
+            return (got == n);
+        }
+
+        while(got < n)
+        {
+            if(m_carryBegin < m_carryEnd)
+            {
+                dest[got++] = m_carry[m_carryBegin++];
+                continue;
+            }
+
+            int quad[4], nq = 0;
+            while(nq < 4 && Fill(1))
+            {
+                char c = m_buffer[m_begin++];
+                
+                if(isspace(c)) continue;
+                if(c == '=') quad[nq] = -2;
+                else if(c >= 'A' && c <= 'Z') quad[nq] = c - 'A';
+                else if(c >= 'a' && c <= 'z') quad[nq] = c - 'a' + 26;
+                else if(c >= '0' && c <= '9') quad[nq] = c - '0' + 52;
+                else if(c == '+') quad[nq] = 62;
+                else if(c == '/') quad[nq] = 63;
+                else return false;
+                nq++;
+            }
+            if(nq < 4 || quad[0] < 0 || quad[1] < 0) return false;
+
+            m_carryBegin = 0; 
+            m_carryEnd = 1;
+            m_carry[0] = char((quad[0] << 2) | (quad[1] >> 4));
+            if(quad[2] >= 0)
+            {
+                m_carry[m_carryEnd++] = char(((quad[1] & 0xf) << 4) | (quad[2] >> 2));
+                if(quad[3] >= 0) m_carry[m_carryEnd++] = char(((quad[2] & 0x3) << 6) | quad[3]);
+            }
+        }
+        return true;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  VTUReader
+     *      Method:  VTUReader :: ReadBinaryArray
+     * Description:  Reads a binary array starting at the current position: a UInt32 (or 
+     *               UInt64) byte-count header followed by the data. Data is converted in
+     *               fixed-size chunks.
+     *--------------------------------------------------------------------------------------
+     */
+    bool VTUReader::ReadBinaryArray(ArrayRequest *r, bool base64)
+    {
+        int size = TypeSize(r->type);
+        size_t count = size_t(m_nPoints) * r->nComponents;
+        vector<char> chunk(CHUNK_SIZE - CHUNK_SIZE%size);
+        
+        m_carryBegin = m_carryEnd = 0;
+
+        /* Header */
+        {
+            static const unsigned short one = 1;
+            static const bool hostBigEndian = (*((const unsigned char*)&one) == 0);
+            int headerSize = m_header64 ? 8 : 4;
+            char bytes[8], v[8];
+
+            if(!ReadBytes(bytes, headerSize, base64))
+            {
+                m_error = "truncated DataArray '" + r->name + "'";
+                return false;
+            }
+
+            if(m_bigEndian != hostBigEndian) for(int i=0; i<headerSize; i++) v[i] = bytes[headerSize-1-i];
+            else memcpy(v, bytes, headerSize);
+            
+            unsigned long long nbytes = m_header64 ? *((unsigned long long*)v) : *((unsigned int*)v);
+            if(nbytes != (unsigned long long)(count*size))
+            {
+                m_error = "unexpected size for DataArray '" + r->name + "'";
+                return false;
+            }
+        }
+
+        /* Data */
+        Resize(r, count);
+        for(size_t index=0; index<count; )
+        {
+            size_t n = min((count - index)*size, chunk.size());
+
+            if(!ReadBytes(&chunk[0], n, base64))
+            {
+                m_error = "truncated DataArray '" + r->name + "'";
+                return false;
+            }
+            for(size_t i=0; i<n; i+=size) Store(r, index++, &chunk[i]);
+        }
+
+        r->found = true;
+        return true;
+    }
+}}
@@ -0,0 +1,142 @@
+/*
+ * =====================================================================================
+ * Scalable PaleoGeomorphology Model (SPGM)
+ *
+ * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * This program is free software; you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
+ * Place, Suite 330, Boston, MA 02111-1307 USA
+ * ===================================================================================== 
+ */
+/*
+ * =====================================================================================
+ *
+ *       Filename:  VTUReader.hh
+ *
+ *    Description:  Streaming reader for VTK XML unstructured-grid (.vtu) files. Only the
+ *                  requested DataArrays are decoded; no document tree is built.
+ *
+ *        Version:  1.0
+ *        Created:  18/10/26 10:00:00
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * =====================================================================================
+ */
+#ifndef SRC_MESH_VTU_READER_HH
+#define SRC_MESH_VTU_READER_HH
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace src { namespace mesh {
+    using namespace std;
+
+    /*
+     * =====================================================================================
+     *        Class:  VTUReader
+     *  Description:  Scans a .vtu file sequentially through a fixed-size buffer and 
+     *                decodes DataArrays that have been requested by name. ASCII, inline
+     *                base64 ('binary') and appended (raw or base64) encodings are 
+     *                supported; compressed data is not. The coordinate array is 
+     *                requested by the name "Points". Only the first Piece is read; later
+     *                pieces are skipped.
+     * =====================================================================================
+     */
+    class VTUReader
+    {
+        public:
+        VTUReader(string fileName);
+        ~VTUReader();
+
+        /* Read fails if a DataArray that is not optional is missing */
+        void Request(string name, vector<float> *result, bool optional=false);
+        void Request(string name, vector<int> *result, bool optional=false);
+
+        bool Read();
+        
+        int GetNumberOfPoints() const { return m_nPoints; }
+        bool Found(string name) const;
+        string GetError() const { return m_error; }
+
+        /*-----------------------------------------------------------------------------
+         * Locale-free number parsing. Parses a number from [begin, end) and returns 
+         * a pointer to the first character that was not consumed, or NULL if no 
+         * number could be parsed.
+         *-----------------------------------------------------------------------------*/
+        static const char *ParseNumber(const char *begin, const char *end, double *result);
+
+        /*-----------------------------------------------------------------------------
+         * Private internals 
+         *-----------------------------------------------------------------------------*/
+        private:
+        typedef enum DataType_t
+        {
+            VTUReader_Int8, VTUReader_UInt8, VTUReader_Int16, VTUReader_UInt16,
+            VTUReader_Int32, VTUReader_UInt32, VTUReader_Int64, VTUReader_UInt64,
+            VTUReader_Float32, VTUReader_Float64, VTUReader_Unknown
+        }DataType;
+
+        struct ArrayRequest
+        {
+            string name;
+            vector<float> *floatResult;
+            vector<int> *intResult;
+            bool found;
+            bool optional;
+            long int appendedOffset; /* -1 if data is inline */
+            DataType type;
+            int nComponents;
+        };
+
+        string m_fileName;
+        FILE *m_file;
+        vector<char> m_buffer;
+        size_t m_begin;          /* Read position within m_buffer */
+        size_t m_end;            /* End of valid data within m_buffer */
+        long long m_bufferOffset; /* File offset of m_buffer[0] */
+        bool m_eof;
+
+        int m_nPoints;
+        bool m_bigEndian;
+        bool m_header64;
+        char m_carry[3];         /* Decoded base64 bytes not yet consumed */
+        int m_carryBegin;
+        int m_carryEnd;
+        string m_error;
+        vector<ArrayRequest> m_requests;
+
+        bool Fill(size_t minBytes);
+        bool SkipTo(char c);
+        bool ReadTag(string *tag);
+        bool SkipPast(const char *pattern);
+        bool SeekTo(long long offset);
+        
+        static string Attribute(const string &tag, const char *name);
+        static DataType ParseType(const string &type);
+        static int TypeSize(DataType type);
+
+        ArrayRequest *FindRequest(const string &name);
+        bool ReadAsciiArray(ArrayRequest *r);
+        bool ReadBytes(char *dest, size_t n, bool base64);
+        bool ReadBinaryArray(ArrayRequest *r, bool base64);
+        void Store(ArrayRequest *r, size_t index, const char *bytes);
+        void Resize(ArrayRequest *r, size_t count);
+        void Store(ArrayRequest *r, size_t index, double value);
+    };
+}}
+#endif
@@ -41,6 +41,7 @@
 #include <Model.hh>
 #include <ScalarField.hh>
 #include <Timer.hh>
+#include <Checkpoint.hh>
 
 namespace src{ namespace model {
 
@@ -60,7 +61,6 @@ namespace src{ namespace model {
     :Process(m, c)
     {
         const SurfaceTopology *st = m_model->GetSurfaceTopology();
-        int len = st->GetNMeshPoints();
         /*-----------------------------------------------------------------------------
          * Read parameters
          *-----------------------------------------------------------------------------*/
@@ -68,20 +68,46 @@ namespace src{ namespace model {
         m_subaerialSedimentDiffusivity      = m_config->PDouble("subaerialSedimentDiffusivity");
         m_tolerance                         = m_config->PDouble("solverTolerance");
         m_maxIterations                     = m_config->PInt("maxIterations");
+        
+        /*-----------------------------------------------------------------------------
+         * Read optional parameters
+         *-----------------------------------------------------------------------------*/
+        string preconditioner               = m_config->PString("preconditioner", "diagonal");
+        bool reuseFactorization             = m_config->PBool("reuseFactorization", true);
+        bool matrixFree                     = m_config->PBool("matrixFree", false);
 
         /*-----------------------------------------------------------------------------
          * Instantiate diffusion solver
          *-----------------------------------------------------------------------------*/
         m_diffusion = new Diffusion(const_cast<SurfaceTopology*>(st), NULL, NULL, 
                                     m_model->GetNumTimeSteps(), m_model->GetDt(),
-                                    m_tolerance, m_maxIterations);    
+                                    m_tolerance, m_maxIterations, matrixFree);    
+        m_diffusion->SetFactorizationReuse(reuseFactorization);
+
+        if(preconditioner == "incompleteCholesky")
+            m_diffusion->SetPreconditioner(Diffusion::Preconditioner_IncompleteCholesky);
+        else if(preconditioner == "incompleteLUT")
+            m_diffusion->SetPreconditioner(Diffusion::Preconditioner_IncompleteLUT);
+        else if(preconditioner == "amg")
+            m_diffusion->SetPreconditioner(Diffusion::Preconditioner_AlgebraicMultigrid);
+        else if(preconditioner != "diagonal")
+        {
+            cerr << "Error: unknown preconditioner '" << preconditioner 
+                 << "'. Options are (diagonal/incompleteCholesky/incompleteLUT/amg).." << endl;
+            exit(EXIT_FAILURE);
+        }
+        
+        if(matrixFree && (preconditioner != "diagonal"))
+        {
+            cerr << "Warning: preconditioner '" << preconditioner << "' is not available "
+                 << "for matrix-free solves; using 'diagonal' instead.." << endl;
+        }
 
         /*-----------------------------------------------------------------------------
-         * Register empty scalar-field for output
+         * Register diffusivity for output
          *-----------------------------------------------------------------------------*/
-        ScalarField<float> *diffusivity = new ScalarField<float>("diffusivity", len);
         SurfaceTopologyOutput *sto = m_model->GetSurfaceTopologyOutput();
-        sto->RegisterScalarField(diffusivity);                
+        if(sto) sto->RegisterFieldProvider("diffusivity", this);
     }
     
     /*
@@ -114,7 +140,6 @@ namespace src{ namespace model {
         
         ScalarField<float> *sedimentHistory = static_cast< ScalarField<float>* > (m_model->GetField("sedimentHistory"));
 
-        ScalarField<float> *diffusivity = new ScalarField<float>("diffusivity", len);
         /*-----------------------------------------------------------------------------
          * Set IC, Coefficients and Dirichlet values for diffusion-solver
          *-----------------------------------------------------------------------------*/
@@ -142,12 +167,6 @@ namespace src{ namespace model {
                         coefficient[i] = m_subaerialSedimentDiffusivity;
                     else
                         coefficient[i] = m_bedrockDiffusivity;
-
-                    (*diffusivity)(i) = coefficient[i];
-                }
-                else
-                {
-                    (*diffusivity)(i) = m_bedrockDiffusivity;
                 }
             }
         }
@@ -177,12 +196,44 @@ namespace src{ namespace model {
         
         for(int i=0; i<len; i++) Z(i) = solution[i] - st->Z(i);
         st->UpdateZ(&Z);
+    }
 
-        /*-----------------------------------------------------------------------------
-         * Register empty scalar-field for output
-         *-----------------------------------------------------------------------------*/
-        SurfaceTopologyOutput *sto = m_model->GetSurfaceTopologyOutput();
-        sto->RegisterScalarField(diffusivity);        
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  HillSlope
+     *      Method:  HillSlope :: EvaluateOutputField
+     * Description:  Provides nodal diffusivities, as used in Execute, for output. 
+     *               Dirichlet nodes have zero diffusivity.
+     *--------------------------------------------------------------------------------------
+     */
+    void HillSlope::EvaluateOutputField(const string &, vector<float> &values)
+    {
+        const SurfaceTopology *st = m_model->GetSurfaceTopology();
+        int len = st->GetNMeshPoints();
+        ScalarField<float> *sedimentHistory = static_cast< ScalarField<float>* > (m_model->GetField("sedimentHistory"));
+
+        for(int i=0; i<len; i++)
+        {
+            if((int)(st->B(i)) == SurfaceTopology::DIRICHLET) 
+                values[i] = 0;
+            else if(sedimentHistory && (*sedimentHistory)(i)>0)
+                values[i] = m_subaerialSedimentDiffusivity;
+            else
+                values[i] = m_bedrockDiffusivity;
+        }
     }
-}}
 
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  HillSlope
+     *      Method:  HillSlope :: Serialize
+     * Description:  Saves/restores the time-step of the diffusion solver
+     *--------------------------------------------------------------------------------------
+     */
+    void HillSlope::Serialize(Checkpoint *cp)
+    {
+        int ts = m_diffusion->GetTimeStep();
+        cp->Value(ts);
+        m_diffusion->SetTimeStep(ts);
+    }
+}}
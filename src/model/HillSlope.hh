@@ -42,6 +42,7 @@
 #include <Process.hh>
 #include <Config.hh>
 #include <Diffusion.hh>
+#include <SurfaceTopologyOutput.hh>
 
 namespace src{ namespace model {
     class Model;
@@ -59,12 +60,14 @@ namespace src { namespace model {
      *  Description:  Implements fluvial erosion/sedimentation
      * =====================================================================================
      */
-    class HillSlope:public Process
+    class HillSlope:public Process, public SurfaceTopologyOutput::FieldProvider
     {
         public:
         HillSlope(const Model *m, Config *c);
         ~HillSlope();
         void Execute();
+        void Serialize(Checkpoint *cp);
+        void EvaluateOutputField(const string &name, vector<float> &values);
         
         static float DirichletFunction(int idx);
         static float CoefficientFunction(int idx);
@@ -47,6 +47,7 @@
 #include <Process.hh>
 #include <Config.hh>
 #include <Log.hh>
+#include <Checkpoint.hh>
 
 namespace src { namespace model {
     using namespace std;
@@ -323,5 +324,36 @@ namespace src { namespace model {
             delete *it;
         }
     }
-}}
 
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Model
+     *      Method:  Model :: Serialize
+     * Description:  Saves/restores model-time, fields and the state of each surface-process.
+     *               Fields and processes must have been created in the same order.
+     *--------------------------------------------------------------------------------------
+     */
+    void Model::Serialize(Checkpoint *cp)
+    {
+        cp->Section("MODL");
+        cp->Match(m_dt, "dt");
+        cp->Value(m_t);
+        cp->Value(m_ts);
+
+        cp->Match((int)m_fields.size(), "field-count");
+        for(map<string, Field*>::iterator it = m_fields.begin();
+            it != m_fields.end(); it++)
+        {
+            cp->Match(it->first, "field-name");
+            it->second->Serialize(cp);
+        }
+
+        cp->Match((int)m_processes.size(), "process-count");
+        for(vector<Process *>::iterator it = m_processes.begin();
+            it != m_processes.end(); it++)
+        {
+            cp->Section("PROC");
+            (*it)->Serialize(cp);
+        }
+    }
+}}
@@ -46,6 +46,7 @@
 namespace src{
 namespace util{
     class Field;
+    class Checkpoint;
 }}
 
 namespace src{
@@ -106,6 +107,7 @@ namespace src { namespace model {
         int   GetNumTimeSteps() const;
         bool  NextTimeStep();
         int   GetNParallelCores() const;
+        void  Serialize(Checkpoint *cp);
 
         private:
         Config *m_config;
@@ -43,6 +43,7 @@
 #include <FluvialErosionDeposition.hh>
 #include <Uplift.hh>
 #include <HillSlope.hh>
+#include <Checkpoint.hh>
 
 namespace src { namespace model {
     using namespace std;
@@ -56,15 +57,17 @@ namespace src { namespace model {
      *       Class:  ModelBuilder
      *      Method:  ModelBuilder :: ModelBuilder
      * Description:  Constructor builds a Model object and instantiates all available 
-     *               surface-processes.
+     *               surface-processes. If a checkpoint is given, the model-state is 
+     *               restored from it once all surface-processes have been created.
      *--------------------------------------------------------------------------------------
      */
-    ModelBuilder::ModelBuilder(Config *c)
-    :m_config(c)
+    ModelBuilder::ModelBuilder(Config *c, Checkpoint *restart)
+    :m_surfaceTopologyOutput(NULL),
+    m_config(c)
     {
         Config *meshConfig                  = m_config->Group("mesh");
         
-        m_surfaceTopology                   = new SurfaceTopology(meshConfig);
+        m_surfaceTopology                   = new SurfaceTopology(meshConfig, restart);
         m_model                             = new Model(m_surfaceTopology, m_config);
 
         /* Instantiate writer for outputing mesh and drainage network */
@@ -106,6 +109,32 @@ namespace src { namespace model {
             HillSlope *hs = new HillSlope(m_model, config);
             (void)hs;
         }   
+
+        if(restart)
+        {
+            m_model->Serialize(restart);
+            if(m_surfaceTopologyOutput) m_surfaceTopologyOutput->Serialize(restart);
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  ModelBuilder
+     *      Method:  ModelBuilder :: SaveCheckpoint
+     * Description:  Writes the full model-state to a checkpoint-file, from which a run can 
+     *               be restarted with the same configuration. Returns false if the 
+     *               file could not be written.
+     *--------------------------------------------------------------------------------------
+     */
+    bool ModelBuilder::SaveCheckpoint(string fileName, bool cacheTriangulation)
+    {
+        Checkpoint cp(fileName, Checkpoint::Checkpoint_Write);
+
+        m_surfaceTopology->Save(&cp, cacheTriangulation);
+        m_model->Serialize(&cp);
+        if(m_surfaceTopologyOutput) m_surfaceTopologyOutput->Serialize(&cp);
+
+        return cp.Close();
     }
 
     /*
@@ -117,6 +146,8 @@ namespace src { namespace model {
      */
     ModelBuilder::~ModelBuilder()
     {
+        /* Output is destroyed first, so that pending writes complete */
+        delete m_surfaceTopologyOutput;
         delete m_surfaceTopology;
         delete m_model;
     }
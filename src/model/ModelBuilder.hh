@@ -51,6 +51,11 @@ namespace mesh{
     class SurfaceTopologyOutput;
 }}
 
+namespace src{
+namespace util{
+    class Checkpoint;
+}}
+
 using namespace std;
 namespace src { namespace model {
 
@@ -65,9 +70,11 @@ using namespace src::parser;
 class ModelBuilder
 {
     public:
-    ModelBuilder(Config *c);
+    ModelBuilder(Config *c, Checkpoint *restart=NULL);
     ~ModelBuilder();
 
+    bool SaveCheckpoint(string fileName, bool cacheTriangulation);
+
     Model *GetModel()                       { return m_model; }
     SurfaceTopology *GetSurfaceTopology()   { return m_surfaceTopology; }
     SurfaceTopologyOutput *GetSurfaceTopologyOutput() { return m_surfaceTopologyOutput; }
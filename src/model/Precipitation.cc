@@ -40,6 +40,7 @@
 #include <ScalarField.hh>
 #include <Model.hh>
 #include <Timer.hh>
+#include <Checkpoint.hh>
 
 namespace src { namespace model {
     using namespace std;
@@ -92,21 +93,26 @@ namespace src { namespace model {
     {
         if(m_model->GetTimeStep() % m_frequency) return;
 
+        m_precipitationRate->GetCurrentField(&m_precipitationRateField);
+
+        switch(m_precipitationRateField.GetType())
+        {
+            case ForcingField::Forcing_Uniform:
+                ComputePrecipitation(m_precipitationRateField.GetUniformView());
+                break;
+            case ForcingField::Forcing_Piecewise:
+                ComputePrecipitation(m_precipitationRateField.GetPiecewiseView());
+                break;
+            case ForcingField::Forcing_PerNode:
+                ComputePrecipitation(m_precipitationRateField.GetPerNodeView());
+                break;
+        }
+
+#ifdef DEBUG
         const SurfaceTopology *st = m_model->GetSurfaceTopology();
-        const float *surfaceArea = st->GetVoronoiCellAreas();
-        const int *hull = st->GetHull();
-        float dt = m_model->GetDt();        
         ScalarField<float> *precipitation = static_cast< ScalarField<float>* > (m_model->GetField("precipitation"));
         int len = st->GetNMeshPoints();
-        float averageCellArea = st->GetAverageCellArea();
         
-        m_precipitationRate->GetCurrentFieldValue(&m_precipitationRateWorkArray);
-
-        for(int i=0; i<len; i++)
-            if(!hull[i]) (*precipitation)(i) = m_precipitationRateWorkArray[i] * surfaceArea[i] * dt;
-            else (*precipitation)(i) = m_precipitationRateWorkArray[i] * averageCellArea * dt;
-
-#ifdef DEBUG
         cout << endl << "Nodal Precipitation: " << endl;
         cout <<         "-------------------- " << endl;
         for(int i=0; i<len; i++)
@@ -115,5 +121,40 @@ namespace src { namespace model {
         }
 #endif
     }
-}}
 
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Precipitation
+     *      Method:  Precipitation :: ComputePrecipitation
+     * Description:  Computes nodal precipitation, given a view of the precipitation-rate
+     *               forcing-field
+     *--------------------------------------------------------------------------------------
+     */
+    template <class Rate>
+    void Precipitation::ComputePrecipitation(const Rate &rate)
+    {
+        const SurfaceTopology *st = m_model->GetSurfaceTopology();
+        const float *surfaceArea = st->GetVoronoiCellAreas();
+        const int *hull = st->GetHull();
+        float dt = m_model->GetDt();        
+        ScalarField<float> *precipitation = static_cast< ScalarField<float>* > (m_model->GetField("precipitation"));
+        int len = st->GetNMeshPoints();
+        float averageCellArea = st->GetAverageCellArea();
+
+        for(int i=0; i<len; i++)
+            if(!hull[i]) (*precipitation)(i) = rate[i] * surfaceArea[i] * dt;
+            else (*precipitation)(i) = rate[i] * averageCellArea * dt;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Precipitation
+     *      Method:  Precipitation :: Serialize
+     * Description:  Saves/restores the precipitation-rate time-series
+     *--------------------------------------------------------------------------------------
+     */
+    void Precipitation::Serialize(Checkpoint *cp)
+    {
+        m_precipitationRate->Serialize(cp);
+    }
+}}
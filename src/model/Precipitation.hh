@@ -60,10 +60,14 @@ namespace src { namespace model {
         Precipitation(const Model *m, Config *c);
         ~Precipitation();
         void Execute();
+        void Serialize(Checkpoint *cp);
 
         private:
         TimeSeries *m_precipitationRate;
-        vector<double> m_precipitationRateWorkArray;
+        ForcingField m_precipitationRateField;
+
+        template <class Rate>
+        void ComputePrecipitation(const Rate &rate);
     };
 }}
 
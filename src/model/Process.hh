@@ -41,9 +41,14 @@
 
 #include <Config.hh>
 
+namespace src { namespace util {
+    class Checkpoint;
+}}
+
 namespace src { namespace model {
     using namespace std;
     using namespace src::parser;
+    using src::util::Checkpoint;
     class Model;
  
     /*
@@ -58,6 +63,8 @@ namespace src { namespace model {
         Process(const Model *m, Config *c);
         virtual ~Process();
         virtual void Execute() = 0;
+        /* Saves/restores time-dependent state; stateless processes need not override */
+        virtual void Serialize(Checkpoint *) {}
 
         protected:
         int   m_frequency;
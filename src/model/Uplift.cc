@@ -46,6 +46,7 @@
 #include <Model.hh>
 #include <Timer.hh>
 #include <Log.hh>
+#include <Checkpoint.hh>
 
 namespace src { namespace model {
     using namespace std;
@@ -76,11 +77,10 @@ namespace src { namespace model {
         m_cumulativeUplift.resize(nn);
         
         /*-----------------------------------------------------------------------------
-         * Register empty scalar-field for output
+         * Register cumulative uplift for output
          *-----------------------------------------------------------------------------*/
         SurfaceTopologyOutput *sto = m_model->GetSurfaceTopologyOutput();
-        ScalarField<float> *u = new ScalarField<float> ("totalUplift", nn);
-        sto->RegisterScalarField(u);        
+        if(sto) sto->RegisterFieldProvider("totalUplift", this);
     }
 
     /*
@@ -107,30 +107,27 @@ namespace src { namespace model {
         if(m_model->GetTimeStep() % m_frequency) return;
 
         const SurfaceTopology *st = m_model->GetSurfaceTopology();
-        float dt = m_model->GetDt();
         ScalarField<float> *uplift = static_cast< ScalarField<float>* > (m_model->GetField("uplift"));
         int len = st->GetNMeshPoints();
         
-        m_upliftRate->GetCurrentFieldValue(&m_upliftRateWorkArray);
+        m_upliftRate->GetCurrentField(&m_upliftRateField);
 
-        for(int i=0; i<len; i++) 
+        switch(m_upliftRateField.GetType())
         {
-            if(!st->B(i)) (*uplift)(i) = m_upliftRateWorkArray[i] * dt;
-            else (*uplift)(i) = 0;
+            case ForcingField::Forcing_Uniform:
+                ComputeUplift(m_upliftRateField.GetUniformView());
+                break;
+            case ForcingField::Forcing_Piecewise:
+                ComputeUplift(m_upliftRateField.GetPiecewiseView());
+                break;
+            case ForcingField::Forcing_PerNode:
+                ComputeUplift(m_upliftRateField.GetPerNodeView());
+                break;
         }
 
         st->UpdateZ(uplift);
         for(int i=0; i<len; i++) m_cumulativeUplift[i] += (*uplift)(i);
 
-        /*-----------------------------------------------------------------------------
-         * Register scalar-field for output
-         *-----------------------------------------------------------------------------*/
-        SurfaceTopologyOutput *sto = m_model->GetSurfaceTopologyOutput();
-        ScalarField<float> *u = new ScalarField<float> ("totalUplift", len);
-           
-        for(int i=0; i<len; i++) (*u)(i) = m_cumulativeUplift[i];
-        sto->RegisterScalarField(u);              
-
 #ifdef DEBUG
         cout << endl << "Nodal Uplift: " << endl;
         cout <<         "--------------------- " << endl;
@@ -140,5 +137,51 @@ namespace src { namespace model {
         }
 #endif
     }
-}}
 
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Uplift
+     *      Method:  Uplift :: ComputeUplift
+     * Description:  Computes nodal uplift, given a view of the uplift-rate forcing-field
+     *--------------------------------------------------------------------------------------
+     */
+    template <class Rate>
+    void Uplift::ComputeUplift(const Rate &rate)
+    {
+        const SurfaceTopology *st = m_model->GetSurfaceTopology();
+        float dt = m_model->GetDt();
+        ScalarField<float> *uplift = static_cast< ScalarField<float>* > (m_model->GetField("uplift"));
+        int len = st->GetNMeshPoints();
+
+        for(int i=0; i<len; i++) 
+        {
+            if(!st->B(i)) (*uplift)(i) = rate[i] * dt;
+            else (*uplift)(i) = 0;
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Uplift
+     *      Method:  Uplift :: EvaluateOutputField
+     * Description:  Provides cumulative uplift for output
+     *--------------------------------------------------------------------------------------
+     */
+    void Uplift::EvaluateOutputField(const string &, vector<float> &values)
+    {
+        copy(m_cumulativeUplift.begin(), m_cumulativeUplift.end(), values.begin());
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Uplift
+     *      Method:  Uplift :: Serialize
+     * Description:  Saves/restores cumulative uplift and the uplift-rate time-series
+     *--------------------------------------------------------------------------------------
+     */
+    void Uplift::Serialize(Checkpoint *cp)
+    {
+        cp->Array(m_cumulativeUplift);
+        m_upliftRate->Serialize(cp);
+    }
+}}
@@ -42,6 +42,7 @@
 #include <Model.hh>
 #include <Config.hh>
 #include <TimeSeries.hh>
+#include <SurfaceTopologyOutput.hh>
 
 namespace src { namespace model {
     using namespace src::mesh;
@@ -54,17 +55,22 @@ namespace src { namespace model {
      *  Description:  Uniform uplift
      * =====================================================================================
      */
-    class Uplift:public Process
+    class Uplift:public Process, public SurfaceTopologyOutput::FieldProvider
     {
         public:
         Uplift(const Model *m, Config *c);
         ~Uplift();
         void Execute();
+        void Serialize(Checkpoint *cp);
+        void EvaluateOutputField(const string &name, vector<float> &values);
 
         private:
         TimeSeries *m_upliftRate;
-        vector<double> m_upliftRateWorkArray;
+        ForcingField m_upliftRateField;
         vector<float> m_cumulativeUplift;
+
+        template <class Rate>
+        void ComputeUplift(const Rate &rate);
     };
 }}
 
@@ -349,5 +349,68 @@ namespace src { namespace parser {
     
         return atoi(val.c_str());
     }
-}}
 
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Config
+     *      Method:  Config :: HasSymbol
+     * Description:  Returns true if a symbol is defined in this group
+     *--------------------------------------------------------------------------------------
+     */
+    bool Config::HasSymbol(string name)
+    {
+        return (m_symbols.find(name) != m_symbols.end());
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Config
+     *      Method:  Config :: PString
+     * Description:  Returns the string value of an optional symbol
+     *--------------------------------------------------------------------------------------
+     */
+    string Config::PString(string name, string defaultValue)
+    {
+        if(!HasSymbol(name)) return defaultValue;
+        return PString(name);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Config
+     *      Method:  Config :: PBool
+     * Description:  Returns boolean value of an optional symbol
+     *--------------------------------------------------------------------------------------
+     */
+    bool Config::PBool(string name, bool defaultValue)
+    {
+        if(!HasSymbol(name)) return defaultValue;
+        return PBool(name);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Config
+     *      Method:  Config :: PDouble
+     * Description:  Returns double value of an optional symbol
+     *--------------------------------------------------------------------------------------
+     */
+    double Config::PDouble(string name, double defaultValue)
+    {
+        if(!HasSymbol(name)) return defaultValue;
+        return PDouble(name);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Config
+     *      Method:  Config :: PInt
+     * Description:  Returns integer value of an optional symbol
+     *--------------------------------------------------------------------------------------
+     */
+    int Config::PInt(string name, int defaultValue)
+    {
+        if(!HasSymbol(name)) return defaultValue;
+        return PInt(name);
+    }
+}}
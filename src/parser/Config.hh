@@ -94,6 +94,15 @@ namespace src { namespace parser {
         // get int config entry; value is parsed using atoi()
         int PInt(string name);
 
+        /* Variants of the above for optional entries, which return 
+        * 'defaultValue' if the entry is missing.
+        */
+        bool HasSymbol(string name);
+        string PString(string name, string defaultValue);
+        bool PBool(string name, bool defaultValue);
+        double PDouble(string name, double defaultValue);
+        int PInt(string name, int defaultValue);
+
         // get the symbol map (e.g. for iterating over all symbols)
         inline map<string, string>& GetSymbols()
         {
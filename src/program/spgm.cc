@@ -42,6 +42,7 @@
 #include <iomanip>
 #include <exception>
 #include <stdexcept>
+#include <signal.h>
 
 #include <ModelBuilder.hh>
 #include <Model.hh>
@@ -54,6 +55,7 @@
 #include <Config.hh>
 #include <ScalarField.hh>
 #include <Diffusion.hh>
+#include <Checkpoint.hh>
 
 using namespace std;
 using src::geometry::Triangulator;
@@ -68,7 +70,26 @@ using src::parser::Config;
 using namespace src::util;
 using namespace src::math;
 
-const string usage = "Usage: ./spgm <config-file>\n";
+const string usage = "Usage: ./spgm <config-file> [--restart <checkpoint-file>]\n";
+
+/*-----------------------------------------------------------------------------
+ * Set by signal-handlers and polled after each time-step: SIGUSR1 requests a 
+ * checkpoint, SIGTERM a checkpoint followed by a clean exit.
+ *-----------------------------------------------------------------------------*/
+volatile sig_atomic_t checkpointRequested = 0;
+volatile sig_atomic_t terminateRequested = 0;
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  SignalHandler
+ *  Description:  Flags checkpoint/termination requests
+ * =====================================================================================
+ */
+void SignalHandler(int signal)
+{
+    if(signal == SIGTERM) terminateRequested = 1;
+    checkpointRequested = 1;
+}
 
 /* 
  * ===  FUNCTION  ======================================================================
@@ -183,7 +204,12 @@ int main(int argc, char **argv)
     /*-----------------------------------------------------------------------------
      * Parse parameter file
      *-----------------------------------------------------------------------------*/
-    if(argc != 2)
+    string restartFileName;
+    if(argc == 4 && string(argv[2]) == "--restart")
+    {
+        restartFileName = argv[3];
+    }
+    else if(argc != 2)
     {
         cout << usage;
         exit(EXIT_FAILURE);
@@ -191,15 +217,53 @@ int main(int argc, char **argv)
 
     Config *c = ReadParameters(string(argv[1]));
     
-    ModelBuilder mb(c);
+    /*-----------------------------------------------------------------------------
+     * Checkpoint parameters (optional)
+     *-----------------------------------------------------------------------------*/
+    Config *cc = c->Group("checkpoint");
+    string checkpointFileName;
+    int    checkpointFrequency = 0;
+    bool   cacheTriangulation = true;
+    if(cc)
+    {
+        string path = cc->PString("path", "./");
+        if(path[path.length()-1] != '/') path = path + "/";
+        
+        checkpointFileName  = path + cc->PString("prefix", "spgm") + ".chk";
+        checkpointFrequency = cc->PInt("frequency", 0);
+        cacheTriangulation  = cc->PBool("cacheTriangulation", true);
+        
+        signal(SIGTERM, SignalHandler);
+        signal(SIGUSR1, SignalHandler);
+    }
+
+    Checkpoint *restart = NULL;
+    if(restartFileName.length())
+    {
+        restart = new Checkpoint(restartFileName, Checkpoint::Checkpoint_Read);
+    }
+    
+    ModelBuilder mb(c, restart);
     Model *m = mb.GetModel();
     
+    if(restart)
+    {
+        printf("Restarting from %s at timestep: (%d), Time(%2.2f yr)\n", 
+                restartFileName.c_str(), m->GetTimeStep(), m->GetTime());
+        delete restart;
+    }
+    
     /*-----------------------------------------------------------------------------
      * Main time-loop
      *-----------------------------------------------------------------------------*/
     SurfaceTopology *st = mb.GetSurfaceTopology();
     
-    if(mb.GetSurfaceTopologyOutput()) mb.GetSurfaceTopologyOutput()->Write();
+    if(mb.GetSurfaceTopologyOutput()) 
+    {
+        /* Output for the restart time-step was written by the run that saved it */
+        if(restartFileName.length()) mb.GetSurfaceTopologyOutput()->DiscardScalarFields();
+        else mb.GetSurfaceTopologyOutput()->Write();
+    }
     
     while(m->NextTimeStep())
     {
@@ -216,8 +280,24 @@ int main(int argc, char **argv)
                 m->GetTimeStep(), m->GetTime());
         
         if(mb.GetSurfaceTopologyOutput()) mb.GetSurfaceTopologyOutput()->Write();
+        
+        if(checkpointFileName.length() && 
+           (checkpointRequested || 
+            (checkpointFrequency > 0 && (m->GetTimeStep() % checkpointFrequency) == 0)))
+        {
+            checkpointRequested = 0;
+            if(mb.SaveCheckpoint(checkpointFileName, cacheTriangulation))
+                printf("[Checkpoint written: %s]\n", checkpointFileName.c_str());
+            else
+                cerr << "Warning: checkpoint could not be written; continuing.." << endl;
+        }
+        
+        if(terminateRequested) break;
     }
     
+    /* Wait for pending output to be written */
+    if(mb.GetSurfaceTopologyOutput()) mb.GetSurfaceTopologyOutput()->Flush();
+    
     delete c;
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,213 @@
+/*
+ * =====================================================================================
+ * Scalable PaleoGeomorphology Model (SPGM)
+ *
+ * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * This program is free software; you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
+ * Place, Suite 330, Boston, MA 02111-1307 USA
+ * ===================================================================================== 
+ */
+/*
+ * =====================================================================================
+ *
+ *       Filename:  spgmdecode.cc
+ *
+ *    Description:  Converts vtk-binary files with lossy-compressed arrays back to plain\nvtk-binary files
+ *
+ *        Version:  1.0
+ *        Created:  18/10/26 13:10:00
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * =====================================================================================
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <LossyCodec.hh>
+#include <Timer.hh>
+
+using namespace std;
+using namespace src::util;
+
+const string usage = "Usage: ./spgmdecode <input-file> <output-file>\n";
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  GetAttribute
+ *  Description:  Returns the position of the value of attribute 'name' within tag 
+ *                [begin, end), or string::npos if the tag has no such attribute.
+ * =====================================================================================
+ */
+size_t GetAttribute(const string &header, size_t begin, size_t end, string name, string *value)
+{
+    string key = " " + name + "=\"";
+    size_t pos = header.find(key, begin);
+    if(pos == string::npos || pos >= end) return string::npos;
+
+    pos += key.length();
+    size_t close = header.find('"', pos);
+    *value = header.substr(pos, close-pos);
+    return pos;
+}
+
+/* 
+ * ===  FUNCTION  ======================================================================
+ *         Name:  main
+ *  Description:  Decodes all arrays tagged with compression="lossy" and rewrites the 
+ *                offsets of the AppendedData section accordingly.
+ * =====================================================================================
+ */
+int main(int argc, char **argv)
+{
+    if(argc != 3)
+    {
+        cout << usage;
+        exit(EXIT_FAILURE);
+    }
+
+    /*-----------------------------------------------------------------------------
+     * Read input file
+     *-----------------------------------------------------------------------------*/
+    ifstream ifs(argv[1], ios_base::in | ios_base::binary);
+    if(!ifs)
+    {
+        cerr << "Error: could not open " << argv[1] << endl;
+        exit(EXIT_FAILURE);
+    }
+    string contents((istreambuf_iterator<char>(ifs)), istreambuf_iterator<char>());
+    ifs.close();
+
+    const string appendedTag = "<AppendedData encoding=\"raw\">";
+    size_t appendedPos = contents.find(appendedTag);
+    if(appendedPos == string::npos || contents.find('_', appendedPos) == string::npos)
+    {
+        cerr << "Error: " << argv[1] << " is not a vtk-binary file" << endl;
+        exit(EXIT_FAILURE);
+    }
+    size_t dataBegin = contents.find('_', appendedPos) + 1;
+    string header = contents.substr(0, dataBegin);
+
+    /*-----------------------------------------------------------------------------
+     * Rewrite data-arrays in the order they appear, which matches the order of
+     * their data in the AppendedData section
+     *-----------------------------------------------------------------------------*/
+    string outHeader;
+    vector<char> outData;
+    size_t copied = 0;
+    size_t dataEnd = dataBegin;
+    double rawBytes = 0, encodedBytes = 0, decodeTime = 0;
+
+    for(size_t tag = header.find("<DataArray"); tag != string::npos && tag < appendedPos; 
+        tag = header.find("<DataArray", tag+1))
+    {
+        size_t tagEnd = header.find('>', tag);
+        string offsetValue, compression;
+        size_t offsetPos = GetAttribute(header, tag, tagEnd, "offset", &offsetValue);
+        if(offsetPos == string::npos) continue;
+
+        unsigned long long nbytes = 0;
+        size_t arrayBegin = dataBegin + strtoull(offsetValue.c_str(), NULL, 10);
+        if(arrayBegin + sizeof(nbytes) > contents.length())
+        {
+            cerr << "Error: truncated array in " << argv[1] << endl;
+            exit(EXIT_FAILURE);
+        }
+        memcpy(&nbytes, &contents[arrayBegin], sizeof(nbytes));
+        const char *payload = &contents[arrayBegin + sizeof(nbytes)];
+        if(arrayBegin + sizeof(nbytes) + nbytes > contents.length())
+        {
+            cerr << "Error: truncated array in " << argv[1] << endl;
+            exit(EXIT_FAILURE);
+        }
+        dataEnd = arrayBegin + sizeof(nbytes) + nbytes;
+
+        /* Copy header up to the offset-value and substitute the new offset */
+        ostringstream oss;
+        oss << outData.size();
+        outHeader += header.substr(copied, offsetPos - copied) + oss.str();
+        copied = offsetPos + offsetValue.length();
+
+        size_t compressionPos = GetAttribute(header, tag, tagEnd, "compression", &compression);
+        if(compressionPos != string::npos && compression == "lossy")
+        {
+            vector<float> values;
+            
+            Timer tDecodeBegin;
+            bool valid = LossyCodec::Decode(payload, nbytes, values);
+            Timer tDecodeEnd;
+            if(!valid)
+            {
+                cerr << "Error: malformed lossy-compressed array in " << argv[1] << endl;
+                exit(EXIT_FAILURE);
+            }
+            decodeTime += Timer::Elapsed(tDecodeBegin, tDecodeEnd);
+            encodedBytes += nbytes;
+            rawBytes += values.size()*sizeof(float);
+
+            unsigned long long nDecodedBytes = values.size()*sizeof(float);
+            outData.insert(outData.end(), (char*)&nDecodedBytes, (char*)&nDecodedBytes + sizeof(nDecodedBytes));
+            if(values.size()) outData.insert(outData.end(), (char*)&values[0], (char*)(&values[0] + values.size()));
+
+            /* Drop the compression-attribute */
+            size_t attrBegin = compressionPos - string(" compression=\"").length();
+            outHeader += header.substr(copied, attrBegin - copied);
+            copied = compressionPos + compression.length() + 1;
+        }
+        else
+        {
+            outData.insert(outData.end(), contents.begin() + arrayBegin, contents.begin() + dataEnd);
+        }
+    }
+    outHeader += header.substr(copied);
+
+    /* Drop the compressor-attribute from the root-element */
+    {
+        const string compressor = " compressor=\"spgmLossyCodec\"";
+        size_t pos = outHeader.find(compressor);
+        if(pos != string::npos) outHeader.erase(pos, compressor.length());
+    }
+
+    /*-----------------------------------------------------------------------------
+     * Write output file
+     *-----------------------------------------------------------------------------*/
+    ofstream ofs(argv[2], ios_base::out | ios_base::binary);
+    if(!ofs)
+    {
+        cerr << "Error: could not open " << argv[2] << endl;
+        exit(EXIT_FAILURE);
+    }
+    ofs.write(outHeader.data(), outHeader.length());
+    if(outData.size()) ofs.write(&outData[0], outData.size());
+    ofs.write(contents.data() + dataEnd, contents.length() - dataEnd);
+    ofs.close();
+
+    if(encodedBytes > 0)
+    {
+        printf("Decoded %s: ratio %.2f, %.1f MB/s\n", argv[1], rawBytes/encodedBytes, 
+               (decodeTime > 0) ? rawBytes/decodeTime/1e6 : 0.);
+    }
+    
+    return EXIT_SUCCESS;
+}
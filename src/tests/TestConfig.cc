@@ -55,6 +55,8 @@ extern "C" char *test_config()
     mu_assert("Failure: file-name mismatch", c.PString("fileName")=="src/tests/data/mmsMesh.txt");
     mu_assert("Failure: smoothing factor mismatch", c.PDouble("smoothing")==0);
     mu_assert("Failure: smoothing iterations mismatch", c.PInt("smoothingIterations")==500);
+    mu_assert("Failure: optional parameter ignored", c.PInt("smoothingIterations", 1)==500);
+    mu_assert("Failure: default value mismatch", c.PInt("missingParameter", 7)==7);
     
     cout << "Verified configuration parameters.." << endl;
     cout << "======================================" << endl << endl;
@@ -210,3 +210,228 @@ extern "C" char *test_l_diffusion()
     return 0;
 }
 
+
+extern "C" char *test_diffusion_preconditioners()
+{
+    cout << "===== Testing Diffusion Preconditioners =====" << endl;
+    int   nt = 3;
+    float dt = 0.001;
+
+    Config c("src/tests/data/mms.cfg");
+    SurfaceTopology st(&c);
+    
+    int len = st.GetNMeshPoints();    
+    int nelem = st.GetNumTriangles();
+    
+    Diffusion::Preconditioner preconditioners[4] = {Diffusion::Preconditioner_Diagonal,
+                                                    Diffusion::Preconditioner_IncompleteCholesky,
+                                                    Diffusion::Preconditioner_IncompleteLUT,
+                                                    Diffusion::Preconditioner_AlgebraicMultigrid};
+    for(int p=0; p<4; p++)
+    {
+        Diffusion diffusion(&st, source_k1, NULL, nt, dt, 1e-7, 200);
+        diffusion.SetPreconditioner(preconditioners[p]);
+        diffusion.SetFactorizationReuse(false);
+        
+        vector<float> z(len);
+        for(int i=0; i<len; i++) z[i] = st.Z(i);
+        diffusion.SetIC(&z);
+
+        float t = 0.;
+        vector<float> elemCoefficient(nelem, 1.);
+        for(int i=0; i<nt; i++)
+        {
+            t += dt;
+            
+            vector<float> d(len);
+            vector<float> numSol(len);        
+            for(int j=0; j<len; j++)
+            {
+                if(st.B(j)==SurfaceTopology::DIRICHLET) d[j] = u_exact(st.X(j), st.Y(j), t);
+                else d[j] = 0.;
+            }
+            diffusion.SetDirichlet(&d);
+            diffusion.SetCoefficient(&elemCoefficient);
+            diffusion.Step();
+            diffusion.GetSolution(&numSol);
+            
+            mu_assert("Failure: solver did not converge", diffusion.GetIterations() < 200);
+            for(int j=0; j<len; j++)
+            {
+                mu_assert("Failure: Absolute error > 1e-3", 
+                          fabs(numSol[j]-u_exact(st.X(j), st.Y(j), t)) < 1e-3);
+            }
+        }
+    }
+    cout << "Numerical solutions within tolerance (1e-3).." << endl;
+    cout << "======================================" << endl << endl;
+    return 0;
+}
+
+extern "C" char *test_diffusion_factorization_reuse()
+{
+    cout << "===== Testing Diffusion Factorization Reuse =====" << endl;
+    int   nt = 4;
+    float dt = 0.01;
+
+    Config c("src/tests/data/mms.cfg");
+    SurfaceTopology st(&c);
+    
+    int len = st.GetNMeshPoints();    
+    int nelem = st.GetNumTriangles();
+
+    /*-----------------------------------------------------------------------------
+     * Coefficients are changed after two steps; direct and iterative solutions 
+     * must agree throughout
+     *-----------------------------------------------------------------------------*/
+    Diffusion direct(&st, source_k1, NULL, nt, dt, 1e-7, 500);
+    Diffusion iterative(&st, source_k1, NULL, nt, dt, 1e-7, 500);
+    iterative.SetFactorizationReuse(false);
+    
+    vector<float> z(len);
+    for(int i=0; i<len; i++) z[i] = st.Z(i);
+    direct.SetIC(&z);
+    iterative.SetIC(&z);
+
+    vector<float> d(len, 0.);
+    direct.SetDirichlet(&d);
+    iterative.SetDirichlet(&d);
+
+    for(int i=0; i<nt; i++)
+    {
+        vector<float> elemCoefficient(nelem, (i < 2) ? 1. : 2.);
+        vector<float> directSol(len), iterativeSol(len);
+
+        direct.SetCoefficient(&elemCoefficient);
+        iterative.SetCoefficient(&elemCoefficient);
+        direct.Step();
+        iterative.Step();
+        direct.GetSolution(&directSol);
+        iterative.GetSolution(&iterativeSol);
+
+        if(i == 1 || i == 3) 
+            mu_assert("Failure: factorization not reused", direct.GetIterations() == 0);
+        
+        for(int j=0; j<len; j++)
+        {
+            mu_assert("Failure: direct and iterative solutions differ", 
+                      fabs(directSol[j]-iterativeSol[j]) < 1e-4);
+        }
+    }
+    cout << "Direct and iterative solutions agree.." << endl;
+    cout << "======================================" << endl << endl;
+    return 0;
+}
+
+extern "C" char *test_diffusion_matrix_free()
+{
+    cout << "===== Testing Matrix-free Diffusion =====" << endl;
+    int   nt = 3;
+    float dt = 0.01;
+
+    Config c("src/tests/data/mms.cfg");
+    SurfaceTopology st(&c);
+    
+    int len = st.GetNMeshPoints();    
+    int nelem = st.GetNumTriangles();
+
+    /*-----------------------------------------------------------------------------
+     * Spatially varying coefficients, changed every step, and nonzero Dirichlet
+     * values; assembled and matrix-free solutions must agree throughout
+     *-----------------------------------------------------------------------------*/
+    Diffusion assembled(&st, source_k1, NULL, nt, dt, 1e-7, 500);
+    Diffusion matrixFree(&st, source_k1, NULL, nt, dt, 1e-7, 500, true);
+    assembled.SetFactorizationReuse(false);
+    
+    vector<float> z(len);
+    for(int i=0; i<len; i++) z[i] = st.Z(i);
+    assembled.SetIC(&z);
+    matrixFree.SetIC(&z);
+
+    vector<float> d(len);
+    for(int i=0; i<len; i++) d[i] = 1 + st.X(i);
+    assembled.SetDirichlet(&d);
+    matrixFree.SetDirichlet(&d);
+
+    for(int i=0; i<nt; i++)
+    {
+        vector<float> elemCoefficient(nelem);
+        vector<float> assembledSol(len), matrixFreeSol(len);
+        for(int e=0; e<nelem; e++) elemCoefficient[e] = 1 + (e+i)%3;
+
+        assembled.SetCoefficient(&elemCoefficient);
+        matrixFree.SetCoefficient(&elemCoefficient);
+        assembled.Step();
+        matrixFree.Step();
+        assembled.GetSolution(&assembledSol);
+        matrixFree.GetSolution(&matrixFreeSol);
+
+        for(int j=0; j<len; j++)
+        {
+            mu_assert("Failure: assembled and matrix-free solutions differ", 
+                      fabs(assembledSol[j]-matrixFreeSol[j]) < 1e-4);
+        }
+    }
+    cout << "Assembled and matrix-free solutions agree.." << endl;
+    cout << "======================================" << endl << endl;
+    return 0;
+}
+
+extern "C" char *test_diffusion_multigrid()
+{
+    cout << "===== Testing Multigrid Preconditioner =====" << endl;
+    int   nt = 3;
+    float dt = 10;
+
+    Config c("src/tests/data/mms.cfg");
+    SurfaceTopology st(&c);
+    
+    int len = st.GetNMeshPoints();    
+    int nelem = st.GetNumTriangles();
+
+    /*-----------------------------------------------------------------------------
+     * A stiffness-dominated system, with coefficients changed every step: the 
+     * multigrid hierarchy is updated rather than rebuilt, and must still yield
+     * solutions matching those of the diagonally preconditioned solver in far
+     * fewer iterations
+     *-----------------------------------------------------------------------------*/
+    Diffusion diagonal(&st, NULL, NULL, nt, dt, 1e-6, 2000);
+    Diffusion multigrid(&st, NULL, NULL, nt, dt, 1e-6, 2000);
+    diagonal.SetFactorizationReuse(false);
+    multigrid.SetFactorizationReuse(false);
+    multigrid.SetPreconditioner(Diffusion::Preconditioner_AlgebraicMultigrid);
+    
+    vector<float> z(len, 0.);
+    diagonal.SetIC(&z);
+    multigrid.SetIC(&z);
+
+    vector<float> d(len);
+    for(int i=0; i<len; i++) d[i] = 1 + st.X(i) * st.Y(i);
+    diagonal.SetDirichlet(&d);
+    multigrid.SetDirichlet(&d);
+
+    for(int i=0; i<nt; i++)
+    {
+        vector<float> elemCoefficient(nelem);
+        vector<float> diagonalSol(len), multigridSol(len);
+        for(int e=0; e<nelem; e++) elemCoefficient[e] = 1 + (e+i)%3;
+
+        diagonal.SetCoefficient(&elemCoefficient);
+        multigrid.SetCoefficient(&elemCoefficient);
+        diagonal.Step();
+        multigrid.Step();
+        diagonal.GetSolution(&diagonalSol);
+        multigrid.GetSolution(&multigridSol);
+
+        mu_assert("Failure: multigrid did not reduce iterations", 
+                  multigrid.GetIterations() < diagonal.GetIterations() / 4);
+        for(int j=0; j<len; j++)
+        {
+            mu_assert("Failure: diagonal and multigrid solutions differ", 
+                      fabs(diagonalSol[j]-multigridSol[j]) < 1e-3);
+        }
+    }
+    cout << "Multigrid and diagonal solutions agree.." << endl;
+    cout << "======================================" << endl << endl;
+    return 0;
+}
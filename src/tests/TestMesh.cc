@@ -41,11 +41,21 @@
 #include <Config.hh>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include <SurfaceTopology.hh>
+#include <SurfaceTopologyOutput.hh>
+#include <Model.hh>
+#include <VTUReader.hh>
+#include <DrainageNetwork.hh>
+#include <RegularMesh.hh>
+#include <KdTree.hh>
+#include <algorithm>
+#include <Checkpoint.hh>
 #include <minunit.h>
 
 using namespace src::parser;
 using namespace src::mesh;
+using namespace src::util;
 using namespace std;
 
 extern "C" char *test_mesh()
@@ -83,3 +93,616 @@ extern "C" char *test_surface_topology()
     return 0;
 }
 
+
+extern "C" char *test_vtu_reader()
+{
+    cout << "===== Testing VTU Reader =====" << endl;
+
+    /*-----------------------------------------------------------------------------
+     * Number parsing
+     *-----------------------------------------------------------------------------*/
+    {
+        const char *numbers[] = {"0", "-12", "3.25", "1e-3", "-6.0884e+05", "1234567.125", "2E2"};
+        double expected[] = {0, -12, 3.25, 1e-3, -6.0884e+05, 1234567.125, 200};
+
+        for(int i=0; i<7; i++)
+        {
+            double v = 0;
+            const char *end = numbers[i] + strlen(numbers[i]);
+            
+            mu_assert("Failure: number not parsed", VTUReader::ParseNumber(numbers[i], end, &v) == end);
+            mu_assert("Failure: number parsed incorrectly", v == expected[i]);
+        }
+    }
+
+    /*-----------------------------------------------------------------------------
+     * The same 3-point piece in ascii, inline-binary and appended-raw encodings, 
+     * the latter also followed by a second piece, which is ignored
+     *-----------------------------------------------------------------------------*/
+    float points[9] = {0, 0, 1.5, 1, 0, 2.5, 0, 1, 3.5};
+    float bc[3] = {1, 0, 2};
+    const char *fileName = "/tmp/spgm_test_reader.vtu";
+    const char *header = "<?xml version=\"1.0\"?>\n"
+                         "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\" byte_order=\"LittleEndian\">\n"
+                         "<UnstructuredGrid>\n<Piece NumberOfPoints=\"3\" NumberOfCells=\"1\">\n";
+    
+    for(int encoding=0; encoding<4; encoding++)
+    {
+        FILE *f = fopen(fileName, "wb");
+        fprintf(f, "%s<PointData>\n", header);
+        if(encoding==0)
+        {
+            fprintf(f, "<DataArray type=\"Float32\" Name=\"bc\" format=\"ascii\">\n1 0 2\n</DataArray>\n");
+            fprintf(f, "</PointData>\n<Points>\n<DataArray type=\"Float32\" NumberOfComponents=\"3\" format=\"ascii\">\n");
+            fprintf(f, "0 0 1.5 1 0 2.5\n0 1 3.5\n</DataArray>\n</Points>\n</Piece>\n</UnstructuredGrid>\n</VTKFile>\n");
+        }
+        else if(encoding==1)
+        {
+            /* bc as Int32 {1, 0, 2} and points as Float64, base64-encoded */
+            fprintf(f, "<DataArray type=\"Int32\" Name=\"bc\" format=\"binary\">\n");
+            fprintf(f, "DAAAAAEAAAAAAAAAAgAAAA==\n</DataArray>\n</PointData>\n<Points>\n");
+            fprintf(f, "<DataArray type=\"Float64\" NumberOfComponents=\"3\" format=\"binary\">\n");
+            fprintf(f, "SAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAD4PwAAAAAAAPA/AAAAAAAAAAAAAAAAAAAEQAAAAAAAAAAAAAAAAAAA8D8AAAAAAAAMQA==\n");
+            fprintf(f, "</DataArray>\n</Points>\n</Piece>\n</UnstructuredGrid>\n</VTKFile>\n");
+        }
+        else
+        {
+            unsigned int nb = 3*sizeof(float), np = 9*sizeof(float);
+            fprintf(f, "<DataArray type=\"Float32\" Name=\"bc\" format=\"appended\" offset=\"0\"/>\n");
+            fprintf(f, "</PointData>\n<Points>\n<DataArray type=\"Float32\" NumberOfComponents=\"3\" format=\"appended\" offset=\"16\"/>\n");
+            fprintf(f, "</Points>\n</Piece>\n");
+            if(encoding==3)
+            {
+                fprintf(f, "<Piece NumberOfPoints=\"1\" NumberOfCells=\"0\">\n<PointData>\n");
+                fprintf(f, "<DataArray type=\"Float32\" Name=\"bc\" format=\"appended\" offset=\"56\"/>\n");
+                fprintf(f, "</PointData>\n<Points>\n<DataArray type=\"Float32\" NumberOfComponents=\"3\" format=\"appended\" offset=\"64\"/>\n");
+                fprintf(f, "</Points>\n</Piece>\n");
+            }
+            fprintf(f, "</UnstructuredGrid>\n<AppendedData encoding=\"raw\">\n_");
+            fwrite(&nb, 4, 1, f); fwrite(bc, 4, 3, f);
+            fwrite(&np, 4, 1, f); fwrite(points, 4, 9, f);
+            if(encoding==3)
+            {
+                unsigned int nb1 = sizeof(float), np1 = 3*sizeof(float);
+                float bc1 = 7, points1[3] = {5, 5, 5};
+                fwrite(&nb1, 4, 1, f); fwrite(&bc1, 4, 1, f);
+                fwrite(&np1, 4, 1, f); fwrite(points1, 4, 3, f);
+            }
+            fprintf(f, "\n</AppendedData>\n</VTKFile>\n");
+        }
+        fclose(f);
+
+        vector<float> p, b, t;
+        VTUReader reader(fileName);
+        reader.Request("Points", &p);
+        reader.Request("bc", &b);
+        reader.Request("t", &t, true);
+
+        mu_assert("Failure: vtu file could not be read", reader.Read());
+        mu_assert("Failure: missing optional array reported as found", !reader.Found("t") && t.empty());
+        mu_assert("Failure: number of points mismatch", reader.GetNumberOfPoints() == 3);
+        for(int i=0; i<9; i++) mu_assert("Failure: points mismatch", p[i] == points[i]);
+        for(int i=0; i<3; i++) mu_assert("Failure: bc mismatch", b[i] == bc[i]);
+    }
+    /* A missing array that is not optional fails the read */
+    {
+        vector<float> t;
+        VTUReader reader(fileName);
+        reader.Request("t", &t);
+        mu_assert("Failure: missing array not reported", !reader.Read());
+    }
+    remove(fileName);
+
+    cout << "Verified ascii, binary and appended encodings, and multi-piece files.." << endl;
+    cout << "======================================" << endl << endl;
+    return 0;
+}
+
+extern "C" char *test_drainage_network()
+{
+    cout << "===== Testing Drainage Network =====" << endl;
+
+    /*-----------------------------------------------------------------------------
+     * Network with outlet 0:  4,5 -> 2 -> 1 -> 0;  6 -> 3 -> 1
+     *-----------------------------------------------------------------------------*/
+    int receivers[]    = {0, 0, 1, 1, 2, 2, 3};
+    int donorOffsets[] = {0, 1, 3, 5, 6, 6, 6, 6};
+    int donors[]       = {1, 2, 3, 4, 5, 6};
+    float areas[]      = {1, 1, 1, 1, 1, 1, 1};
+
+    DrainageNetwork dn;
+    dn.Extract(7, receivers, donorOffsets, donors, areas, 0);
+
+    mu_assert("Failure: accumulated area mismatch", dn.GetDrainageAreas()[0] == 7 && 
+                                                     dn.GetDrainageAreas()[1] == 6 &&
+                                                     dn.GetDrainageAreas()[2] == 3);
+    mu_assert("Failure: Strahler order mismatch", dn.GetStrahlerOrders()[0] == 2 && 
+                                                   dn.GetStrahlerOrders()[2] == 2 &&
+                                                   dn.GetStrahlerOrders()[3] == 1);
+    mu_assert("Failure: segment count mismatch", dn.GetNumSegments() == 5);
+    
+    /* Every channel edge is emitted exactly once */
+    mu_assert("Failure: segment nodes mismatch", dn.GetSegmentNodes().size() == 6 + 5);
+
+    /* Segment 6 -> 3 -> 1 passes through node 3 */
+    {
+        int last = dn.GetNumSegments()-1;
+        int end = dn.GetSegmentOffsets()[last];
+        mu_assert("Failure: segment mismatch", end - dn.GetSegmentOffsets()[last-1] == 3 &&
+                                               dn.GetSegmentNodes()[end-1] == 1 &&
+                                               dn.GetSegmentOrders()[last] == 1 &&
+                                               dn.GetSegmentAreas()[last] == 2);
+    }
+
+    /* Thresholding removes first-order tributaries */
+    dn.Extract(7, receivers, donorOffsets, donors, areas, 2);
+    mu_assert("Failure: thresholded segment count mismatch", dn.GetNumSegments() == 3);
+    mu_assert("Failure: thresholded Strahler order mismatch", dn.GetStrahlerOrders()[0] == 2 && 
+                                                               dn.GetStrahlerOrders()[2] == 1 &&
+                                                               dn.GetStrahlerOrders()[4] == 0);
+    
+    cout << "Verified drainage network extraction.." << endl;
+    cout << "======================================" << endl << endl;
+    return 0;
+}
+
+extern "C" char *test_kd_tree()
+{
+    cout << "===== Testing Kd-Tree =====" << endl;
+
+    /*-----------------------------------------------------------------------------
+     * Random points, with duplicates, checked against brute-force search
+     *-----------------------------------------------------------------------------*/
+    const int n = 5000, k = 8, maxResults = 256;
+    vector<float> storage(2*n);
+    vector<float*> coords(n);
+    srand(7);
+    for(int i=0; i<n; i++)
+    {
+        coords[i] = &storage[2*i];
+        coords[i][0] = (i%10 == 0 && i) ? coords[i-1][0] : 1000.f*rand()/RAND_MAX;
+        coords[i][1] = (i%10 == 0 && i) ? coords[i-1][1] : 500.f*rand()/RAND_MAX;
+    }
+
+    KdTree kt(n, &coords[0]);
+    mu_assert("Failure: kd-tree size mismatch", kt.Size() == n);
+
+    const int nq = 64;
+    vector<float> pos(2*nq);
+    for(int q=0; q<nq; q++)
+    {
+        pos[2*q]   = 1100.f*rand()/RAND_MAX - 50;
+        pos[2*q+1] = 600.f*rand()/RAND_MAX - 50;
+    }
+
+    vector<int> counts(nq), ids(nq*maxResults), nearestIds(nq*k);
+    vector<float> distances(nq*maxResults), nearestDistances(nq*k);
+    kt.QueryRadius(nq, &pos[0], 40, maxResults, &counts[0], &ids[0], &distances[0]);
+    kt.QueryNearest(nq, &pos[0], k, &nearestIds[0], &nearestDistances[0]);
+
+    for(int q=0; q<nq; q++)
+    {
+        vector< pair<float, int> > all(n);
+        for(int i=0; i<n; i++)
+        {
+            float dx = coords[i][0] - pos[2*q], dy = coords[i][1] - pos[2*q+1];
+            all[i] = make_pair(sqrt(dx*dx + dy*dy), i);
+        }
+        sort(all.begin(), all.end());
+
+        int inside = 0;
+        while(inside < n && all[inside].first < 40) inside++;
+        mu_assert("Failure: radius-query count mismatch", counts[q] == inside);
+        
+        vector<int> found(ids.begin() + q*maxResults, ids.begin() + q*maxResults + min(inside, maxResults));
+        sort(found.begin(), found.end());
+        mu_assert("Failure: radius-query ids mismatch", 
+                  unique(found.begin(), found.end()) == found.end() && int(found.size()) == min(inside, maxResults));
+        
+        for(int j=0; j<k; j++)
+        {
+            mu_assert("Failure: nearest-neighbour distance mismatch", 
+                      fabs(nearestDistances[q*k+j] - all[j].first) < 1e-3);
+        }
+    }
+
+    vector<float> d;
+    vector<int> id;
+    kt.QueryBallPoint(&pos[0], 40, &d, &id);
+    mu_assert("Failure: ball-query count mismatch", int(id.size()) == counts[0]);
+    
+    cout << "Verified kd-tree queries.." << endl;
+    cout << "======================================" << endl << endl;
+    return 0;
+}
+
+extern "C" char *test_regular_mesh()
+{
+    cout << "===== Testing Regular Mesh Interpolation =====" << endl;
+
+    /*-----------------------------------------------------------------------------
+     * Non-square grid with a linear function; both stencils reproduce it exactly 
+     * within the interior
+     *-----------------------------------------------------------------------------*/
+    float lower[2] = {100, 200};
+    float upper[2] = {140, 230};
+    RegularMesh rm(5, 4, upper, lower);
+    
+    for(int i=0; i<5; i++)
+        for(int j=0; j<4; j++)
+            rm.V(i,j) = 2*(lower[0] + i*10) - 3*(lower[1] + j*10) + 1;
+
+    float points[3][2] = {{100, 200}, {117.5, 213}, {125, 215}};
+    float *coor[3] = {points[0], points[1], points[2]};
+    vector<double> result;
+
+    rm.BuildInterpolationWeights(3, coor, RegularMesh::Interpolation_Bilinear);
+    rm.ApplyInterpolationWeights(&result);
+    for(int k=0; k<3; k++)
+    {
+        double expected = 2*points[k][0] - 3*points[k][1] + 1;
+        mu_assert("Failure: bilinear interpolation incorrect", fabs(result[k]-expected) < 1e-9);
+    }
+
+    rm.BuildInterpolationWeights(3, coor, RegularMesh::Interpolation_Bicubic);
+    rm.ApplyInterpolationWeights(&result);
+    for(int k=1; k<3; k++)
+    {
+        double expected = 2*points[k][0] - 3*points[k][1] + 1;
+        mu_assert("Failure: bicubic interpolation incorrect", fabs(result[k]-expected) < 1e-9);
+    }
+
+    /*-----------------------------------------------------------------------------
+     * The spline interpolant (grid-relative coordinates) passes through grid-values
+     * and is linear for linear data; point-wise and batched evaluation agree
+     *-----------------------------------------------------------------------------*/
+    rm.UpdateInterpolator();
+    mu_assert("Failure: spline does not interpolate grid-values", 
+              fabs(rm.GetFunctionValueAt(20, 10) - rm.V(2,1)) < 1e-9);
+    mu_assert("Failure: spline not linear for linear data", 
+              fabs(rm.GetFunctionValueAt(17.5, 13) - (rm.V(0,0) + 2*17.5 - 3*13)) < 1e-9);
+
+    float xs[2] = {3.25, 38}, ys[2] = {29, 0.5}, values[2];
+    rm.GetFunctionValuesAt(2, xs, ys, values);
+    for(int k=0; k<2; k++)
+    {
+        mu_assert("Failure: batched spline evaluation incorrect", 
+                  fabs(values[k] - rm.GetFunctionValueAt(xs[k], ys[k])) < 1e-4);
+    }
+    
+    cout << "Verified regular mesh interpolation.." << endl;
+    cout << "======================================" << endl << endl;
+    return 0;
+}
+
+extern "C" char *test_grid_interpolation()
+{
+    cout << "===== Testing Mesh-to-Grid Interpolation =====" << endl;
+
+    Config c("src/tests/data/mms.cfg");
+    SurfaceTopology st(&c);
+
+    /*-----------------------------------------------------------------------------
+     * Barycentric interpolation reproduces a linear field at grid-nodes within the
+     * triangulation, before and after the weights are cached
+     *-----------------------------------------------------------------------------*/
+    int nn = st.GetNMeshPoints();
+    float lower[2] = {st.X(0), st.Y(0)}, upper[2] = {st.X(0), st.Y(0)};
+    for(int i=0; i<nn; i++)
+    {
+        lower[0] = min(lower[0], st.X(i)); upper[0] = max(upper[0], st.X(i));
+        lower[1] = min(lower[1], st.Y(i)); upper[1] = max(upper[1], st.Y(i));
+    }
+
+    RegularMesh rm(33, 21, upper, lower);
+    vector<float> field(nn);
+    for(int pass=0; pass<2; pass++)
+    {
+        for(int i=0; i<nn; i++) field[i] = 2*st.X(i) - 3*st.Y(i) + pass;
+        
+        st.InterpolateToRegularmesh(&rm, field, SurfaceTopology::GridInterpolation_Barycentric);
+        for(int i=1; i<32; i++)
+        {
+            for(int j=1; j<20; j++)
+            {
+                double expected = 2*rm.GridX(i) - 3*rm.GridY(j) + pass;
+                mu_assert("Failure: barycentric interpolation incorrect", 
+                          fabs(rm.V(i,j) - expected) < 1e-3*fabs(upper[0]-lower[0]));
+            }
+        }
+    }
+
+    /* Inverse-distance weighting stays within the range of nodal values */
+    st.InterpolateToRegularmesh(&rm, field);
+    float fMin = *min_element(field.begin(), field.end());
+    float fMax = *max_element(field.begin(), field.end());
+    for(int i=0; i<33; i++)
+        for(int j=0; j<21; j++)
+            mu_assert("Failure: inverse-distance interpolation out of range", 
+                      rm.V(i,j) >= fMin - 1e-3 && rm.V(i,j) <= fMax + 1e-3);
+    
+    cout << "Verified mesh-to-grid interpolation.." << endl;
+    cout << "======================================" << endl << endl;
+    return 0;
+}
+
+/*
+ * ===  FUNCTION  ======================================================================
+ *         Name:  WriteRectangularMesh
+ *  Description:  Writes a text-mesh of (nx+1) x (ny+1) nodes, 0.5 apart, with the 
+ *                elevation z = x + 2y and Dirichlet BCs along the boundary
+ * =====================================================================================
+ */
+static void WriteRectangularMesh(const char *fileName, int nx, int ny)
+{
+    FILE *f = fopen(fileName, "w");
+    fprintf(f, "%d\n", (nx+1)*(ny+1));
+    for(int j=0; j<=ny; j++)
+    {
+        for(int i=0; i<=nx; i++)
+        {
+            float x = 0.5*i, y = 0.5*j;
+            int bc = (i==0 || i==nx || j==0 || j==ny);
+            fprintf(f, "%f %f %f %d\n", x, y, x + 2*y, bc);
+        }
+    }
+    fclose(f);
+}
+
+extern "C" char *test_vtu_writer()
+{
+    cout << "===== Testing VTU Writer =====" << endl;
+
+    const char *meshFileName = "/tmp/spgm_test_writer_mesh.txt";
+    const char *configFileName = "/tmp/spgm_test_writer.cfg";
+    const char *vtuFileName = "/tmp/spgm_test_writer.mesh.0.vtu";
+    {
+        WriteRectangularMesh(meshFileName, 6, 3);
+
+        FILE *f = fopen(configFileName, "w");
+        fprintf(f, "dt = 1\nmaxTime = 1\nbeginTime = 0\nparallelCores = 1\n");
+        fprintf(f, "mesh = [\nfileName = \"%s\"\nsmoothing = 0\nsmoothingFactor = 0.05\n", meshFileName);
+        fprintf(f, "smoothingIterations = 500\n]\n");
+        fprintf(f, "output = [\nprefix = \"spgm_test_writer\"\npath = \"/tmp\"\noutputFormat = \"vtk-binary\"\n");
+        fprintf(f, "frequency = 1\nwriteMesh = 1\nwriteDrainage = 0\n]\n");
+        fclose(f);
+    }
+
+    Config c(configFileName);
+    SurfaceTopology st(c.Group("mesh"));
+    {
+        Model m(&st, &c);
+        SurfaceTopologyOutput sto(&m, c.Group("output"));
+        sto.Write();
+    }
+
+    /*-----------------------------------------------------------------------------
+     * The declared byte-order is that of the host, and appended arrays read back 
+     * unchanged
+     *-----------------------------------------------------------------------------*/
+    {
+        char header[256] = {0};
+        FILE *f = fopen(vtuFileName, "rb");
+        mu_assert("Failure: vtu file not written", f);
+        mu_assert("Failure: vtu header not read", fread(header, 1, sizeof(header)-1, f) > 0);
+        fclose(f);
+
+        const unsigned int one = 1;
+        bool bigEndian = (*((const unsigned char*)&one) == 0);
+        mu_assert("Failure: byte-order not that of the host", 
+                  strstr(header, bigEndian ? "byte_order=\"BigEndian\"" : "byte_order=\"LittleEndian\""));
+    }
+
+    vector<float> p, h, bc, id;
+    VTUReader reader(vtuFileName);
+    reader.Request("Points", &p);
+    reader.Request("h", &h);
+    reader.Request("bc", &bc);
+    reader.Request("id", &id);
+    mu_assert("Failure: vtu file could not be read", reader.Read());
+
+    int np = st.GetNMeshPoints();
+    mu_assert("Failure: number of points mismatch", reader.GetNumberOfPoints() == np);
+    for(int i=0; i<np; i++)
+    {
+        int j = (int)id[i];
+        mu_assert("Failure: id out of range", j >= 0 && j < np);
+        mu_assert("Failure: points mismatch", p[3*i] == st.X(j) && p[3*i+1] == st.Y(j));
+        mu_assert("Failure: h mismatch", h[i] == st.Z(j));
+        mu_assert("Failure: bc mismatch", bc[i] == st.B(j));
+    }
+
+    remove(meshFileName);
+    remove(configFileName);
+    remove(vtuFileName);
+
+    cout << "Verified binary vtu round-trip.." << endl;
+    cout << "======================================" << endl << endl;
+    return 0;
+}
+
+extern "C" char *test_raster_output()
+{
+    cout << "===== Testing Raster Output =====" << endl;
+
+    /*-----------------------------------------------------------------------------
+     * A 2 x 4 rectangular mesh, taller than it is wide, with a linear elevation, 
+     * rasterized over its own extent and over a grid extending one unit beyond 
+     * its western edge
+     *-----------------------------------------------------------------------------*/
+    const char *meshFileName = "/tmp/spgm_test_raster_mesh.txt";
+    const char *configFileName = "/tmp/spgm_test_raster.cfg";
+    {
+        WriteRectangularMesh(meshFileName, 4, 8);
+
+        FILE *f = fopen(configFileName, "w");
+        fprintf(f, "dt = 1\nmaxTime = 1\nbeginTime = 0\nparallelCores = 1\n");
+        fprintf(f, "mesh = [\nfileName = \"%s\"\nsmoothing = 0\nsmoothingFactor = 0.05\n", meshFileName);
+        fprintf(f, "smoothingIterations = 500\n]\n");
+        fprintf(f, "output = [\nprefix = \"spgm_test\"\npath = \"/tmp\"\noutputFormat = \"vtk\"\n");
+        fprintf(f, "frequency = 1\nwriteMesh = 0\nwriteDrainage = 0\n");
+        fprintf(f, "full = [\ntype = \"raster\"\nresolution = 0.5\nformat = \"raw\"\nfrequency = 1\n]\n");
+        fprintf(f, "wide = [\ntype = \"raster\"\nresolution = 0.5\nboundingBox = \"-1 0 2 4\"\nfrequency = 1\n]\n]\n");
+        fclose(f);
+    }
+
+    Config c(configFileName);
+    SurfaceTopology st(c.Group("mesh"));
+
+    vector<float> upper, lower;
+    st.GetBounds(upper, lower);
+    mu_assert("Failure: mesh bounds incorrect", lower[0] == 0 && lower[1] == 0 && upper[0] == 2 && upper[1] == 4);
+
+    {
+        Model m(&st, &c);
+        SurfaceTopologyOutput sto(&m, c.Group("output"));
+        sto.Write();
+    }
+
+    /* The default grid spans the mesh: 5 columns and 9 rows, northernmost row first */
+    {
+        vector<float> values(5*9+1);
+        FILE *f = fopen("/tmp/spgm_test.full.z.0.raw", "rb");
+        mu_assert("Failure: raster not written", f);
+        int n = fread(&values[0], sizeof(float), values.size(), f);
+        fclose(f);
+        
+        mu_assert("Failure: raster size incorrect", n == 5*9);
+        for(int r=0; r<9; r++)
+            for(int i=0; i<5; i++)
+                mu_assert("Failure: raster values incorrect", 
+                          fabs(values[r*5+i] - (0.5*i + 2*0.5*(8-r))) < 1e-4);
+    }
+
+    /* Cells west of the mesh are NODATA */
+    {
+        vector<float> values(7*9);
+        FILE *f = fopen("/tmp/spgm_test.wide.z.0.flt", "rb");
+        mu_assert("Failure: raster not written", f);
+        int n = fread(&values[0], sizeof(float), values.size(), f);
+        fclose(f);
+
+        mu_assert("Failure: raster size incorrect", n == 7*9);
+        for(int r=0; r<9; r++)
+        {
+            for(int i=0; i<7; i++)
+            {
+                float expected = (i < 2) ? -9999 : (0.5*(i-2) + 2*0.5*(8-r));
+                mu_assert("Failure: raster values incorrect", fabs(values[r*7+i] - expected) < 1e-4);
+            }
+        }
+
+        int ncols = 0, nrows = 0;
+        f = fopen("/tmp/spgm_test.wide.z.0.hdr", "r");
+        mu_assert("Failure: raster header not written", f);
+        n = fscanf(f, " ncols %d nrows %d", &ncols, &nrows);
+        fclose(f);
+        mu_assert("Failure: raster header incorrect", n == 2 && ncols == 7 && nrows == 9);
+    }
+
+    remove(meshFileName);
+    remove(configFileName);
+    remove("/tmp/spgm_test.full.z.0.raw");
+    remove("/tmp/spgm_test.wide.z.0.flt");
+    remove("/tmp/spgm_test.wide.z.0.hdr");
+
+    cout << "Verified raster output.." << endl;
+    cout << "======================================" << endl << endl;
+    return 0;
+}
+
+extern "C" char *test_point_location()
+{
+    cout << "===== Testing Point Location =====" << endl;
+
+    Config c("src/tests/data/mms.cfg");
+    SurfaceTopology st(&c);
+    const unsigned int **triangles = st.GetTriangleIndices();
+    long int nTriangles = st.GetNumTriangles();
+
+    /*-----------------------------------------------------------------------------
+     * Centroids are located within their own triangle, with and without a hint, 
+     * and the barycentric weights reproduce the query point
+     *-----------------------------------------------------------------------------*/
+    long int hint = -1;
+    for(long int t=0; t<nTriangles; t++)
+    {
+        const unsigned int *v = triangles[t];
+        float x = (st.X(v[0]) + st.X(v[1]) + st.X(v[2])) / 3.;
+        float y = (st.Y(v[0]) + st.Y(v[1]) + st.Y(v[2])) / 3.;
+        double w[3];
+
+        mu_assert("Failure: point not located without hint", st.LocatePoint(x, y) == t);
+        
+        hint = st.LocatePoint(x, y, hint, w);
+        mu_assert("Failure: point not located with hint", hint == t);
+
+        double px = w[0]*st.X(v[0]) + w[1]*st.X(v[1]) + w[2]*st.X(v[2]);
+        double py = w[0]*st.Y(v[0]) + w[1]*st.Y(v[1]) + w[2]*st.Y(v[2]);
+        mu_assert("Failure: barycentric weights incorrect", fabs(px-x) < 1e-3 && fabs(py-y) < 1e-3);
+    }
+
+    /* Points outside the triangulation */
+    float lower[2] = {st.X(0), st.Y(0)}, upper[2] = {st.X(0), st.Y(0)};
+    for(unsigned int i=0; i<st.GetNMeshPoints(); i++)
+    {
+        lower[0] = min(lower[0], st.X(i)); upper[0] = max(upper[0], st.X(i));
+        lower[1] = min(lower[1], st.Y(i)); upper[1] = max(upper[1], st.Y(i));
+    }
+    mu_assert("Failure: exterior point located", st.LocatePoint(2*upper[0]-lower[0], upper[1], 0) == -1);
+    mu_assert("Failure: exterior point located", st.LocatePoint(lower[0], 2*lower[1]-upper[1]) == -1);
+    
+    cout << "Verified point location.." << endl;
+    cout << "======================================" << endl << endl;
+    return 0;
+}
+
+extern "C" char *test_checkpoint()
+{
+    cout << "===== Testing Checkpoint =====" << endl;
+
+    Config c("src/tests/data/mms.cfg");
+    const char *fileName = "src/tests/data/test.chk";
+    
+    SurfaceTopology st(&c);
+    {
+        Checkpoint cp(fileName, Checkpoint::Checkpoint_Write);
+        st.Save(&cp, true);
+        mu_assert("Failure: checkpoint not written", cp.Close());
+    }
+    
+    /* A checkpoint that cannot be written is reported, without ending the run */
+    {
+        Checkpoint cp("/tmp/spgm_missing_directory/test.chk", Checkpoint::Checkpoint_Write);
+        st.Save(&cp, true);
+        mu_assert("Failure: checkpoint write-failure not reported", !cp.Close());
+    }
+    
+    Checkpoint cp(fileName, Checkpoint::Checkpoint_Read);
+    SurfaceTopology rst(&c, &cp);
+    remove(fileName);
+    
+    mu_assert("Failure: Number of points mismatch", rst.GetNMeshPoints() == st.GetNMeshPoints());
+    mu_assert("Failure: Number of triangles mismatch", rst.GetNumTriangles() == st.GetNumTriangles());
+    mu_assert("Failure: Number of Voronoi vertices mismatch", 
+              rst.GetNumVoronoiVertices() == st.GetNumVoronoiVertices());
+    
+    int len = st.GetNMeshPoints();
+    for(int i=0; i<len; i++)
+    {
+        mu_assert("Failure: geometry mismatch", rst.Z(i) == st.Z(i) && rst.B(i) == st.B(i) &&
+                                                rst.O(i) == st.O(i));
+        mu_assert("Failure: network mismatch", rst.R(i) == st.R(i) && rst.C(i) == st.C(i));
+        mu_assert("Failure: cell-area mismatch", rst.GetVoronoiCellAreas()[i] == st.GetVoronoiCellAreas()[i]);
+    }
+    for(int i=0; i<st.GetNumTriangles(); i++)
+    {
+        for(int j=0; j<3; j++)
+            mu_assert("Failure: triangle mismatch", 
+                      rst.GetTriangleIndices()[i][j] == st.GetTriangleIndices()[i][j]);
+    }
+    
+    cout << "Verified checkpoint round-trip.." << endl;
+    cout << "======================================" << endl << endl;
+    return 0;
+}
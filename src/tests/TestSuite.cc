@@ -47,8 +47,24 @@ extern "C" char *test_mem_dynamic();
 extern "C" char *test_config();
 extern "C" char *test_mesh();
 extern "C" char *test_surface_topology();
+extern "C" char *test_vtu_reader();
+extern "C" char *test_vtu_writer();
+extern "C" char *test_drainage_network();
+extern "C" char *test_kd_tree();
+extern "C" char *test_regular_mesh();
+extern "C" char *test_grid_interpolation();
+extern "C" char *test_raster_output();
+extern "C" char *test_point_location();
+extern "C" char *test_checkpoint();
+extern "C" char *test_lossy_codec();
+extern "C" char *test_ascii_formatter();
+extern "C" char *test_forcing_field();
 extern "C" char *test_nl_diffusion();
 extern "C" char *test_l_diffusion();
+extern "C" char *test_diffusion_preconditioners();
+extern "C" char *test_diffusion_factorization_reuse();
+extern "C" char *test_diffusion_matrix_free();
+extern "C" char *test_diffusion_multigrid();
 
 static char * all_tests() {
     mu_run_test(test_config);
@@ -57,8 +73,24 @@ static char * all_tests() {
 
     mu_run_test(test_mesh);
     mu_run_test(test_surface_topology);
+    mu_run_test(test_vtu_reader);
+    mu_run_test(test_vtu_writer);
+    mu_run_test(test_drainage_network);
+    mu_run_test(test_kd_tree);
+    mu_run_test(test_regular_mesh);
+    mu_run_test(test_grid_interpolation);
+    mu_run_test(test_raster_output);
+    mu_run_test(test_point_location);
+    mu_run_test(test_checkpoint);
+    mu_run_test(test_lossy_codec);
+    mu_run_test(test_ascii_formatter);
+    mu_run_test(test_forcing_field);
     mu_run_test(test_l_diffusion);
     mu_run_test(test_nl_diffusion);
+    mu_run_test(test_diffusion_preconditioners);
+    mu_run_test(test_diffusion_factorization_reuse);
+    mu_run_test(test_diffusion_matrix_free);
+    mu_run_test(test_diffusion_multigrid);
     return 0;
 }
 
@@ -0,0 +1,160 @@
+/*
+ * =====================================================================================
+ * Scalable PaleoGeomorphology Model (SPGM)
+ *
+ * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * This program is free software; you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
+ * Place, Suite 330, Boston, MA 02111-1307 USA
+ * ===================================================================================== 
+ */
+/*
+ * =====================================================================================
+ *
+ *       Filename:  TestUtil.cc
+ *
+ *    Description:  Tests for utility classes.
+ *
+ *        Version:  1.0
+ *        Created:  18/10/26 13:40:12
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Rakib Hassan (rakib.hassan@ga.gov.au)
+ *        Company:  
+ *
+ * =====================================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <LossyCodec.hh>
+#include <AsciiFormatter.hh>
+#include <ForcingField.hh>
+#include <minunit.h>
+
+using namespace src::util;
+using namespace std;
+
+extern "C" char *test_lossy_codec()
+{
+    cout << "===== Testing Lossy Codec =====" << endl;
+
+    /*-----------------------------------------------------------------------------
+     * Smooth field with a spike, values beyond float-precision at the bound and a 
+     * non-finite value, spanning several blocks
+     *-----------------------------------------------------------------------------*/
+    const int n = 1000;
+    const double errorBound = 1e-3;
+    vector<float> values(n);
+    for(int i=0; i<n; i++) values[i] = 100*sin(i*0.01) + 1e-4*i;
+    values[300] = 5e2;
+    values[600] = 3e7;
+    values[700] = NAN;
+
+    vector<char> encoded;
+    LossyCodec::Encode(&values[0], n, errorBound, encoded);
+    
+    vector<float> decoded;
+    mu_assert("Failure: decoding failed", LossyCodec::Decode(&encoded[0], encoded.size(), decoded));
+    mu_assert("Failure: length mismatch", (int)decoded.size() == n);
+    
+    for(int i=0; i<n; i++)
+    {
+        if(i == 700) mu_assert("Failure: non-finite value not preserved", isnan(decoded[i]));
+        else mu_assert("Failure: error-bound exceeded", fabs(decoded[i] - values[i]) <= errorBound);
+    }
+    mu_assert("Failure: no compression", encoded.size() < n*sizeof(float)*3/4);
+
+    /* Truncated input is rejected */
+    mu_assert("Failure: truncated input accepted", 
+              !LossyCodec::Decode(&encoded[0], encoded.size()/2, decoded));
+
+    cout << "Verified lossy codec.." << endl;
+    cout << "======================================" << endl << endl;
+    return 0;
+}
+
+extern "C" char *test_ascii_formatter()
+{
+    cout << "===== Testing Ascii Formatter =====" << endl;
+
+    /*-----------------------------------------------------------------------------
+     * Layout follows %g; digits are the shortest that read back exactly
+     *-----------------------------------------------------------------------------*/
+    float values[]          = {0.f, -0.f, 0.1f, -182.248f, 40000.f, 123456789.f, 1.5e-5f, 3.4e38f};
+    const char *expected[]  = {"0", "-0", "0.1", "-182.248", "40000", "123456790", "1.5e-05", "3.4e+38"};
+    char buffer[AsciiFormatter::MAX_LENGTH+1];
+    
+    for(int i=0; i<8; i++)
+    {
+        buffer[AsciiFormatter::Format(buffer, values[i])] = 0;
+        mu_assert("Failure: float formatted incorrectly", string(buffer) == expected[i]);
+    }
+
+    for(unsigned int bits=1; bits<0x7f800000; bits+=0x3fff)
+    {
+        float v, r;
+        memcpy(&v, &bits, sizeof(v));
+        buffer[AsciiFormatter::Format(buffer, v)] = 0;
+        r = strtof(buffer, NULL);
+        mu_assert("Failure: float does not round-trip", memcmp(&v, &r, sizeof(v)) == 0);
+    }
+
+    buffer[AsciiFormatter::Format(buffer, -1234567890123LL)] = 0;
+    mu_assert("Failure: integer formatted incorrectly", string(buffer) == "-1234567890123");
+
+    cout << "Verified ascii formatter.." << endl;
+    cout << "======================================" << endl << endl;
+    return 0;
+}
+
+extern "C" char *test_forcing_field()
+{
+    cout << "===== Testing Forcing Field =====" << endl;
+
+    ForcingField ff;
+    vector<double> expanded;
+    
+    ff.SetUniform(2.5);
+    mu_assert("Failure: forcing-field not uniform", ff.GetType() == ForcingField::Forcing_Uniform);
+    mu_assert("Failure: uniform view incorrect", ff.GetUniformView()[7] == 2.5);
+    ff.Expand(4, &expanded);
+    mu_assert("Failure: uniform field expanded incorrectly", (expanded.size() == 4) && (expanded[3] == 2.5));
+
+    int ids[] = {1, 0, 2, 1};
+    vector<int> regionIds(ids, ids+4);
+    vector<double> &regionValues = ff.SetPiecewise(&regionIds);
+    regionValues.resize(3);
+    regionValues[0] = 10; regionValues[1] = 20; regionValues[2] = 30;
+    
+    ForcingField::PiecewiseView pv = ff.GetPiecewiseView();
+    mu_assert("Failure: piecewise view incorrect", (pv[0] == 20) && (pv[1] == 10) && (pv[2] == 30));
+    ff.Expand(4, &expanded);
+    mu_assert("Failure: piecewise field expanded incorrectly", (expanded[3] == 20) && (ff[2] == 30));
+
+    vector<double> &nodeValues = ff.SetPerNode(4);
+    for(int i=0; i<4; i++) nodeValues[i] = i*i;
+    mu_assert("Failure: per-node view incorrect", ff.GetPerNodeView()[3] == 9);
+    mu_assert("Failure: per-node field incorrect", ff[2] == 4);
+
+    cout << "Verified forcing field.." << endl;
+    cout << "======================================" << endl << endl;
+    return 0;
+}
@@ -0,0 +1,375 @@
+/*
+ * =====================================================================================
+ * Scalable PaleoGeomorphology Model (SPGM)
+ *
+ * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * This program is free software; you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
+ * Place, Suite 330, Boston, MA 02111-1307 USA
+ * ===================================================================================== 
+ */
+/*
+ * =====================================================================================
+ *
+ *       Filename:  AsciiFormatter.cc
+ *
+ *    Description:  Fast conversion of numbers to text
+ *
+ *        Version:  1.0
+ *        Created:  18/10/26 14:20:00
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * =====================================================================================
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include <AsciiFormatter.hh>
+
+namespace src { namespace util {
+
+    /*-----------------------------------------------------------------------------
+     * Constants and tables for Ryu's float-to-shortest conversion. POW5_SPLIT[i] 
+     * holds the top 61 bits of 5^i, POW5_INV_SPLIT[i] the top 59 bits of 5^-i, 
+     * rounded up.
+     *-----------------------------------------------------------------------------*/
+    static const int FLOAT_MANTISSA_BITS        = 23;
+    static const int FLOAT_BIAS                 = 127;
+    static const int FLOAT_POW5_INV_BITCOUNT    = 59;
+    static const int FLOAT_POW5_BITCOUNT        = 61;
+
+    static const unsigned long long POW5_INV_SPLIT[31] = {
+        576460752303423489ULL, 461168601842738791ULL, 368934881474191033ULL,
+        295147905179352826ULL, 472236648286964522ULL, 377789318629571618ULL,
+        302231454903657294ULL, 483570327845851670ULL, 386856262276681336ULL,
+        309485009821345069ULL, 495176015714152110ULL, 396140812571321688ULL,
+        316912650057057351ULL, 507060240091291761ULL, 405648192073033409ULL,
+        324518553658426727ULL, 519229685853482763ULL, 415383748682786211ULL,
+        332306998946228969ULL, 531691198313966350ULL, 425352958651173080ULL,
+        340282366920938464ULL, 544451787073501542ULL, 435561429658801234ULL,
+        348449143727040987ULL, 557518629963265579ULL, 446014903970612463ULL,
+        356811923176489971ULL, 570899077082383953ULL, 456719261665907162ULL,
+        365375409332725730ULL,
+    };
+
+    static const unsigned long long POW5_SPLIT[48] = {
+        1152921504606846976ULL, 1441151880758558720ULL, 1801439850948198400ULL,
+        2251799813685248000ULL, 1407374883553280000ULL, 1759218604441600000ULL,
+        2199023255552000000ULL, 1374389534720000000ULL, 1717986918400000000ULL,
+        2147483648000000000ULL, 1342177280000000000ULL, 1677721600000000000ULL,
+        2097152000000000000ULL, 1310720000000000000ULL, 1638400000000000000ULL,
+        2048000000000000000ULL, 1280000000000000000ULL, 1600000000000000000ULL,
+        2000000000000000000ULL, 1250000000000000000ULL, 1562500000000000000ULL,
+        1953125000000000000ULL, 1220703125000000000ULL, 1525878906250000000ULL,
+        1907348632812500000ULL, 1192092895507812500ULL, 1490116119384765625ULL,
+        1862645149230957031ULL, 1164153218269348144ULL, 1455191522836685180ULL,
+        1818989403545856475ULL, 2273736754432320594ULL, 1421085471520200371ULL,
+        1776356839400250464ULL, 2220446049250313080ULL, 1387778780781445675ULL,
+        1734723475976807094ULL, 2168404344971008868ULL, 1355252715606880542ULL,
+        1694065894508600678ULL, 2117582368135750847ULL, 1323488980084844279ULL,
+        1654361225106055349ULL, 2067951531382569187ULL, 1292469707114105741ULL,
+        1615587133892632177ULL, 2019483917365790221ULL, 1262177448353618888ULL,
+    };
+
+    static inline int Pow5Bits(int e) { return (int)(((unsigned int)e * 1217359) >> 19) + 1; }
+    static inline unsigned int Log10Pow2(int e) { return ((unsigned int)e * 78913) >> 18; }
+    static inline unsigned int Log10Pow5(int e) { return ((unsigned int)e * 732923) >> 20; }
+
+    static inline bool MultipleOfPowerOf5(unsigned int value, unsigned int p)
+    {
+        unsigned int count = 0;
+        while(value % 5 == 0) { value /= 5; count++; }
+        return count >= p;
+    }
+
+    static inline bool MultipleOfPowerOf2(unsigned int value, unsigned int p)
+    {
+        return (value & ((1u << p) - 1)) == 0;
+    }
+
+    static inline unsigned int MulShift(unsigned int m, unsigned long long factor, int shift)
+    {
+        unsigned long long bits0 = (unsigned long long)m * (unsigned int)(factor);
+        unsigned long long bits1 = (unsigned long long)m * (unsigned int)(factor >> 32);
+        unsigned long long sum = (bits0 >> 32) + bits1;
+        return (unsigned int)(sum >> (shift - 32));
+    }
+
+    static inline int DecimalLength(unsigned int v)
+    {
+        int length = 1;
+        while(v >= 10) { v /= 10; length++; }
+        return length;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  AsciiFormatter
+     *      Method:  AsciiFormatter :: ShortestDecimal
+     * Description:  Computes the shortest decimal digits*10^exponent that rounds to the 
+     *               given finite, non-zero float, preferring the closest such value.
+     *--------------------------------------------------------------------------------------
+     */
+    void AsciiFormatter::ShortestDecimal(unsigned int ieeeMantissa, unsigned int ieeeExponent, 
+                                         unsigned int *digits, int *exponent)
+    {
+        int e2;
+        unsigned int m2;
+        if(ieeeExponent == 0)
+        {
+            e2 = 1 - FLOAT_BIAS - FLOAT_MANTISSA_BITS - 2;
+            m2 = ieeeMantissa;
+        }
+        else
+        {
+            e2 = (int)ieeeExponent - FLOAT_BIAS - FLOAT_MANTISSA_BITS - 2;
+            m2 = (1u << FLOAT_MANTISSA_BITS) | ieeeMantissa;
+        }
+        bool acceptBounds = (m2 & 1) == 0;
+
+        /*-----------------------------------------------------------------------------
+         * Step 2: bounds of the rounding interval, scaled by 4
+         *-----------------------------------------------------------------------------*/
+        unsigned int mv = 4 * m2;
+        unsigned int mp = 4 * m2 + 2;
+        unsigned int mmShift = (ieeeMantissa != 0 || ieeeExponent <= 1);
+        unsigned int mm = 4 * m2 - 1 - mmShift;
+
+        /*-----------------------------------------------------------------------------
+         * Step 3: convert to a decimal power base
+         *-----------------------------------------------------------------------------*/
+        unsigned int vr, vp, vm;
+        int e10;
+        bool vmIsTrailingZeros = false;
+        bool vrIsTrailingZeros = false;
+        unsigned int lastRemovedDigit = 0;
+        if(e2 >= 0)
+        {
+            unsigned int q = Log10Pow2(e2);
+            e10 = (int)q;
+            int k = FLOAT_POW5_INV_BITCOUNT + Pow5Bits((int)q) - 1;
+            int i = -e2 + (int)q + k;
+            vr = MulShift(mv, POW5_INV_SPLIT[q], i);
+            vp = MulShift(mp, POW5_INV_SPLIT[q], i);
+            vm = MulShift(mm, POW5_INV_SPLIT[q], i);
+            if(q != 0 && (vp - 1) / 10 <= vm / 10)
+            {
+                int l = FLOAT_POW5_INV_BITCOUNT + Pow5Bits((int)(q - 1)) - 1;
+                lastRemovedDigit = MulShift(mv, POW5_INV_SPLIT[q - 1], -e2 + (int)q - 1 + l) % 10;
+            }
+            if(q <= 9)
+            {
+                if(mv % 5 == 0)         vrIsTrailingZeros = MultipleOfPowerOf5(mv, q);
+                else if(acceptBounds)   vmIsTrailingZeros = MultipleOfPowerOf5(mm, q);
+                else                    vp -= MultipleOfPowerOf5(mp, q);
+            }
+        }
+        else
+        {
+            unsigned int q = Log10Pow5(-e2);
+            e10 = (int)q + e2;
+            int i = -e2 - (int)q;
+            int k = Pow5Bits(i) - FLOAT_POW5_BITCOUNT;
+            int j = (int)q - k;
+            vr = MulShift(mv, POW5_SPLIT[i], j);
+            vp = MulShift(mp, POW5_SPLIT[i], j);
+            vm = MulShift(mm, POW5_SPLIT[i], j);
+            if(q != 0 && (vp - 1) / 10 <= vm / 10)
+            {
+                j = (int)q - 1 - (Pow5Bits(i + 1) - FLOAT_POW5_BITCOUNT);
+                lastRemovedDigit = MulShift(mv, POW5_SPLIT[i + 1], j) % 10;
+            }
+            if(q <= 1)
+            {
+                vrIsTrailingZeros = true;
+                if(acceptBounds) vmIsTrailingZeros = (mmShift == 1);
+                else vp--;
+            }
+            else if(q < 31)
+            {
+                vrIsTrailingZeros = MultipleOfPowerOf2(mv, q - 1);
+            }
+        }
+
+        /*-----------------------------------------------------------------------------
+         * Step 4: find the shortest decimal representation within the interval
+         *-----------------------------------------------------------------------------*/
+        int removed = 0;
+        unsigned int output;
+        if(vmIsTrailingZeros || vrIsTrailingZeros)
+        {
+            while(vp / 10 > vm / 10)
+            {
+                vmIsTrailingZeros &= (vm % 10 == 0);
+                vrIsTrailingZeros &= (lastRemovedDigit == 0);
+                lastRemovedDigit = vr % 10;
+                vr /= 10; vp /= 10; vm /= 10;
+                removed++;
+            }
+            if(vmIsTrailingZeros)
+            {
+                while(vm % 10 == 0)
+                {
+                    vrIsTrailingZeros &= (lastRemovedDigit == 0);
+                    lastRemovedDigit = vr % 10;
+                    vr /= 10; vp /= 10; vm /= 10;
+                    removed++;
+                }
+            }
+            /* Round even if the exact value is .....50..0 */
+            if(vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0) lastRemovedDigit = 4;
+            
+            output = vr + ((vr == vm && (!acceptBounds || !vmIsTrailingZeros)) || lastRemovedDigit >= 5);
+        }
+        else
+        {
+            while(vp / 10 > vm / 10)
+            {
+                lastRemovedDigit = vr % 10;
+                vr /= 10; vp /= 10; vm /= 10;
+                removed++;
+            }
+            output = vr + (vr == vm || lastRemovedDigit >= 5);
+        }
+
+        *digits = output;
+        *exponent = e10 + removed;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  AsciiFormatter
+     *      Method:  AsciiFormatter :: Format
+     * Description:  Writes the shortest round-trip representation of a float. As with %g,
+     *               scientific notation is used for decimal exponents below -4 or at 
+     *               least 9, the number of significant digits of a float.
+     *--------------------------------------------------------------------------------------
+     */
+    int AsciiFormatter::Format(char *dest, float v)
+    {
+        unsigned int bits;
+        memcpy(&bits, &v, sizeof(bits));
+        
+        bool sign = (bits >> 31) != 0;
+        unsigned int ieeeExponent = (bits >> FLOAT_MANTISSA_BITS) & 0xff;
+        unsigned int ieeeMantissa = bits & ((1u << FLOAT_MANTISSA_BITS) - 1);
+
+        char *p = dest;
+        if(sign) *p++ = '-';
+
+        if(ieeeExponent == 0xff)
+        {
+            memcpy(p, ieeeMantissa ? "nan" : "inf", 3);
+            return (int)(p - dest) + 3;
+        }
+        if(ieeeExponent == 0 && ieeeMantissa == 0)
+        {
+            *p++ = '0';
+            return (int)(p - dest);
+        }
+
+        unsigned int output;
+        int exponent;
+        ShortestDecimal(ieeeMantissa, ieeeExponent, &output, &exponent);
+
+        /* Digits, most significant first */
+        char d[10];
+        int length = DecimalLength(output);
+        for(int i=length-1; i>=0; i--) { d[i] = '0' + output % 10; output /= 10; }
+
+        int x = exponent + length - 1;  /* Exponent of the leading digit */
+        if(x < -4 || x >= 9)
+        {
+            *p++ = d[0];
+            if(length > 1)
+            {
+                *p++ = '.';
+                memcpy(p, d+1, length-1);
+                p += length-1;
+            }
+            *p++ = 'e';
+            *p++ = (x < 0) ? '-' : '+';
+            int ax = (x < 0) ? -x : x;
+            if(ax >= 100) *p++ = '0' + ax / 100;
+            *p++ = '0' + (ax / 10) % 10;
+            *p++ = '0' + ax % 10;
+        }
+        else if(x < 0)
+        {
+            *p++ = '0';
+            *p++ = '.';
+            for(int i=0; i<-x-1; i++) *p++ = '0';
+            memcpy(p, d, length);
+            p += length;
+        }
+        else if(length <= x+1)
+        {
+            memcpy(p, d, length);
+            p += length;
+            for(int i=length; i<x+1; i++) *p++ = '0';
+        }
+        else
+        {
+            memcpy(p, d, x+1);
+            p += x+1;
+            *p++ = '.';
+            memcpy(p, d+x+1, length-x-1);
+            p += length-x-1;
+        }
+        return (int)(p - dest);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  AsciiFormatter
+     *      Method:  AsciiFormatter :: Format
+     * Description:  Writes a double with 17 significant digits, which round-trips
+     *--------------------------------------------------------------------------------------
+     */
+    int AsciiFormatter::Format(char *dest, double v)
+    {
+        char buffer[MAX_LENGTH+1];
+        int length = snprintf(buffer, sizeof(buffer), "%.17g", v);
+        memcpy(dest, buffer, length);
+        return length;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  AsciiFormatter
+     *      Method:  AsciiFormatter :: Format
+     * Description:  Writes an integer
+     *--------------------------------------------------------------------------------------
+     */
+    int AsciiFormatter::Format(char *dest, long long v)
+    {
+        char *p = dest;
+        unsigned long long u = (unsigned long long)v;
+        if(v < 0)
+        {
+            *p++ = '-';
+            u = 0 - u;
+        }
+
+        char d[20];
+        int length = 0;
+        do { d[length++] = '0' + u % 10; u /= 10; } while(u);
+        while(length) *p++ = d[--length];
+
+        return (int)(p - dest);
+    }
+}}
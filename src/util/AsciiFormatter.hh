@@ -0,0 +1,71 @@
+/*
+ * =====================================================================================
+ * Scalable PaleoGeomorphology Model (SPGM)
+ *
+ * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * This program is free software; you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
+ * Place, Suite 330, Boston, MA 02111-1307 USA
+ * ===================================================================================== 
+ */
+/*
+ * =====================================================================================
+ *
+ *       Filename:  AsciiFormatter.hh
+ *
+ *    Description:  Fast conversion of numbers to text
+ *
+ *        Version:  1.0
+ *        Created:  18/10/26 14:20:00
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * =====================================================================================
+ */
+#ifndef SRC_UTIL_ASCII_FORMATTER_HH
+#define SRC_UTIL_ASCII_FORMATTER_HH
+
+namespace src { namespace util {
+
+    /*
+     * =====================================================================================
+     *        Class:  AsciiFormatter
+     *  Description:  Converts numbers to text without going through iostreams. Floats are
+     *                written with the fewest digits that convert back to the same float 
+     *                (Ryu, Adams 2018), in the layout of printf's %g. Each function writes
+     *                at most MAX_LENGTH characters, without a terminating null, and 
+     *                returns the number of characters written.
+     * =====================================================================================
+     */
+    class AsciiFormatter
+    {
+        public:
+        static const int MAX_LENGTH = 32;
+
+        static int Format(char *dest, float v);
+        static int Format(char *dest, double v);
+        static int Format(char *dest, long long v);
+        static int Format(char *dest, long v)           { return Format(dest, (long long)v); }
+        static int Format(char *dest, int v)            { return Format(dest, (long long)v); }
+        static int Format(char *dest, unsigned int v)   { return Format(dest, (long long)v); }
+        static int Format(char *dest, unsigned char v)  { return Format(dest, (long long)v); }
+
+        private:
+        static void ShortestDecimal(unsigned int ieeeMantissa, unsigned int ieeeExponent, 
+                                    unsigned int *digits, int *exponent);
+    };
+}}
+#endif
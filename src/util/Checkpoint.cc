@@ -0,0 +1,232 @@
+/*
+ * =====================================================================================
+ * Scalable PaleoGeomorphology Model (SPGM)
+ *
+ * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * This program is free software; you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
+ * Place, Suite 330, Boston, MA 02111-1307 USA
+ * ===================================================================================== 
+ */
+/*
+ * =====================================================================================
+ *
+ *       Filename:  Checkpoint.cc
+ *
+ *    Description:  Binary checkpoint-file used to save and restore the full model-state
+ *
+ *        Version:  1.0
+ *        Created:  18/10/26 14:12:40
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * =====================================================================================
+ */
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <Checkpoint.hh>
+#include <Log.hh>
+
+namespace src { namespace util {
+    using namespace std;
+    using namespace src::parser;
+
+    static const char MAGIC[8] = {'S', 'P', 'G', 'M', 'C', 'K', 'P', 'T'};
+    static const int VERSION = 1;
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Checkpoint
+     *      Method:  Checkpoint :: Checkpoint
+     * Description:  Opens a checkpoint-file and writes or validates its header. A file 
+     *               that cannot be created in write-mode is reported by Close.
+     *--------------------------------------------------------------------------------------
+     */
+    Checkpoint::Checkpoint(string fileName, Mode mode)
+    :m_fileName(fileName),
+    m_tempFileName(fileName + ".tmp"),
+    m_mode(mode),
+    m_failed(false),
+    m_closed(false)
+    {
+        if(IsWriting())
+            m_file = fopen(m_tempFileName.c_str(), "wb");
+        else
+            m_file = fopen(m_fileName.c_str(), "rb");
+
+        if(m_file == NULL)
+        {
+            LogError(cout << "Error: could not open checkpoint-file " << 
+                     (IsWriting() ? m_tempFileName : m_fileName) << endl);
+            if(IsWriting())
+            {
+                m_failed = true;
+                return;
+            }
+            exit(EXIT_FAILURE);
+        }
+
+        char magic[8];
+        memcpy(magic, MAGIC, sizeof(magic));
+        Data(magic, sizeof(magic));
+        
+        if(memcmp(magic, MAGIC, sizeof(magic)))
+        {
+            LogError(cout << "Error: " << m_fileName << " is not a checkpoint-file" << endl);
+            exit(EXIT_FAILURE);
+        }
+        Match(VERSION, "version");
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Checkpoint
+     *      Method:  Checkpoint :: ~Checkpoint
+     * Description:  Closes the file, if Close has not been called
+     *--------------------------------------------------------------------------------------
+     */
+    Checkpoint::~Checkpoint()
+    {
+        Close();
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Checkpoint
+     *      Method:  Checkpoint :: Close
+     * Description:  Closes the file; in write-mode, the temporary file is synced to disk 
+     *               and then replaces the target. Returns false, removing the temporary
+     *               file and leaving any previous checkpoint in place, if writing failed.
+     *--------------------------------------------------------------------------------------
+     */
+    bool Checkpoint::Close()
+    {
+        if(m_closed) return !m_failed;
+        m_closed = true;
+
+        if(m_file)
+        {
+            if(IsWriting() && !m_failed)
+            {
+                if(fflush(m_file) || fsync(fileno(m_file))) m_failed = true;
+            }
+            if(fclose(m_file) && IsWriting()) m_failed = true;
+            m_file = NULL;
+        }
+        
+        if(IsWriting())
+        {
+            if(m_failed || rename(m_tempFileName.c_str(), m_fileName.c_str()))
+            {
+                LogError(cout << "Error: failed to write checkpoint-file " << m_fileName << endl);
+                remove(m_tempFileName.c_str());
+                m_failed = true;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Checkpoint
+     *      Method:  Checkpoint :: Section
+     * Description:  Writes or validates a 4-character section tag
+     *--------------------------------------------------------------------------------------
+     */
+    void Checkpoint::Section(const char *tag)
+    {
+        char buffer[4] = {0};
+        
+        memcpy(buffer, tag, sizeof(buffer));
+        Data(buffer, sizeof(buffer));
+        
+        if(strncmp(buffer, tag, sizeof(buffer))) Mismatch(tag);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Checkpoint
+     *      Method:  Checkpoint :: Data
+     * Description:  Writes or reads raw bytes. Once a write has failed, further writes
+     *               are skipped.
+     *--------------------------------------------------------------------------------------
+     */
+    void Checkpoint::Data(void *data, size_t nBytes)
+    {
+        if(IsWriting())
+        {
+            if(m_failed) return;
+            if(fwrite(data, 1, nBytes, m_file) != nBytes)
+            {
+                LogError(cout << "Error: writing checkpoint-file " << m_fileName << " failed" << endl);
+                m_failed = true;
+            }
+            return;
+        }
+
+        if(fread(data, 1, nBytes, m_file) != nBytes)
+        {
+            LogError(cout << "Error: reading checkpoint-file " << m_fileName << " failed" << endl);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Checkpoint
+     *      Method:  Checkpoint :: String
+     * Description:  Writes or reads a length-prefixed string
+     *--------------------------------------------------------------------------------------
+     */
+    void Checkpoint::String(string &s)
+    {
+        vector<char> buffer(s.begin(), s.end());
+        Array(buffer);
+        if(IsReading()) s.assign(buffer.begin(), buffer.end());
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Checkpoint
+     *      Method:  Checkpoint :: Match
+     * Description:  String variant of Match
+     *--------------------------------------------------------------------------------------
+     */
+    void Checkpoint::Match(string v, const char *what)
+    {
+        string stored = v;
+        String(stored);
+        if(stored != v) Mismatch(what);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  Checkpoint
+     *      Method:  Checkpoint :: Mismatch
+     * Description:  Reports a checkpoint that is inconsistent with the model configuration
+     *--------------------------------------------------------------------------------------
+     */
+    void Checkpoint::Mismatch(const char *what)
+    {
+        LogError(cout << "Error: checkpoint-file " << m_fileName << " is incompatible with the "
+                      << "current configuration (" << what << ")" << endl);
+        exit(EXIT_FAILURE);
+    }
+}}
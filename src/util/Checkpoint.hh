@@ -0,0 +1,121 @@
+/*
+ * =====================================================================================
+ * Scalable PaleoGeomorphology Model (SPGM)
+ *
+ * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * This program is free software; you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
+ * Place, Suite 330, Boston, MA 02111-1307 USA
+ * ===================================================================================== 
+ */
+/*
+ * =====================================================================================
+ *
+ *       Filename:  Checkpoint.hh
+ *
+ *    Description:  Binary checkpoint-file used to save and restore the full model-state
+ *
+ *        Version:  1.0
+ *        Created:  18/10/26 14:12:40
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * =====================================================================================
+ */
+#ifndef SRC_UTIL_CHECKPOINT_HH
+#define SRC_UTIL_CHECKPOINT_HH
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace src { namespace util {
+    using namespace std;
+
+    /*
+     * =====================================================================================
+     *        Class:  Checkpoint
+     *  Description:  Binary file that is either written or read, depending on the mode it
+     *                was opened in. Classes implement a single 'Serialize' method in terms
+     *                of the symmetric Value/Array/Data calls below, which write their 
+     *                arguments in write-mode and overwrite them in read-mode. Sections are 
+     *                tagged so that a checkpoint that does not match the configuration is 
+     *                detected early. Files are written to a temporary file first and 
+     *                renamed on completion, so an interrupted write never replaces a valid
+     *                checkpoint. Write errors are not fatal: they are reported by Close, 
+     *                whereas read errors terminate the run.
+     * =====================================================================================
+     */
+    class Checkpoint
+    {
+        public:
+        typedef enum Mode_t
+        {
+            Checkpoint_Read,
+            Checkpoint_Write
+        }Mode;
+
+        Checkpoint(string fileName, Mode mode);
+        ~Checkpoint();
+
+        /* Closes the file; returns false if a checkpoint could not be completed */
+        bool Close();
+
+        bool IsReading() const { return m_mode == Checkpoint_Read; }
+        bool IsWriting() const { return m_mode == Checkpoint_Write; }
+        string GetFileName() const { return m_fileName; }
+
+        void Section(const char *tag);
+        void Data(void *data, size_t nBytes);
+        void String(string &s);
+
+        template <class T>
+        void Value(T &v)
+        {
+            Data(&v, sizeof(T));
+        }
+
+        /* Fails, in read-mode, if the stored value differs from v */
+        template <class T>
+        void Match(T v, const char *what)
+        {
+            T stored = v;
+            Value(stored);
+            if(!(stored == v)) Mismatch(what);
+        }
+        void Match(string v, const char *what);
+
+        template <class T>
+        void Array(vector<T> &v)
+        {
+            long int n = v.size();
+            Value(n);
+            if(IsReading()) v.resize(n);
+            if(n) Data(&v[0], sizeof(T)*n);
+        }
+        
+        private:
+        string m_fileName;
+        string m_tempFileName;
+        Mode   m_mode;
+        FILE   *m_file;
+        bool   m_failed;        /* Write-mode only: further output is skipped */
+        bool   m_closed;
+
+        void Mismatch(const char *what);
+    };
+}}
+#endif
@@ -43,6 +43,7 @@
 using namespace std;
 
 namespace src { namespace util {
+    class Checkpoint;
 
     /*
      * =====================================================================================
@@ -58,6 +59,9 @@ namespace src { namespace util {
             
         string GetName();
         unsigned int GetLength();
+
+        /* Saves or restores field-values */
+        virtual void Serialize(Checkpoint *cp) = 0;
             
         protected:
         string m_name;
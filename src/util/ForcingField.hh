@@ -0,0 +1,160 @@
+/*
+ * =====================================================================================
+ * Scalable PaleoGeomorphology Model (SPGM)
+ *
+ * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * This program is free software; you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
+ * Place, Suite 330, Boston, MA 02111-1307 USA
+ * ===================================================================================== 
+ */
+/*
+ * =====================================================================================
+ *
+ *       Filename:  ForcingField.hh
+ *
+ *    Description:  Forcing field that is uniform, piecewise-constant over regions or
+ *                  specified at each node
+ *
+ *        Version:  1.0
+ *        Created:  18/10/26 09:12:40
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * =====================================================================================
+ */
+#ifndef SRC_UTIL_FORCING_FIELD_HH
+#define SRC_UTIL_FORCING_FIELD_HH
+
+#include <vector>
+
+namespace src { namespace util {
+    using namespace std;
+
+    /*
+     * =====================================================================================
+     *        Class:  ForcingField
+     *  Description:  Value of a forcing (e.g. precipitation-rate) at each node, stored in
+     *                the most compact of three representations: a single value, one value
+     *                per region along with a region-id for each node, or one value per 
+     *                node. Kernels consuming a forcing-field dispatch on its type and 
+     *                are instantiated with the matching lightweight view below, so that
+     *                a uniform forcing costs neither memory nor indirection.
+     * =====================================================================================
+     */
+    class ForcingField
+    {
+        public:
+        typedef enum ForcingType_t
+        {
+            Forcing_Uniform,
+            Forcing_Piecewise,
+            Forcing_PerNode
+        }ForcingType;
+
+        /*-----------------------------------------------------------------------------
+         * Views
+         *-----------------------------------------------------------------------------*/
+        struct UniformView
+        {
+            double value;
+            inline double operator[](int) const { return value; }
+        };
+
+        struct PiecewiseView
+        {
+            const int *regionIds;
+            const double *regionValues;
+            inline double operator[](int i) const { return regionValues[regionIds[i]]; }
+        };
+
+        struct PerNodeView
+        {
+            const double *values;
+            inline double operator[](int i) const { return values[i]; }
+        };
+
+        ForcingField()
+        :m_type(Forcing_Uniform), m_value(0), m_regionIds(NULL)
+        {}
+
+        inline ForcingType GetType() const { return m_type; }
+
+        inline void SetUniform(double value)
+        {
+            m_type = Forcing_Uniform;
+            m_value = value;
+        }
+
+        /* Region-ids are owned by the caller and are expected to outlive this object */
+        inline vector<double> &SetPiecewise(const vector<int> *regionIds)
+        {
+            m_type = Forcing_Piecewise;
+            m_regionIds = regionIds;
+            return m_values;
+        }
+
+        inline vector<double> &SetPerNode(int nn)
+        {
+            m_type = Forcing_PerNode;
+            m_values.resize(nn);
+            return m_values;
+        }
+
+        inline UniformView GetUniformView() const 
+        { 
+            UniformView v = {m_value}; 
+            return v; 
+        }
+        
+        inline PiecewiseView GetPiecewiseView() const 
+        { 
+            PiecewiseView v = {&(*m_regionIds)[0], &m_values[0]}; 
+            return v; 
+        }
+        
+        inline PerNodeView GetPerNodeView() const 
+        { 
+            PerNodeView v = {&m_values[0]}; 
+            return v; 
+        }
+
+        /* Value at node i, regardless of representation */
+        inline double operator[](int i) const
+        {
+            switch(m_type)
+            {
+                case Forcing_Uniform:   return m_value;
+                case Forcing_Piecewise: return m_values[(*m_regionIds)[i]];
+                default:                return m_values[i];
+            }
+        }
+
+        /* Expands to one value per node */
+        void Expand(int nn, vector<double> *result) const
+        {
+            result->resize(nn);
+            for(int i=0; i<nn; i++) (*result)[i] = (*this)[i];
+        }
+
+        private:
+        ForcingType m_type;
+        double m_value;
+        const vector<int> *m_regionIds;
+        vector<double> m_values;    /* Region-values or node-values */
+    };
+}}
+#endif
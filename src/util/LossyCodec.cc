@@ -0,0 +1,289 @@
+/*
+ * =====================================================================================
+ * Scalable PaleoGeomorphology Model (SPGM)
+ *
+ * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * This program is free software; you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
+ * Place, Suite 330, Boston, MA 02111-1307 USA
+ * ===================================================================================== 
+ */
+/*
+ * =====================================================================================
+ *
+ *       Filename:  LossyCodec.cc
+ *
+ *    Description:  Error-bounded lossy encoding of floating-point arrays
+ *
+ *        Version:  1.0
+ *        Created:  18/10/26 12:30:00
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * =====================================================================================
+ */
+#include <string.h>
+#include <math.h>
+
+#include <LossyCodec.hh>
+
+namespace src { namespace util {
+    using namespace std;
+
+    /*-----------------------------------------------------------------------------
+     * Bit-level writer and reader for Rice codes. Bits are packed LSB-first.
+     *-----------------------------------------------------------------------------*/
+    class BitWriter
+    {
+        public:
+        BitWriter(vector<char> &out):m_out(out), m_buffer(0), m_nBits(0){}
+
+        void Put(unsigned long long bits, int n)
+        {
+            while(n > 0)
+            {
+                int m = (n > 32) ? 32 : n;
+                m_buffer |= (bits & ((1ULL<<m)-1)) << m_nBits;
+                m_nBits += m;
+                bits >>= m;
+                n -= m;
+                while(m_nBits >= 8)
+                {
+                    m_out.push_back((char)(m_buffer & 0xff));
+                    m_buffer >>= 8;
+                    m_nBits -= 8;
+                }
+            }
+        }
+
+        void Align()
+        {
+            if(m_nBits) m_out.push_back((char)(m_buffer & 0xff));
+            m_buffer = 0;
+            m_nBits = 0;
+        }
+
+        private:
+        vector<char> &m_out;
+        unsigned long long m_buffer;
+        int m_nBits;
+    };
+
+    class BitReader
+    {
+        public:
+        BitReader(const unsigned char *data, size_t nBytes):m_data(data), m_nBytes(nBytes), 
+                                                            m_pos(0), m_buffer(0), m_nBits(0){}
+
+        bool Get(int n, unsigned long long *bits)
+        {
+            *bits = 0;
+            int shift = 0;
+            while(n > 0)
+            {
+                if(!m_nBits)
+                {
+                    if(m_pos >= m_nBytes) return false;
+                    m_buffer = m_data[m_pos++];
+                    m_nBits = 8;
+                }
+                int m = (n < m_nBits) ? n : m_nBits;
+                *bits |= (unsigned long long)(m_buffer & ((1u<<m)-1)) << shift;
+                m_buffer >>= m;
+                m_nBits -= m;
+                shift += m;
+                n -= m;
+            }
+            return true;
+        }
+
+        void Align() { m_nBits = 0; }
+        size_t GetPosition() const { return m_pos; }
+        void Skip(size_t n) { m_pos += n; }
+
+        private:
+        const unsigned char *m_data;
+        size_t m_nBytes;
+        size_t m_pos;
+        unsigned int m_buffer;
+        int m_nBits;
+    };
+
+    static inline unsigned long long ZigZag(long long v) { return (v < 0) ? ((unsigned long long)(-(v+1))<<1)|1 : ((unsigned long long)v)<<1; }
+    static inline long long UnZigZag(unsigned long long u) { return (u & 1) ? -(long long)(u>>1)-1 : (long long)(u>>1); }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  LossyCodec
+     *      Method:  LossyCodec :: Encode
+     * Description:  Appends the encoding of 'data' to 'out'
+     *--------------------------------------------------------------------------------------
+     */
+    void LossyCodec::Encode(const float *data, long int nElem, double errorBound, vector<char> &out)
+    {
+        long long count = nElem;
+        double step = 2*errorBound;
+        
+        out.reserve(out.size() + sizeof(count) + sizeof(step) + nElem);
+        out.insert(out.end(), (char*)&count, (char*)&count + sizeof(count));
+        out.insert(out.end(), (char*)&step, (char*)&step + sizeof(step));
+
+        const double maxQuantized = 4503599627370496.; /* 2^52 */
+        vector<unsigned long long> residuals(BLOCK_SIZE);
+        long long previous = 0;
+        BitWriter bw(out);
+
+        for(long int begin=0; begin<nElem; begin+=BLOCK_SIZE)
+        {
+            int len = (nElem-begin < BLOCK_SIZE) ? (int)(nElem-begin) : BLOCK_SIZE;
+            const float *block = data + begin;
+
+            /*-----------------------------------------------------------------------------
+             * Quantize and check that the bound holds after conversion back to float
+             *-----------------------------------------------------------------------------*/
+            bool raw = !(step > 0);
+            long long p = previous;
+            double sum = 0;
+            for(int i=0; (i<len) && !raw; i++)
+            {
+                double q = floor(block[i]/step + 0.5);
+                if(!(fabs(q) < maxQuantized)) { raw = true; break; }
+                
+                long long qi = (long long)q;
+                if(!(fabs((float)(qi*step) - block[i]) <= errorBound)) { raw = true; break; }
+
+                residuals[i] = ZigZag(qi - p);
+                sum += residuals[i];
+                p = qi;
+            }
+
+            if(raw)
+            {
+                bw.Put(RAW, 8);
+                out.insert(out.end(), (const char*)block, (const char*)(block + len));
+                previous = 0;
+                continue;
+            }
+            previous = p;
+
+            /*-----------------------------------------------------------------------------
+             * Pick the Rice-parameter with the shortest code around log2 of the mean
+             *-----------------------------------------------------------------------------*/
+            int k0 = 0;
+            double mean = sum/len;
+            while((k0 < 62) && ((double)(1ULL<<(k0+1)) <= mean)) k0++;
+            
+            int k = k0;
+            unsigned long long bestCost = ~0ULL;
+            for(int kc=((k0>0)?k0-1:0); kc<=k0+1 && kc<=62; kc++)
+            {
+                unsigned long long cost = 0;
+                for(int i=0; i<len; i++)
+                {
+                    unsigned long long quotient = residuals[i] >> kc;
+                    cost += (quotient < ESCAPE) ? quotient + 1 + kc : ESCAPE + 64;
+                }
+                if(cost < bestCost) { bestCost = cost; k = kc; }
+            }
+
+            bw.Put(k, 8);
+            for(int i=0; i<len; i++)
+            {
+                unsigned long long quotient = residuals[i] >> k;
+                if(quotient < ESCAPE)
+                {
+                    bw.Put((1ULL<<quotient)-1, quotient+1);
+                    bw.Put(residuals[i], k);
+                }
+                else
+                {
+                    bw.Put((1ULL<<ESCAPE)-1, ESCAPE);
+                    bw.Put(residuals[i], 64);
+                }
+            }
+            bw.Align();
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  LossyCodec
+     *      Method:  LossyCodec :: Decode
+     * Description:  Decodes an array encoded by Encode. Returns false for malformed input.
+     *--------------------------------------------------------------------------------------
+     */
+    bool LossyCodec::Decode(const char *data, size_t nBytes, vector<float> &out)
+    {
+        long long count = 0;
+        double step = 0;
+        
+        if(nBytes < sizeof(count) + sizeof(step)) return false;
+        memcpy(&count, data, sizeof(count));
+        memcpy(&step, data + sizeof(count), sizeof(step));
+        if(count < 0) return false;
+
+        out.resize(count);
+        
+        const unsigned char *bytes = (const unsigned char*)(data + sizeof(count) + sizeof(step));
+        size_t remaining = nBytes - sizeof(count) - sizeof(step);
+        BitReader br(bytes, remaining);
+        long long previous = 0;
+
+        for(long long begin=0; begin<count; begin+=BLOCK_SIZE)
+        {
+            int len = (count-begin < BLOCK_SIZE) ? (int)(count-begin) : BLOCK_SIZE;
+            unsigned long long k;
+            if(!br.Get(8, &k)) return false;
+
+            if(k == RAW)
+            {
+                size_t pos = br.GetPosition();
+                if(pos + len*sizeof(float) > remaining) return false;
+                
+                memcpy(&out[begin], bytes + pos, len*sizeof(float));
+                br.Skip(len*sizeof(float));
+                previous = 0;
+                continue;
+            }
+
+            for(int i=0; i<len; i++)
+            {
+                unsigned long long quotient = 0, bit = 1, residual;
+                while(quotient < ESCAPE)
+                {
+                    if(!br.Get(1, &bit)) return false;
+                    if(!bit) break;
+                    quotient++;
+                }
+
+                if(quotient < ESCAPE)
+                {
+                    if(!br.Get(k, &residual)) return false;
+                    residual |= quotient << k;
+                }
+                else
+                {
+                    if(!br.Get(64, &residual)) return false;
+                }
+
+                previous += UnZigZag(residual);
+                out[begin+i] = (float)(previous*step);
+            }
+            br.Align();
+        }
+        return true;
+    }
+}}
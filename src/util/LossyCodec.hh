@@ -0,0 +1,75 @@
+/*
+ * =====================================================================================
+ * Scalable PaleoGeomorphology Model (SPGM)
+ *
+ * Copyright (C) 2014 Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * This program is free software; you can redistribute it and/or modify it under 
+ * the terms of the GNU General Public License as published by the Free Software 
+ * Foundation; either version 2 of the License, or (at your option) any later 
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT 
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or 
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for 
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple 
+ * Place, Suite 330, Boston, MA 02111-1307 USA
+ * ===================================================================================== 
+ */
+/*
+ * =====================================================================================
+ *
+ *       Filename:  LossyCodec.hh
+ *
+ *    Description:  Error-bounded lossy encoding of floating-point arrays
+ *
+ *        Version:  1.0
+ *        Created:  18/10/26 12:30:00
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Rakib Hassan (rakib.hassan@sydney.edu.au)
+ *
+ * =====================================================================================
+ */
+#ifndef SRC_UTIL_LOSSY_CODEC_HH
+#define SRC_UTIL_LOSSY_CODEC_HH
+
+#include <stddef.h>
+#include <vector>
+
+namespace src { namespace util {
+    using namespace std;
+
+    /*
+     * =====================================================================================
+     *        Class:  LossyCodec
+     *  Description:  Encodes float-arrays such that each decoded value lies within a given
+     *                absolute error-bound of the original. Values are quantized to 
+     *                multiples of twice the error-bound, delta-encoded along the array and
+     *                entropy-coded in blocks with Golomb-Rice codes, the parameter of which
+     *                is chosen per block. Blocks in which the bound cannot be honoured 
+     *                (non-finite values, or values beyond float-precision at the given
+     *                bound) are stored verbatim. The encoding is self-contained:
+     *
+     *                Int64 count, Float64 step, followed by blocks of BLOCK_SIZE values,
+     *                each prefixed by a UInt8 Rice-parameter (RAW for verbatim blocks) 
+     *                and padded to a whole number of bytes.
+     * =====================================================================================
+     */
+    class LossyCodec
+    {
+        public:
+        static void Encode(const float *data, long int nElem, double errorBound, vector<char> &out);
+        static bool Decode(const char *data, size_t nBytes, vector<float> &out);
+
+        private:
+        static const int BLOCK_SIZE = 256;
+        static const int RAW = 255;
+        static const int ESCAPE = 32;   /* Quotients >= ESCAPE are followed by the raw value */
+    };
+}}
+#endif
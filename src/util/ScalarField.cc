@@ -36,6 +36,7 @@
  * =====================================================================================
  */
 #include <ScalarField.hh>
+#include <Checkpoint.hh>
 #include <string.h>
 
 using namespace std;
@@ -69,6 +70,20 @@ namespace src { namespace util {
         delete [] m_data;
     }
     
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  ScalarField
+     *      Method:  ScalarField :: Serialize
+     * Description:  Saves or restores field-values
+     *--------------------------------------------------------------------------------------
+     */
+    template <class T>
+    void ScalarField<T>::Serialize(Checkpoint *cp)
+    {
+        cp->Match(m_length, m_name.c_str());
+        cp->Data(m_data, sizeof(T)*m_length);
+    }
+    
     template class src::util::ScalarField<float>;
 }
 }
@@ -62,6 +62,8 @@ namespace src { namespace util {
             return m_data[index];
         }
             
+        void Serialize(Checkpoint *cp);
+
         private:
         T *m_data;
     };
@@ -35,10 +35,17 @@
  *
  * =====================================================================================
  */
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+
 #include <TimeSeries.hh>
 #include <Model.hh>
 #include <SurfaceTopology.hh>
 #include <Log.hh>
+#include <Checkpoint.hh>
 
 namespace src { namespace util {
     using namespace std;
@@ -58,35 +65,153 @@ namespace src { namespace util {
         m_isSingleValued    = false;
         m_isTimeSeries      = false;
         m_isFieldTimeSeries = false;
+        m_prefetching       = false;
+        m_prefetchIdx       = -1;
+        m_raster            = NULL;
         /*-----------------------------------------------------------------------------
          * Read parameters
          *-----------------------------------------------------------------------------*/
-        m_value = m_config->PDouble(m_paramName);
         m_file  = m_config->PString(m_paramName);
+        m_prefetch    = m_config->PBool("prefetchFieldFiles", true);
+        m_binaryCache = m_config->PBool("cacheFieldFiles", false);
+        
+        string interpolation = m_config->PString(m_paramName + "Interpolation", "bilinear");
+        if((interpolation != "bilinear") && (interpolation != "bicubic"))
+        {
+            LogError(cout << "Unknown interpolation for " << m_paramName << ": " << interpolation << endl);
+            exit(EXIT_FAILURE);
+        }
+        m_rasterBicubic = (interpolation == "bicubic");
         
         const SurfaceTopology *st = m_model->GetSurfaceTopology();
         int nn = st->GetNMeshPoints();
+        m_nMeshPoints = nn;
+
+        /*-----------------------------------------------------------------------------
+         * Read regions, if values are specified per region
+         *-----------------------------------------------------------------------------*/
+        m_nColumns = 1;
+        if(m_config->HasSymbol(m_paramName + "Regions"))
+        {
+            ReadRegions(m_config->PString(m_paramName + "Regions"));
+        }
 
         /*-----------------------------------------------------------------------------
          * Check if single-valued
          *-----------------------------------------------------------------------------*/
-        double dummy;
-        m_isSingleValued = (sscanf(m_file.c_str(), "%lf", &dummy)==1);
+        m_isSingleValued = ParseValues(m_file.c_str(), &m_constants);
 
-        if(!m_isSingleValued)
+        if(m_isSingleValued)
+        {
+            if(int(m_constants.size()) != m_nColumns)
+            {
+                LogError(cout << "Parameter " << m_paramName << " must have " << m_nColumns << " value(s).." << endl);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else
         {
             AscertainTimeSeriesType();
+            m_constants.resize(m_nColumns);
 
             if(m_times.size()<2)
             {
                 LogError(cout << "File: " << m_file << " must have atleast 2 entries.." << endl);
                 exit(EXIT_FAILURE);
             }
+
+            if(m_isFieldTimeSeries && m_regionIds.size())
+            {
+                LogError(cout << "Regions are not applicable to field time-series: " << m_paramName << endl);
+                exit(EXIT_FAILURE);
+            }
         }
         
         m_idxLo = 0;
-        m_fieldValueLo.resize(nn);
-        m_fieldValueHi.resize(nn);
+        if(m_isFieldTimeSeries)
+        {
+            m_fieldValueLo.resize(nn);
+            m_fieldValueHi.resize(nn);
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  TimeSeries
+     *      Method:  TimeSeries :: ParseValues
+     * Description:  Parses whitespace-separated numbers. Returns false if the buffer 
+     *               contains anything other than numbers.
+     *--------------------------------------------------------------------------------------
+     */
+    bool TimeSeries::ParseValues(const char *buffer, vector<double> *values)
+    {
+        values->clear();
+        
+        const char *p = buffer;
+        while(true)
+        {
+            while(isspace(*p)) p++;
+            if(*p == 0) break;
+
+            char *end = NULL;
+            double v = strtod(p, &end);
+            if((end == p) || !(isspace(*end) || (*end == 0))) return false;
+
+            values->push_back(v);
+            p = end;
+        }
+
+        return (values->size() > 0);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  TimeSeries
+     *      Method:  TimeSeries :: ReadRegions
+     * Description:  Reads a region-file, containing the number of nodes followed by a 
+     *               region-id (0, 1, ...) for each node
+     *--------------------------------------------------------------------------------------
+     */
+    void TimeSeries::ReadRegions(string fn)
+    {
+        const SurfaceTopology *st = m_model->GetSurfaceTopology();
+        int nn = st->GetNMeshPoints();
+        
+        ifstream ifs;
+        string line;
+
+        ifs.open(fn.c_str());
+        if(!ifs.is_open())
+        {
+            LogError(cout << "Error: region file " << fn << " could not be opened.." << endl);
+            exit(EXIT_FAILURE);
+        }
+        
+        getline(ifs, line);
+        if(atoi(line.c_str()) != nn)
+        {
+            LogError(cout << "Incompatible input - number of nodes do not match.." << endl);
+            exit(EXIT_FAILURE);
+        }
+        
+        m_regionIds.resize(nn);
+        int maxId = -1;
+        for(int i=0; i<nn; i++)
+        {
+            int id = -1;
+            if(!getline(ifs, line) || (sscanf(line.c_str(), "%d", &id) != 1) || (id < 0))
+            {
+                LogError(cout << "Error: invalid region-id on line " << i+2 << " of " << fn << endl);
+                exit(EXIT_FAILURE);
+            }
+
+            /* Region-ids are stored in the current node-order */
+            m_regionIds[st->O(i)] = id;
+            maxId = max(maxId, id);
+        }
+        ifs.close();
+
+        m_nColumns = maxId + 1;
     }
 
     /*
@@ -152,15 +277,24 @@ namespace src { namespace util {
 
             while(fgets(buffer, sizeof(buffer), f) != NULL)
             {
-                float t, value;
+                float t;
                 char fn[2048] = {0};
                 
                 if(m_isTimeSeries)
                 {
-                    assert(sscanf(buffer, "%f %f", &t, &value) == 2);
+                    /* Time, followed by a value for each region */
+                    vector<double> row;
+                    ParseValues(buffer, &row);
+
+                    if(int(row.size()) != (m_nColumns+1))
+                    {
+                        LogError(cout << "Error in time-series file format: expected " << m_nColumns 
+                                      << " value(s) per line in " << m_file << endl);
+                        exit(EXIT_FAILURE);
+                    }
     
-                    m_times.push_back(t);
-                    m_values.push_back(value);
+                    m_times.push_back(row[0]);
+                    for(int i=1; i<=m_nColumns; i++) m_values.push_back(row[i]);
                 }
                 else if(m_isFieldTimeSeries)
                 {
@@ -188,68 +322,421 @@ namespace src { namespace util {
         
         int nn = st->GetNMeshPoints();
         
-        if(m_isTimeSeries)
+        if(m_isFieldTimeSeries)
         {
-            result->resize(nn);
+            ReadFieldFile(m_fieldValueFilesAtTimes[idx], nn, result);
+        }
+        else
+        {
+            LogError(cout << "Logical error.." << endl);
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  TimeSeries
+     *      Method:  TimeSeries :: ReadFieldFile
+     * Description:  Reads a text field file, containing the number of nodes followed by a 
+     *               value for each node, or its binary sidecar if caching is enabled. 
+     *               Rasters are read by ReadRasterFile. Also called from the prefetch 
+     *               thread.
+     *--------------------------------------------------------------------------------------
+     */
+    void TimeSeries::ReadFieldFile(string fn, int nn, vector<double> *result)
+    {
+        if(IsRasterFile(fn)) 
+        {
+            ReadRasterFile(fn, nn, result);
+            return;
+        }
+
+        if(m_binaryCache && ReadBinaryCache(fn, nn, result)) return;
+
+        ifstream ifs;
+        string line;
+
+        ifs.open(fn.c_str());
+        if(!ifs.is_open())
+        {
+            LogError(cout << "Error: field file " << fn << " could not be opened.." << endl);
+            exit(EXIT_FAILURE);
+        }
+        
+        /* Get number of mesh points */
+        getline(ifs, line);
+        int nitems = atoi(line.c_str());
+
+        if(nitems != nn)
+        {
+            LogError(cout << "Incompatible input - number of nodes do not match.." << endl);
+            exit(EXIT_FAILURE);
+        }
+        
+        result->resize(nn);
+
+        int i = 0;
+        while(getline(ifs, line) && (i < nn))
+        {
+            double ur = 0;
+
+            sscanf(line.c_str(), "%lf", &ur);
             
-            for(int i=0; i<nn; i++)
-            {
-                (*result)[i++] = m_values[idx];
-            }            
+            (*result)[i++] = ur;
         }
-        else if(m_isFieldTimeSeries)
+        ifs.close();
+
+        if(m_binaryCache) WriteBinaryCache(fn, *result);
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  TimeSeries
+     *      Method:  TimeSeries :: IsRasterFile
+     * Description:  Field files with extensions .asc (ESRI ascii grid) or .flt (ESRI 
+     *               binary grid, with an accompanying .hdr file) are rasters
+     *--------------------------------------------------------------------------------------
+     */
+    bool TimeSeries::IsRasterFile(string fn)
+    {
+        if(fn.size() < 4) return false;
+
+        string ext = fn.substr(fn.size()-4);
+        return (ext == ".asc") || (ext == ".flt");
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  TimeSeries
+     *      Method:  TimeSeries :: ReadRasterFile
+     * Description:  Reads a raster and interpolates it onto mesh-nodes, in the order of 
+     *               text field files. The header contains ncols, nrows, xllcorner (or 
+     *               xllcenter), yllcorner (or yllcenter), cellsize and optionally 
+     *               NODATA_value and, for .flt files, byteorder. Rows are stored from 
+     *               north to south. Cells without data contribute 0.
+     *--------------------------------------------------------------------------------------
+     */
+    void TimeSeries::ReadRasterFile(string fn, int nn, vector<double> *result)
+    {
+        bool binary = (fn.substr(fn.size()-4) == ".flt");
+        string headerName = binary ? fn.substr(0, fn.size()-4) + ".hdr" : fn;
+
+        FILE *f = fopen(headerName.c_str(), "r");
+        if(f==NULL)
+        {
+            LogError(cout << "Error: raster file " << headerName << " could not be opened.." << endl);
+            exit(EXIT_FAILURE);
+        }
+
+        /*-----------------------------------------------------------------------------
+         * Read header
+         *-----------------------------------------------------------------------------*/
+        int ncols = 0, nrows = 0;
+        double xll = 0, yll = 0, cellSize = 0, noData = -9999;
+        bool xCorner = true, yCorner = true, msbFirst = false;
+        char buffer[1024] = {0};
+        long dataStart = 0;
+        
+        while(true)
+        {
+            dataStart = ftell(f);
+            if(fgets(buffer, sizeof(buffer), f) == NULL) break;
+
+            char key[256] = {0}, value[256] = {0};
+            if(sscanf(buffer, "%255s %255s", key, value) < 1) continue;
+            for(char *c=key; *c; c++) *c = tolower(*c);
+
+            if(!strcmp(key, "ncols"))                   ncols = atoi(value);
+            else if(!strcmp(key, "nrows"))              nrows = atoi(value);
+            else if(!strcmp(key, "xllcorner"))          { xll = atof(value); xCorner = true; }
+            else if(!strcmp(key, "xllcenter"))          { xll = atof(value); xCorner = false; }
+            else if(!strcmp(key, "yllcorner"))          { yll = atof(value); yCorner = true; }
+            else if(!strcmp(key, "yllcenter"))          { yll = atof(value); yCorner = false; }
+            else if(!strcmp(key, "cellsize"))           cellSize = atof(value);
+            else if(!strcmp(key, "nodata_value"))       noData = atof(value);
+            else if(!strcmp(key, "byteorder"))          msbFirst = (toupper(value[0]) == 'M');
+            else if(!binary) break; /* Start of data */
+        }
+
+        if((ncols < 2) || (nrows < 2) || (cellSize <= 0))
         {
-            ifstream ifs;
-            string line;
+            fclose(f);
+            LogError(cout << "Error: invalid raster header in " << headerName << endl);
+            exit(EXIT_FAILURE);
+        }
 
-            ifs.open(m_fieldValueFilesAtTimes[idx].c_str());
-            if(!ifs.is_open())
+        /*-----------------------------------------------------------------------------
+         * Read values, row by row from the north
+         *-----------------------------------------------------------------------------*/
+        vector<float> values(ncols*nrows);
+        bool complete = true;
+        if(binary)
+        {
+            fclose(f);
+            f = fopen(fn.c_str(), "rb");
+            complete = (f != NULL) && 
+                       (fread(&values[0], sizeof(float), values.size(), f) == values.size());
+            
+            int one = 1;
+            bool hostMSBFirst = (*(char*)&one == 0);
+            if(complete && (msbFirst != hostMSBFirst))
             {
-                LogError(cout << "Error: field file " << m_fieldValueFilesAtTimes[idx] << " could not be opened.." << endl);
-                exit(EXIT_FAILURE);
+                for(size_t i=0; i<values.size(); i++)
+                {
+                    char *b = (char*)&values[i];
+                    swap(b[0], b[3]);
+                    swap(b[1], b[2]);
+                }
             }
-            
-            /* Get number of mesh points */
-            getline(ifs, line);
-            int nitems = atoi(line.c_str());
-
-            if(nitems != nn)
+        }
+        else
+        {
+            fseek(f, dataStart, SEEK_SET);
+            for(size_t i=0; complete && (i<values.size()); i++)
             {
-                LogError(cout << "Incompatible input - number of nodes do not match.." << endl);
-                exit(EXIT_FAILURE);
+                complete = (fscanf(f, "%f", &values[i]) == 1);
             }
+        }
+        if(f) fclose(f);
+
+        if(!complete)
+        {
+            LogError(cout << "Error: raster file " << fn << " has fewer than " << values.size() << " values.." << endl);
+            exit(EXIT_FAILURE);
+        }
+
+        /*-----------------------------------------------------------------------------
+         * (Re)build interpolation weights if the raster geometry has changed
+         *-----------------------------------------------------------------------------*/
+        double x0 = xll + (xCorner ? 0.5*cellSize : 0);
+        double y0 = yll + (yCorner ? 0.5*cellSize : 0);
+        double geometry[5] = {double(ncols), double(nrows), x0, y0, cellSize};
+
+        if((m_raster == NULL) || memcmp(geometry, m_rasterGeometry, sizeof(geometry)))
+        {
+            const SurfaceTopology *st = m_model->GetSurfaceTopology();
+            float lower[2] = {float(x0), float(y0)};
+            float upper[2] = {float(x0 + (ncols-1)*cellSize), float(y0 + (nrows-1)*cellSize)};
             
-            result->resize(nn);
+            delete m_raster;
+            m_raster = new RegularMesh(ncols, nrows, upper, lower);
+            memcpy(m_rasterGeometry, geometry, sizeof(geometry));
 
-            int i = 0;
-            while(getline(ifs, line))
+            /* Node-coordinates, in the order of text field files */
+            vector<float> xy(2*nn);
+            vector<float*> coor(nn);
+            for(int i=0; i<nn; i++)
             {
-                double ur = 0;
+                xy[2*i]   = st->X(st->O(i));
+                xy[2*i+1] = st->Y(st->O(i));
+                coor[i]   = &xy[2*i];
+            }
 
-                sscanf(line.c_str(), "%lf", &ur);
-                
-                (*result)[i++] = ur;
+            m_raster->BuildInterpolationWeights(nn, &coor[0], m_rasterBicubic ? 
+                                                RegularMesh::Interpolation_Bicubic :
+                                                RegularMesh::Interpolation_Bilinear);
+        }
+
+        for(int r=0; r<nrows; r++)
+        {
+            for(int c=0; c<ncols; c++)
+            {
+                float v = values[r*ncols + c];
+                m_raster->V(c, nrows-1-r) = (v == noData) ? 0. : v;
             }
-            ifs.close();
         }
-        else
+
+        m_raster->ApplyInterpolationWeights(result);
+    }
+
+    /*-----------------------------------------------------------------------------
+     * Binary sidecar layout: magic, node-count, size and modification time of the 
+     * text file, followed by node-count doubles.
+     *-----------------------------------------------------------------------------*/
+    static const char SIDECAR_MAGIC[8] = {'S','P','G','M','F','L','D','1'};
+
+    struct SidecarHeader
+    {
+        char magic[8];
+        long long nn;
+        long long sourceSize;
+        long long sourceMTime;
+    };
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  TimeSeries
+     *      Method:  TimeSeries :: ReadBinaryCache
+     * Description:  Reads the binary sidecar of a field file. Returns false if the sidecar
+     *               does not exist or is stale, in which case the text file is read.
+     *--------------------------------------------------------------------------------------
+     */
+    bool TimeSeries::ReadBinaryCache(string fn, int nn, vector<double> *result)
+    {
+        struct stat sb;
+        if(stat(fn.c_str(), &sb) != 0) return false;
+
+        string cacheName = fn + ".bin";
+        FILE *f = fopen(cacheName.c_str(), "rb");
+        if(f==NULL) return false;
+
+        SidecarHeader h;
+        bool valid = (fread(&h, sizeof(h), 1, f) == 1) &&
+                     (memcmp(h.magic, SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC)) == 0) &&
+                     (h.sourceSize == (long long)sb.st_size) &&
+                     (h.sourceMTime == (long long)sb.st_mtime);
+        
+        if(valid && (h.nn != nn))
         {
-            LogError(cout << "Logical error.." << endl);
+            fclose(f);
+            LogError(cout << "Incompatible input - number of nodes do not match.." << endl);
             exit(EXIT_FAILURE);
         }
+
+        if(valid)
+        {
+            result->resize(nn);
+            valid = (fread(&(*result)[0], sizeof(double), nn, f) == size_t(nn));
+        }
+        fclose(f);
+        
+        return valid;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  TimeSeries
+     *      Method:  TimeSeries :: WriteBinaryCache
+     * Description:  Writes the binary sidecar of a field file. The sidecar is written to a
+     *               temporary file first, so that concurrent or interrupted runs never see
+     *               a partially written sidecar. Failure to write is not fatal.
+     *--------------------------------------------------------------------------------------
+     */
+    void TimeSeries::WriteBinaryCache(string fn, const vector<double> &values)
+    {
+        struct stat sb;
+        if(stat(fn.c_str(), &sb) != 0) return;
+
+        SidecarHeader h;
+        memcpy(h.magic, SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC));
+        h.nn          = values.size();
+        h.sourceSize  = sb.st_size;
+        h.sourceMTime = sb.st_mtime;
+
+        string cacheName = fn + ".bin";
+        string tmpName   = cacheName + ".tmp";
+        FILE *f = fopen(tmpName.c_str(), "wb");
+        bool written = (f != NULL);
+
+        if(f)
+        {
+            written = (fwrite(&h, sizeof(h), 1, f) == 1) &&
+                      (fwrite(&values[0], sizeof(double), values.size(), f) == values.size());
+            written = (fclose(f) == 0) && written;
+        }
+        
+        if(!written || (rename(tmpName.c_str(), cacheName.c_str()) != 0))
+        {
+            remove(tmpName.c_str());
+            cerr << "Warning: could not write field-file cache " << cacheName << ".." << endl;
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  TimeSeries
+     *      Method:  TimeSeries :: PrefetchThread
+     * Description:  Entry point of the prefetch thread
+     *--------------------------------------------------------------------------------------
+     */
+    void *TimeSeries::PrefetchThread(void *arg)
+    {
+        TimeSeries *ts = (TimeSeries*) arg;
+        
+        ts->ReadFieldFile(ts->m_fieldValueFilesAtTimes[ts->m_prefetchIdx], 
+                          ts->m_nMeshPoints, &ts->m_prefetchBuffer);
+        return NULL;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  TimeSeries
+     *      Method:  TimeSeries :: RequestPrefetch
+     * Description:  Starts reading the field file at the given index in the background. 
+     *               Falls back to synchronous reads if a thread cannot be started.
+     *--------------------------------------------------------------------------------------
+     */
+    void TimeSeries::RequestPrefetch(int idx)
+    {
+        if(!m_prefetch || !m_isFieldTimeSeries) return;
+        if(idx >= int(m_fieldValueFilesAtTimes.size())) return;
+        
+        if(m_prefetching)
+        {
+            if(m_prefetchIdx == idx) return;
+            pthread_join(m_prefetchThread, NULL);
+            m_prefetching = false;
+        }
+
+        m_prefetchIdx = idx;
+        if(pthread_create(&m_prefetchThread, NULL, PrefetchThread, this) == 0)
+        {
+            m_prefetching = true;
+        }
+        else
+        {
+            cerr << "Warning: could not start prefetch thread; reading field files synchronously.." << endl;
+            m_prefetch = false;
+        }
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  TimeSeries
+     *      Method:  TimeSeries :: TakePrefetched
+     * Description:  Waits for a pending prefetch and hands over its values if they 
+     *               correspond to the given index.
+     *--------------------------------------------------------------------------------------
+     */
+    bool TimeSeries::TakePrefetched(int idx, vector<double> *result)
+    {
+        if(!m_prefetching) return false;
+        
+        pthread_join(m_prefetchThread, NULL);
+        m_prefetching = false;
+
+        if(m_prefetchIdx != idx) return false;
+
+        result->swap(m_prefetchBuffer);
+        return true;
+    }
+
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  TimeSeries
+     *      Method:  TimeSeries :: LoadFieldValue
+     * Description:  Returns field values at the given index, from the prefetch buffer if
+     *               available
+     *--------------------------------------------------------------------------------------
+     */
+    void TimeSeries::LoadFieldValue(int idx, vector<double> *result)
+    {
+        if(TakePrefetched(idx, result)) return;
+
+        GetFieldValueAtTime(idx, result);
     }
     
     /*
      *--------------------------------------------------------------------------------------
      *       Class:  TimeSeries
-     *      Method:  TimeSeries :: GetCurrentFieldValue
-     * Description:  Returns field values at node points. Note that a 2D field is returned
-     *               even though the input in the parameter file may be a single scalar 
-     *               value or a 1D time series - in such cases the returned 2D field is 
-     *               constant-valued across the entire domain.
+     *      Method:  TimeSeries :: GetCurrentField
+     * Description:  Returns the current forcing-field. A single scalar value or a 1D 
+     *               time-series yields a uniform field, or a piecewise-constant field if
+     *               values are specified per region; a field time-series yields values at
+     *               each node.
      *--------------------------------------------------------------------------------------
      */
-    void TimeSeries::GetCurrentFieldValue(vector<double> *result)
+    void TimeSeries::GetCurrentField(ForcingField *result)
     {
         const SurfaceTopology *st = m_model->GetSurfaceTopology();
         float mt = m_model->GetTime();
@@ -258,26 +745,18 @@ namespace src { namespace util {
         int nn = st->GetNMeshPoints();
         
         /*-----------------------------------------------------------------------------
-         * Single-valued 
+         * 1D or 2D time series: locate the interval bracketing model-time
          *-----------------------------------------------------------------------------*/
-        if(m_isSingleValued)
-        {
-            result->resize(nn);
-            
-            for(int i=0; i<nn; i++)
-            {
-                (*result)[i] = m_value;
-            }     
-        }
-        /*-----------------------------------------------------------------------------
-         * 1D or 2D time series 
-         *-----------------------------------------------------------------------------*/
-        else
+        if(!m_isSingleValued)
         {
             if(mt == dt)
             {
-                GetFieldValueAtTime(m_idxLo, &m_fieldValueLo);
-                GetFieldValueAtTime(m_idxLo+1, &m_fieldValueHi);
+                if(m_isFieldTimeSeries)
+                {
+                    LoadFieldValue(m_idxLo, &m_fieldValueLo);
+                    LoadFieldValue(m_idxLo+1, &m_fieldValueHi);
+                    RequestPrefetch(m_idxLo+2);
+                }
             }
             else if(mt > m_times[m_idxLo+1])
             {
@@ -288,10 +767,16 @@ namespace src { namespace util {
                     m_idxLo++;
                 }
                 
-                if(prevIdxLo != m_idxLo)
+                if((prevIdxLo != m_idxLo) && m_isFieldTimeSeries)
                 {
-                    GetFieldValueAtTime(m_idxLo, &m_fieldValueLo);
-                    GetFieldValueAtTime(m_idxLo+1, &m_fieldValueHi);
+                    /* Hi becomes the next Lo when advancing by a single interval */
+                    if(m_idxLo == prevIdxLo+1) 
+                        m_fieldValueLo.swap(m_fieldValueHi);
+                    else
+                        LoadFieldValue(m_idxLo, &m_fieldValueLo);
+                    
+                    LoadFieldValue(m_idxLo+1, &m_fieldValueHi);
+                    RequestPrefetch(m_idxLo+2);
                 }
                 else
                 {
@@ -301,36 +786,95 @@ namespace src { namespace util {
                      *-----------------------------------------------------------------------------*/
                 }
             }
+        }
 
-            result->resize(nn);
-            
-            if(mt < m_times[m_idxLo])
-            {
-                /* Return 0 */
-                for(int i=0; i<nn; i++) (*result)[i] = 0;
-            }
-            else if(mt > m_times[m_idxLo+1])
+        /*-----------------------------------------------------------------------------
+         * Single-valued or 1D time series: current value(s) are held in m_constants
+         *-----------------------------------------------------------------------------*/
+        if(!m_isFieldTimeSeries)
+        {
+            if(m_isTimeSeries)
             {
-                /* Return last available value */
-                for(int i=0; i<nn; i++) (*result)[st->O(i)] = m_fieldValueHi[i];
+                const float *lo = &m_values[m_idxLo*m_nColumns];
+                const float *hi = &m_values[(m_idxLo+1)*m_nColumns];
+
+                if(mt < m_times[m_idxLo])
+                {
+                    /* Return 0 */
+                    for(int j=0; j<m_nColumns; j++) m_constants[j] = 0;
+                }
+                else if(mt > m_times[m_idxLo+1])
+                {
+                    /* Return last available value */
+                    for(int j=0; j<m_nColumns; j++) m_constants[j] = hi[j];
+                }
+                else
+                {
+                    float f = (mt - m_times[m_idxLo]) / 
+                              (m_times[m_idxLo+1] - m_times[m_idxLo]);
+                    
+                    for(int j=0; j<m_nColumns; j++) m_constants[j] = (f*lo[j] + (1.-f)*hi[j]);
+                }
             }
+
+            if(m_regionIds.size()) 
+                result->SetPiecewise(&m_regionIds) = m_constants;
             else
-            /*-----------------------------------------------------------------------------
-             * Return result after linear interpolation
-             *-----------------------------------------------------------------------------*/
+                result->SetUniform(m_constants[0]);
+
+            return;
+        }
+
+        /*-----------------------------------------------------------------------------
+         * Field time series
+         *-----------------------------------------------------------------------------*/
+        vector<double> &values = result->SetPerNode(nn);
+        
+        if(mt < m_times[m_idxLo])
+        {
+            /* Return 0 */
+            for(int i=0; i<nn; i++) values[i] = 0;
+        }
+        else if(mt > m_times[m_idxLo+1])
+        {
+            /* Return last available value */
+            for(int i=0; i<nn; i++) values[st->O(i)] = m_fieldValueHi[i];
+        }
+        else
+        /*-----------------------------------------------------------------------------
+         * Return result after linear interpolation
+         *-----------------------------------------------------------------------------*/
+        {
+            float f = (mt - m_times[m_idxLo]) / 
+                      (m_times[m_idxLo+1] - m_times[m_idxLo]);
+            
+            if(f>1.) exit(EXIT_FAILURE);
+            for(int i=0; i<nn; i++)
             {
-                float f = (mt - m_times[m_idxLo]) / 
-                          (m_times[m_idxLo+1] - m_times[m_idxLo]);
-                
-                if(f>1.) exit(EXIT_FAILURE);
-                for(int i=0; i<nn; i++)
-                {
-                    (*result)[st->O(i)] = (f*m_fieldValueLo[i] + (1.-f)*m_fieldValueHi[i]);
-                }
+                values[st->O(i)] = (f*m_fieldValueLo[i] + (1.-f)*m_fieldValueHi[i]);
             }
         }
     }
     
+    /*
+     *--------------------------------------------------------------------------------------
+     *       Class:  TimeSeries
+     *      Method:  TimeSeries :: Serialize
+     * Description:  Saves or restores the position within the time-series along with the 
+     *               bracketing field values, so that field files need not be re-read.
+     *--------------------------------------------------------------------------------------
+     */
+    void TimeSeries::Serialize(Checkpoint *cp)
+    {
+        cp->Section("TSER");
+        cp->Match(m_paramName, m_paramName.c_str());
+        cp->Value(m_idxLo);
+        cp->Array(m_fieldValueLo);
+        cp->Array(m_fieldValueHi);
+
+        if(cp->IsReading()) RequestPrefetch(m_idxLo+2);
+    }
+
     /*
      *--------------------------------------------------------------------------------------
      *       Class:  TimeSeries
@@ -338,6 +882,10 @@ namespace src { namespace util {
      * Description:  Destructor
      *--------------------------------------------------------------------------------------
      */
-    TimeSeries::~TimeSeries(){}
+    TimeSeries::~TimeSeries()
+    {
+        if(m_prefetching) pthread_join(m_prefetchThread, NULL);
+        delete m_raster;
+    }
 }}
 
@@ -39,7 +39,9 @@
 #define SRC_UTIL_TIMESERIES_HH
 
 #include <ctime>
+#include <pthread.h>
 #include <Config.hh>
+#include <ForcingField.hh>
 
 #include <vector>
 
@@ -47,11 +49,20 @@ namespace src { namespace model {
     class Model;
 }}    
 
+namespace src { namespace mesh {
+    class RegularMesh;
+}}    
+
+namespace src { namespace util {
+    class Checkpoint;
+}}
+
 namespace src { namespace util {
     using namespace std;
     using namespace src::util;
     using namespace src::parser;
     using namespace src::model;
+    using src::mesh::RegularMesh;
     
     /*
      * =====================================================================================
@@ -61,6 +72,10 @@ namespace src { namespace util {
      *                (iii) 2D time-series specified as a file containing (time, fieldFile) 
      *                      pairs, where fieldFile contains values at each node point in the
      *                      computational mesh.
+     *                If a region-file (<paramName>Regions) is given, (i) and (ii) specify
+     *                one value per region instead. Field files in (iii) can also be 
+     *                regular-grid rasters (ESRI .asc or .flt/.hdr), which are interpolated
+     *                onto the mesh.
      * =====================================================================================
      */
     class TimeSeries
@@ -68,21 +83,27 @@ namespace src { namespace util {
         public:
         TimeSeries(const Model *m, Config *c, string paramName);
         ~TimeSeries();
-        void GetCurrentFieldValue(vector<double> *result);
+        void GetCurrentField(ForcingField *result);
+        void Serialize(Checkpoint *cp);
         
         private:
         void GetFieldValueAtTime(int idx, vector<double> *result);
-        void ReadFieldFile(string fn, vector<double> *result);
+        void ReadFieldFile(string fn, int nn, vector<double> *result);
         void AscertainTimeSeriesType();
+        void ReadRegions(string fn);
+        bool ParseValues(const char *buffer, vector<double> *values);
+        void LoadFieldValue(int idx, vector<double> *result);
 
         const Model *m_model;
         Config *m_config;
         string m_paramName;
 
-        double m_value;
         string m_file;
+        vector<double> m_constants;     /* Current value, or one per region (1D and single-valued) */
         vector<float> m_times;
-        vector<float> m_values;
+        vector<float> m_values;         /* m_nColumns values per time */
+        vector<int> m_regionIds;
+        int m_nColumns;
         vector<string> m_fieldValueFilesAtTimes;
 
         vector<double> m_fieldValueLo;
@@ -92,6 +113,39 @@ namespace src { namespace util {
         bool m_isSingleValued;
         bool m_isTimeSeries;
         bool m_isFieldTimeSeries;
+
+        /*-----------------------------------------------------------------------------
+         * The field file for the next interval is read on a background thread while 
+         * the current interval is being used. Text field files can optionally be 
+         * converted to binary sidecar files (<fieldFile>.bin) on first use; a 
+         * sidecar is only used if it records the size and modification time of the
+         * text file it was converted from.
+         *-----------------------------------------------------------------------------*/
+        bool m_prefetch;
+        bool m_binaryCache;
+        bool m_prefetching;
+        int  m_prefetchIdx;
+        int  m_nMeshPoints;
+        vector<double> m_prefetchBuffer;
+        pthread_t m_prefetchThread;
+
+        void RequestPrefetch(int idx);
+        bool TakePrefetched(int idx, vector<double> *result);
+        static void *PrefetchThread(void *arg);
+        bool ReadBinaryCache(string fn, int nn, vector<double> *result);
+        void WriteBinaryCache(string fn, const vector<double> &values);
+
+        /*-----------------------------------------------------------------------------
+         * Raster field files. Interpolation weights (<paramName>Interpolation: 
+         * bilinear or bicubic) are computed for the first raster and reused for 
+         * subsequent rasters with the same geometry (ncols, nrows, origin, cellsize).
+         *-----------------------------------------------------------------------------*/
+        RegularMesh *m_raster;
+        double m_rasterGeometry[5];
+        bool m_rasterBicubic;
+
+        bool IsRasterFile(string fn);
+        void ReadRasterFile(string fn, int nn, vector<double> *result);
     };
 }}
 